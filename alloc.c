@@ -0,0 +1,282 @@
+#include "alloc.h"
+
+// arena that allocations on this thread are served from, if any
+static __declspec(thread) Arena* arena;
+
+#ifdef ALLOC_STATS
+// per-thread so that the processing thread's ticks aren't polluted by
+// the GUI thread fetching channels
+static __declspec(thread) AllocStats stats;
+
+/**
+ * Count an allocation of bytes from site.
+ */
+static void count(size_t bytes, enum allocSite site) {
+	stats.sites[site].allocs++;
+	stats.sites[site].bytes += bytes;
+	stats.tick.allocs++;
+	stats.tick.bytes += bytes;
+}
+
+/**
+ * Count an allocation of bytes from site that went to the heap.
+ */
+static void countHeap(size_t bytes, enum allocSite site) {
+	count(bytes, site);
+	stats.sites[site].heap++;
+	stats.tick.heap++;
+	stats.live += (int64_t) bytes;
+
+	if (stats.live > stats.peak) {
+		stats.peak = stats.live;
+	}
+}
+#endif
+
+/**
+ * Whether or not ptr belongs to the calling thread's arena.
+ */
+static bool inArena(const void* ptr) {
+	return arena && arenaOwns(arena, ptr);
+}
+
+/**
+ * cJSON_Hooks.malloc_fn
+ */
+static void* hookMalloc(size_t bytes) {
+	return areMalloc(bytes, SITE_CJSON);
+}
+
+/**
+ * Install allocation hooks into cJSON. Must be called before any other
+ * thread is started.
+ */
+void allocInit() {
+	cJSON_Hooks hooks = {&hookMalloc, &areFree};
+
+	cJSON_InitHooks(&hooks);
+}
+
+/**
+ * Serve the calling thread's allocations from a (NULL to use the heap).
+ * Memory from the arena must not be used after the arena is reset.
+ * @param  a
+ * @return   The previous arena.
+ */
+Arena* allocUseArena(Arena* a) {
+	Arena* prev = arena;
+
+	arena = a;
+
+	return prev;
+}
+
+/**
+ * malloc() that is accounted for against site.
+ * @param  bytes
+ * @param  site
+ */
+void* areMalloc(size_t bytes, enum allocSite site) {
+	if (arena) {
+		void* ptr = arenaAlloc(arena, bytes);
+
+	#ifdef ALLOC_STATS
+		if (ptr) {
+			count(bytes, site);
+		}
+	#else
+		(void) site;
+	#endif
+
+		return ptr;
+	}
+
+	void* ptr = malloc(bytes);
+
+#ifdef ALLOC_STATS
+	if (ptr) {
+		// count the usable size so that frees balance out
+		countHeap(_msize(ptr), site);
+	}
+#else
+	(void) site;
+#endif
+
+	return ptr;
+}
+
+/**
+ * calloc() that is accounted for against site.
+ * @param  count
+ * @param  size
+ * @param  site
+ */
+void* areCalloc(size_t n, size_t size, enum allocSite site) {
+	if (arena) {
+		if (size && n > SIZE_MAX / size) {
+			return NULL;
+		}
+
+		void* ptr = areMalloc(n * size, site);
+
+		if (ptr) {
+			memset(ptr, 0, n * size);
+		}
+
+		return ptr;
+	}
+
+	void* ptr = calloc(n, size);
+
+#ifdef ALLOC_STATS
+	if (ptr) {
+		countHeap(_msize(ptr), site);
+	}
+#else
+	(void) site;
+#endif
+
+	return ptr;
+}
+
+/**
+ * realloc() that is accounted for against site. Arena memory is grown by
+ * copying into a new allocation from the same arena.
+ * @param  ptr
+ * @param  bytes
+ * @param  site
+ */
+void* areRealloc(void* ptr, size_t bytes, enum allocSite site) {
+	if (!ptr || inArena(ptr)) {
+		void* res = areMalloc(bytes, site);
+
+		if (res && ptr) {
+			size_t before = arenaSize(ptr);
+
+			memcpy(res, ptr, before < bytes ? before : bytes);
+		}
+
+		return res;
+	}
+
+#ifdef ALLOC_STATS
+	size_t before = _msize(ptr);
+	void* res = realloc(ptr, bytes);
+
+	if (res) {
+		stats.live -= (int64_t) before;
+		countHeap(_msize(res), site);
+	}
+
+	return res;
+#else
+	(void) site;
+
+	return realloc(ptr, bytes);
+#endif
+}
+
+/**
+ * strdup() that is accounted for against site.
+ * @param  str
+ * @param  site
+ */
+char* areStrdup(const char* str, enum allocSite site) {
+	size_t bytes = strlen(str) + 1;
+	char* dup = areMalloc(bytes, site);
+
+	if (!dup) {
+		return NULL;
+	}
+
+	memcpy(dup, str, bytes);
+
+	return dup;
+}
+
+/**
+ * free() for memory returned by any of the above (or cJSON). Memory from
+ * plain malloc() may also be freed here. Arena memory is left alone until
+ * the arena is reset.
+ * @param ptr
+ */
+void areFree(void* ptr) {
+	if (!ptr || inArena(ptr)) {
+		return;
+	}
+
+#ifdef ALLOC_STATS
+	stats.live -= (int64_t) _msize(ptr);
+#endif
+
+	free(ptr);
+}
+
+/**
+ * The calling thread's counters. All zero unless ALLOC_STATS is defined.
+ */
+const AllocStats* allocStats() {
+#ifdef ALLOC_STATS
+	return &stats;
+#else
+	static const AllocStats empty = {0};
+
+	return &empty;
+#endif
+}
+
+/**
+ * Close the calling thread's current tick.
+ */
+void allocTick() {
+#ifdef ALLOC_STATS
+	stats.last = stats.tick;
+
+	if (stats.tick.allocs > stats.max.allocs) {
+		stats.max.allocs = stats.tick.allocs;
+	}
+
+	if (stats.tick.bytes > stats.max.bytes) {
+		stats.max.bytes = stats.tick.bytes;
+	}
+
+	if (stats.tick.heap > stats.max.heap) {
+		stats.max.heap = stats.tick.heap;
+	}
+
+	stats.tick.allocs = 0;
+	stats.tick.bytes = 0;
+	stats.tick.heap = 0;
+	stats.ticks++;
+#endif
+}
+
+/**
+ * Write the calling thread's counters to stdout (log.txt in release builds).
+ */
+void allocPrint() {
+#ifdef ALLOC_STATS
+	static const char* names[SITE_COUNT] = {"cjson", "string", "response", "request"};
+	uint64_t ticks = stats.ticks ? stats.ticks : 1;
+
+	printf("Allocations after %llu ticks: last tick %llu (%llu B, %llu heap), max tick %llu (%llu B, %llu heap), peak live %lld B\n",
+		(unsigned long long) stats.ticks,
+		(unsigned long long) stats.last.allocs, (unsigned long long) stats.last.bytes,
+		(unsigned long long) stats.last.heap,
+		(unsigned long long) stats.max.allocs, (unsigned long long) stats.max.bytes,
+		(unsigned long long) stats.max.heap,
+		(long long) stats.peak);
+
+	for (int i = 0; i < SITE_COUNT; i++) {
+		printf("  %-8s allocs=%llu bytes=%llu heap=%llu per tick: allocs=%llu bytes=%llu\n",
+			names[i],
+			(unsigned long long) stats.sites[i].allocs,
+			(unsigned long long) stats.sites[i].bytes,
+			(unsigned long long) stats.sites[i].heap,
+			(unsigned long long) (stats.sites[i].allocs / ticks),
+			(unsigned long long) (stats.sites[i].bytes / ticks));
+	}
+
+	fflush(stdout);
+#endif
+}
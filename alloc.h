@@ -0,0 +1,71 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <cjson/cJSON.h>
+
+#include "config.h"
+#include "arena.h"
+
+// where an allocation was requested from
+enum allocSite {
+	// cJSON trees and printed JSON strings
+	SITE_CJSON = 0,
+
+	// wchar_t* <-> char* conversions
+	SITE_STRING,
+
+	// response objects, payloads, and headers
+	SITE_RESPONSE,
+
+	// response body growth in the curl write callback
+	SITE_REQUEST,
+
+	SITE_COUNT
+};
+
+typedef struct allocCounters {
+	uint64_t allocs;
+	uint64_t bytes;
+
+	// allocations that went to the heap rather than an arena
+	uint64_t heap;
+} AllocCounters;
+
+/**
+ * Allocation counters of a single thread. Only maintained when
+ * ALLOC_STATS is defined.
+ */
+typedef struct allocStats {
+	// totals per call site
+	AllocCounters sites[SITE_COUNT];
+
+	// the tick in progress, the last completed tick, and the largest tick
+	AllocCounters tick;
+	AllocCounters last;
+	AllocCounters max;
+
+	// ticks closed with allocTick()
+	uint64_t ticks;
+
+	// heap bytes currently allocated and the most ever allocated at once
+	int64_t live;
+	int64_t peak;
+} AllocStats;
+
+void allocInit();
+Arena* allocUseArena(Arena*);
+void* areMalloc(size_t, enum allocSite);
+void* areCalloc(size_t, size_t, enum allocSite);
+void* areRealloc(void*, size_t, enum allocSite);
+char* areStrdup(const char*, enum allocSite);
+void areFree(void*);
+const AllocStats* allocStats();
+void allocTick();
+void allocPrint();
+
+#endif
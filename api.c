@@ -80,6 +80,8 @@ static char* createURL(int count, ...) {
 
 			return NULL;
 		}
+
+		url = ptr;
 	}
 
 	// append a null terminator
@@ -177,19 +179,24 @@ struct curl_slist* publishInit(CURL* curl, const char* base,
 		return NULL;
 	}
 
-	// attach the url
+	// attach the url (curl keeps its own copy)
 	curl_easy_setopt(curl, CURLOPT_URL, url);
+	free(url);
 
 	return headers;
 }
 
 /**
  * Sends the JSON body to the already initialised and set URL.
- * @param  curl Curl easy handle. Must be initialised with publishInit.
- * @param  json The JSON string to attach as the request body.
- * @return      Must be freed once used.
+ * @param  curl  Curl easy handle. Must be initialised with publishInit.
+ * @param  json  The JSON string to attach as the request body.
+ * @param  reply Dereferenced and assigned the parsed response body on success, or
+ *               NULL if there was none. Must be deleted once used.
+ * @return       0 on success, non-zero corresponding to errors in error.h.
  */
-int publish(CURL* curl, const char* json) {
+int publish(CURL* curl, const char* json, cJSON** reply) {
+	*reply = NULL;
+
 	// attach the body
 	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json);
 
@@ -203,6 +210,11 @@ int publish(CURL* curl, const char* json) {
 	CURLcode cc = res->curlCode;
 	int status = res->status;
 
+	// the body may carry settings for the publisher
+	if (cc == 0 && status < 400 && res->body->len > 1) {
+		*reply = cJSON_Parse(res->body->data);
+	}
+
 	// response no longer required
 	freeResponse(res);
 
@@ -371,7 +383,7 @@ int channelLogin(char* id, char* pw) {
 
 	if (!headers) {
 		curl_easy_cleanup(curl);
-		free(body);
+		cJSON_free(body);
 
 		return ARE_OUT_OF_MEM;
 	}
@@ -382,7 +394,7 @@ int channelLogin(char* id, char* pw) {
 	// no longer need the curl handle, json body, and headers
 	curl_easy_cleanup(curl);
 	curl_slist_free_all(headers);
-	free(body);
+	cJSON_free(body);
 
 	if (!res) {
 		return ARE_OUT_OF_MEM;
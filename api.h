@@ -20,7 +20,7 @@
 
 char* createPasswordHeader(const char* password);
 struct curl_slist* publishInit(CURL* curl, const char* base, const char* cID, const char* pw);
-int publish(CURL* curl, const char* json);
+int publish(CURL* curl, const char* json, cJSON** reply);
 int getChannels(cJSON** ptr);
 int channelLogin(char*, char*);
 
@@ -0,0 +1,216 @@
+#include "arena.h"
+
+/**
+ * Allocate a chunk with cap usable bytes.
+ */
+static struct arenaChunk* createChunk(size_t cap) {
+	struct arenaChunk* c = malloc(sizeof(*c));
+
+	if (!c) {
+		return NULL;
+	}
+
+	c->data = malloc(cap);
+
+	if (!c->data) {
+		free(c);
+
+		return NULL;
+	}
+
+	c->next = NULL;
+	c->cap = cap;
+	c->used = 0;
+
+	return c;
+}
+
+/**
+ * Free a chunk and all chunks after it.
+ */
+static void freeChunks(struct arenaChunk* c) {
+	while (c) {
+		struct arenaChunk* next = c->next;
+
+		free(c->data);
+		free(c);
+		c = next;
+	}
+}
+
+/**
+ * Round n up to a multiple of ARENA_ALIGN.
+ */
+static size_t align(size_t n) {
+	return (n + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+/**
+ * Bytes needed to align the next allocation in c. malloc only guarantees
+ * alignment for the largest fundamental type which may be less than ARENA_ALIGN.
+ */
+static size_t padding(const struct arenaChunk* c) {
+	uintptr_t next = (uintptr_t) (c->data + c->used);
+
+	return align(next) - next;
+}
+
+/**
+ * Allocate an arena with an initial capacity of cap bytes.
+ * @param  cap
+ * @return     NULL if out of memory.
+ */
+Arena* createArena(size_t cap) {
+	Arena* a = malloc(sizeof(*a));
+
+	if (!a) {
+		return NULL;
+	}
+
+	a->head = createChunk(cap);
+
+	if (!a->head) {
+		free(a);
+
+		return NULL;
+	}
+
+	a->used = 0;
+	a->highWater = 0;
+	a->grows = 0;
+
+	return a;
+}
+
+/**
+ * Allocate bytes from the arena. The allocation is preceded by a header
+ * holding its size so that it can be grown by copying.
+ * @param  a
+ * @param  bytes
+ * @return       Aligned to ARENA_ALIGN. NULL if out of memory.
+ */
+void* arenaAlloc(Arena* a, size_t bytes) {
+	size_t need = ARENA_ALIGN + align(bytes);
+	struct arenaChunk* c = a->head;
+
+	if (c->cap - c->used < need + padding(c)) {
+		// grow geometrically so that a single bad iteration doesn't
+		// result in a long chain of tiny chunks
+		size_t cap = c->cap * 2;
+
+		if (cap < need + ARENA_ALIGN) {
+			cap = need + ARENA_ALIGN;
+		}
+
+		c = createChunk(cap);
+
+		if (!c) {
+			return NULL;
+		}
+
+		c->next = a->head;
+		a->head = c;
+		a->grows++;
+	}
+
+	size_t pad = padding(c);
+	unsigned char* ptr = c->data + c->used + pad + ARENA_ALIGN;
+
+	memcpy(ptr - sizeof(size_t), &bytes, sizeof(size_t));
+	c->used += pad + need;
+	a->used += pad + need;
+
+	return ptr;
+}
+
+/**
+ * The size requested for an allocation returned by arenaAlloc().
+ * @param ptr
+ */
+size_t arenaSize(const void* ptr) {
+	size_t bytes;
+
+	memcpy(&bytes, (const unsigned char*) ptr - sizeof(size_t), sizeof(size_t));
+
+	return bytes;
+}
+
+/**
+ * Whether or not ptr was returned by arenaAlloc() on a.
+ * @param a
+ * @param ptr
+ */
+bool arenaOwns(const Arena* a, const void* ptr) {
+	const unsigned char* p = ptr;
+
+	for (const struct arenaChunk* c = a->head; c; c = c->next) {
+		if (p >= c->data && p < c->data + c->cap) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Release every allocation. If the arena had to grow since the last reset
+ * the chunks are merged into a single chunk large enough for all of them.
+ * @param a
+ */
+void arenaReset(Arena* a) {
+	if (a->used > a->highWater) {
+		a->highWater = a->used;
+	}
+
+	if (a->head->next) {
+		size_t cap = 0;
+
+		for (struct arenaChunk* c = a->head; c; c = c->next) {
+			cap += c->cap;
+		}
+
+		struct arenaChunk* merged = createChunk(cap);
+
+		if (merged) {
+			freeChunks(a->head);
+			a->head = merged;
+		}
+	}
+
+	// if merging failed the chunks are kept as they are
+	for (struct arenaChunk* c = a->head; c; c = c->next) {
+		c->used = 0;
+	}
+
+	a->used = 0;
+}
+
+/**
+ * Write the high-water mark and capacity to stdout (log.txt in release builds).
+ * @param a
+ */
+void arenaPrint(const Arena* a) {
+	size_t cap = 0;
+
+	for (const struct arenaChunk* c = a->head; c; c = c->next) {
+		cap += c->cap;
+	}
+
+	printf("Arena: high water %zu B, capacity %zu B, grown %llu times\n",
+		a->highWater, cap, (unsigned long long) a->grows);
+
+	fflush(stdout);
+}
+
+/**
+ * Free an arena and all of its chunks. Does nothing if a is NULL.
+ * @param a
+ */
+void freeArena(Arena* a) {
+	if (!a) {
+		return;
+	}
+
+	freeChunks(a->head);
+	free(a);
+}
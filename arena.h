@@ -0,0 +1,51 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// alignment of every allocation; also the size of the allocation header
+#define ARENA_ALIGN 16
+
+// initial capacity of an arena in bytes
+#define ARENA_INIT_SIZE (64 * 1024)
+
+struct arenaChunk {
+	struct arenaChunk* next;
+	unsigned char* data;
+	size_t cap;
+	size_t used;
+};
+
+/**
+ * Bump pointer allocator. Individual allocations are never freed; everything
+ * is released at once by arenaReset(). When an iteration outgrows the arena
+ * an extra chunk is allocated, and on the next reset the chunks are merged
+ * into one so later iterations don't touch the heap at all.
+ */
+typedef struct arena {
+	// newest chunk first
+	struct arenaChunk* head;
+
+	// bytes handed out (including headers and padding) since the last reset
+	size_t used;
+
+	// the most bytes ever handed out between two resets
+	size_t highWater;
+
+	// chunks allocated after creation
+	uint64_t grows;
+} Arena;
+
+Arena* createArena(size_t);
+void* arenaAlloc(Arena*, size_t);
+size_t arenaSize(const void*);
+bool arenaOwns(const Arena*, const void*);
+void arenaReset(Arena*);
+void arenaPrint(const Arena*);
+void freeArena(Arena*);
+
+#endif
@@ -9,7 +9,7 @@ char* wstrToStr(const wchar_t* wstr) {
 	// allocate sizeof(wchar_t) bytes for every character
 	// in wstr and one extra for the null terminator
 	size_t bytes = wcslen(wstr) * sizeof(wchar_t) + 1;
-	char* str = malloc(bytes);
+	char* str = areMalloc(bytes, SITE_STRING);
 
 	if (!str) {
 		// out of memory
@@ -29,7 +29,7 @@ char* wstrToStr(const wchar_t* wstr) {
 wchar_t* strToWstr(const char* str) {
 	// allocate the length of str * sizeof(wchar_t) + 2 for wide null terminator
 	size_t bytes = strlen(str) * sizeof(wchar_t) + 2;
-	wchar_t* wstr = malloc(bytes);
+	wchar_t* wstr = areMalloc(bytes, SITE_STRING);
 
 	if (!wstr) {
 		// out of memory
@@ -48,7 +48,7 @@ wchar_t* strToWstr(const char* str) {
  * @param  wstr The string to convert
  * @return      Value of cJSON_AddStringToObject() or NULL if an error occurred.
  */
-cJSON* addWstrToObject(cJSON* obj, char* key, const wchar_t* wstr) {
+cJSON* addWstrToObject(cJSON* obj, const char* key, const wchar_t* wstr) {
 	char* mbstr = wstrToStr(wstr);
 
 	if (!mbstr) {
@@ -60,7 +60,7 @@ cJSON* addWstrToObject(cJSON* obj, char* key, const wchar_t* wstr) {
 	cJSON* ptr = cJSON_AddStringToObject(obj, key, mbstr);
 
 	// free the dynamically allocated multi-byte string
-	free(mbstr);
+	areFree(mbstr);
 
 	return ptr;
 }
@@ -84,3 +84,64 @@ void msgBoxErr(HWND parent, int eCode, const wchar_t* str) {
 	// display to the user
 	MessageBoxW(parent, buf, L"Error", MB_OK | MB_ICONERROR);
 }
+
+/**
+ * Encode bytes as padded base64 (RFC 4648).
+ * @param  out At least BASE64_LEN(len) + 1 characters. Null terminated.
+ * @param  in
+ * @param  len Bytes of in.
+ * @return     Characters written excluding the terminator.
+ */
+size_t base64Encode(char* out, const uint8_t* in, size_t len) {
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t n = 0;
+
+	for (size_t i = 0; i < len; i += 3) {
+		uint32_t v = (uint32_t) in[i] << 16;
+
+		if (i + 1 < len) {
+			v |= (uint32_t) in[i + 1] << 8;
+		}
+
+		if (i + 2 < len) {
+			v |= in[i + 2];
+		}
+
+		out[n++] = alphabet[(v >> 18) & 63];
+		out[n++] = alphabet[(v >> 12) & 63];
+		out[n++] = i + 1 < len ? alphabet[(v >> 6) & 63] : '=';
+		out[n++] = i + 2 < len ? alphabet[v & 63] : '=';
+	}
+
+	out[n] = '\0';
+
+	return n;
+}
+
+/**
+ * Build the path of a file in the directory of the running executable, so
+ * that data files are found regardless of the working directory.
+ * @param  out  Assigned the path.
+ * @param  size Characters of out.
+ * @param  name File name relative to the executable's directory.
+ * @return      False if the path could not be determined or does not fit.
+ */
+bool exeRelativePath(wchar_t* out, size_t size, const wchar_t* name) {
+	DWORD n = GetModuleFileNameW(NULL, out, (DWORD) size);
+
+	if (n == 0 || n >= size) {
+		return false;
+	}
+
+	// keep the directory including its trailing separator
+	wchar_t* sep = wcsrchr(out, L'\\');
+	size_t dir = sep ? (size_t) (sep - out) + 1 : 0;
+
+	if (dir + wcslen(name) >= size) {
+		return false;
+	}
+
+	wcscpy(out + dir, name);
+
+	return true;
+}
@@ -4,11 +4,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <wchar.h>
 #include <math.h>
 #include <cjson/cJSON.h>
 
+#include "alloc.h"
+#include "group.h"
+#include "fields.h"
 #include "error.h"
 #include "config.h"
 
@@ -48,15 +52,16 @@
 } while (0)
 
 /**
- * The same as INT_2_OBJ but adds the integer b to the object o under the key k if p is NULL
- * or a and b are not equal. Used to compare between previous and current data frames.
- * Deletes o and returns NULL if adding the integer failed.
+ * The same as INT_2_OBJ but adds the integer b to the object o under the key of the
+ * field f if f is subscribed to and p is NULL or a and b are not equal. Used to compare
+ * between previous and current data frames. Deletes o and returns NULL if adding the
+ * integer failed.
  * Example:
- * INT_2_OBJ_CMP(obj, "position", prev, prev->position, curr->position)
+ * INT_2_OBJ_CMP(obj, FLD_POSITION, prev, prev->position, curr->position)
  */
-#define INT_2_OBJ_CMP(o, k, p, a, b) do {\
-	if (!prev || a != b) {\
-		INT_2_OBJ(o, k, b);\
+#define INT_2_OBJ_CMP(o, f, p, a, b) do {\
+	if (FIELD_ON(f) && (!p || a != b)) {\
+		INT_2_OBJ(o, FIELD_KEY(f), b);\
 	}\
 } while (0)
 
@@ -77,18 +82,16 @@
 } while (0)
 
 /**
- * Same as FLOAT_2_OBJ but adds the float b to the object o under the key k if p
- * is NULL or a and b are not equal. Used to compare between previous and current
- * data frames. Deletes o and returns NULL if adding the float failed.
+ * Same as FLOAT_2_OBJ but adds the float b to the object o under the key of the field f
+ * if f is subscribed to and p is NULL or a and b are not equal. Used to compare between
+ * previous and current data frames. Deletes o and returns NULL if adding the float failed.
  */
-#define FLOAT_2_OBJ_CMP(o, k, p, a, b) do {\
-	if (!prev) {\
-		FLOAT_2_OBJ(o, k, b);\
-	} else {\
-		float f1 = truncf(a * 1000);\
-		float f2 = truncf(b * 1000);\
-		if (f1 != f2) {\
-			FLOAT_2_OBJ(o, k, b);\
+#define FLOAT_2_OBJ_CMP(o, f, p, a, b) do {\
+	if (FIELD_ON(f)) {\
+		if (!p) {\
+			FLOAT_2_OBJ(o, FIELD_KEY(f), b);\
+		} else if (truncf(a * 1000) != truncf(b * 1000)) {\
+			FLOAT_2_OBJ(o, FIELD_KEY(f), b);\
 		}\
 	}\
 } while (0)
@@ -104,21 +107,42 @@
 } while (0)
 
 /**
- * The same as BOOL_2_OBJ but adds the boolean b to the object o under the key k if p is NULL
- * or a and b are not equal. Used to compare between previous and current data frames.
- * Deletes o and returns NULL if adding the boolean failed.
+ * The same as BOOL_2_OBJ but adds the boolean b to the object o under the key of the
+ * field f if f is subscribed to and p is NULL or a and b are not equal. Used to compare
+ * between previous and current data frames. Deletes o and returns NULL if adding the
+ * boolean failed.
  * Example:
- * BOOL_2_OBJ_CMP(obj, "globalYellow", prev, prev->globalYellow, curr->globalYellow)
+ * BOOL_2_OBJ_CMP(obj, FLD_FLAG_YELLOW_GLOBAL, prev, prev->globalYellow, curr->globalYellow)
  */
-#define BOOL_2_OBJ_CMP(o, k, p, a, b) do {\
-	if (!p || a != b) {\
-		BOOL_2_OBJ(o, k, b);\
+#define BOOL_2_OBJ_CMP(o, f, p, a, b) do {\
+	if (FIELD_ON(f) && (!p || a != b)) {\
+		BOOL_2_OBJ(o, FIELD_KEY(f), b);\
 	}\
 } while (0)
 
+// time between samples (and broadcasts) in microseconds
+#define LOOP_PERIOD (1000000 / SAMPLE_RATE)
+
+// samples fed to the lap engines per broadcast: LAP_SAMPLE_RATE rounded
+// down to a multiple of SAMPLE_RATE and never below it
+#define LAP_SUB_SAMPLES (LAP_SAMPLE_RATE > SAMPLE_RATE ? LAP_SAMPLE_RATE / SAMPLE_RATE : 1)
+
+// samples fed to the lap engines per second and the time between them in
+// microseconds
+#define LAP_RATE (SAMPLE_RATE * LAP_SUB_SAMPLES)
+#define LAP_PERIOD (LOOP_PERIOD / LAP_SUB_SAMPLES)
+
+// characters (including the terminator) of a path built by exeRelativePath
+#define EXE_PATH_SIZE 1024
+
+// characters (excluding the terminator) of n bytes encoded as base64
+#define BASE64_LEN(n) ((((n) + 2) / 3) * 4)
+
 char* wstrToStr(const wchar_t* wstr);
 wchar_t* strToWstr(const char* str);
-cJSON* addWstrToObject(cJSON*, char*, const wchar_t*);
+cJSON* addWstrToObject(cJSON*, const char*, const wchar_t*);
 void msgBoxErr(HWND parent, int e, const wchar_t* str);
+size_t base64Encode(char* out, const uint8_t* in, size_t len);
+bool exeRelativePath(wchar_t* out, size_t size, const wchar_t* name);
 
 #endif
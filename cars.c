@@ -0,0 +1,259 @@
+#include "cars.h"
+
+/**
+ * FNV-1a over a wide string mixed with seed.
+ */
+static uint32_t hashModel(const wchar_t* model, uint32_t seed) {
+	uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+
+	for (; *model; model++) {
+		hash = (hash ^ (uint32_t) *model) * 16777619u;
+	}
+
+	// FNV's low bits are weak for short keys; finalise before taking a modulus
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+
+	return hash;
+}
+
+/**
+ * Parse a single (non-comment, non-header) line into c.
+ * @return False if the line is malformed.
+ */
+static bool parseCar(const char* line, Car* c) {
+	char model[CAR_MODEL_LEN];
+
+	// trailing columns are ignored so that new ones can be added to the
+	// file before the publisher knows about them
+	if (sscanf(line, " %32[^,],%d,%7[^,\r\n]", model, &c->biasOffset, c->carClass) != 3) {
+		return false;
+	}
+
+	return mbstowcs(c->model, model, CAR_MODEL_LEN) != (size_t) -1;
+}
+
+/**
+ * Read every car from the file.
+ * @return 0 on success, an error code otherwise.
+ */
+static int readCars(const wchar_t* path, CarTable* t) {
+	FILE* f = _wfopen(path, L"r");
+
+	if (!f) {
+		// the publisher works without it; cars are just not looked up
+		printf("%ls not found; car metadata is unavailable\n", path);
+
+		return 0;
+	}
+
+	char line[CARS_LINE_LEN];
+	int cap = 0;
+	int lineNo = 0;
+
+	while (fgets(line, CARS_LINE_LEN, f)) {
+		lineNo++;
+
+		// skip blank lines, comments, and the column header
+		if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || strncmp(line, "model,", 6) == 0) {
+			continue;
+		}
+
+		if (t->count == cap) {
+			cap = cap ? cap * 2 : 64;
+
+			Car* cars = realloc(t->cars, sizeof(Car) * cap);
+
+			if (!cars) {
+				fclose(f);
+
+				return ARE_OUT_OF_MEM;
+			}
+
+			t->cars = cars;
+		}
+
+		if (!parseCar(line, &t->cars[t->count])) {
+			printf("%ls:%d: malformed car\n", path, lineNo);
+			fclose(f);
+
+			return ARE_FILE;
+		}
+
+		t->count++;
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+/**
+ * Order bucket indices by descending bucket size so that the hardest
+ * buckets are placed while the table is emptiest.
+ */
+static const int* sortSizes;
+
+static int cmpBuckets(const void* a, const void* b) {
+	return sortSizes[*(const int*) b] - sortSizes[*(const int*) a];
+}
+
+/**
+ * Find a seed for every bucket that maps its cars to distinct free slots.
+ * @return 0 on success, an error code otherwise.
+ */
+static int buildTable(CarTable* t) {
+	int n = t->count;
+
+	// a load factor of 0.5 keeps the seed search short
+	t->size = n * 2;
+	t->seeds = calloc(n, sizeof(uint32_t));
+	t->slots = malloc(sizeof(int) * t->size);
+
+	int* bucketOf = malloc(sizeof(int) * n);
+	int* sizes = calloc(n, sizeof(int));
+	int* order = malloc(sizeof(int) * n);
+	int* placed = malloc(sizeof(int) * n);
+	int result = 0;
+
+	if (!t->seeds || !t->slots || !bucketOf || !sizes || !order || !placed) {
+		result = ARE_OUT_OF_MEM;
+		goto done;
+	}
+
+	for (int i = 0; i < t->size; i++) {
+		t->slots[i] = -1;
+	}
+
+	for (int i = 0; i < n; i++) {
+		bucketOf[i] = (int) (hashModel(t->cars[i].model, 0) % (uint32_t) n);
+		sizes[bucketOf[i]]++;
+		order[i] = i;
+	}
+
+	sortSizes = sizes;
+	qsort(order, n, sizeof(int), &cmpBuckets);
+
+	for (int b = 0; b < n && sizes[order[b]] > 0; b++) {
+		int bucket = order[b];
+		bool ok = false;
+
+		for (uint32_t seed = 1; seed < CARS_MAX_SEED && !ok; seed++) {
+			int count = 0;
+
+			ok = true;
+
+			for (int i = 0; i < n && ok; i++) {
+				if (bucketOf[i] != bucket) {
+					continue;
+				}
+
+				int slot = (int) (hashModel(t->cars[i].model, seed) % (uint32_t) t->size);
+
+				// the slot must be free and not taken by an earlier car in this bucket
+				for (int j = 0; j < count; j++) {
+					if ((int) (hashModel(t->cars[placed[j]].model, seed) % (uint32_t) t->size) == slot) {
+						ok = false;
+					}
+				}
+
+				if (t->slots[slot] != -1) {
+					ok = false;
+				}
+
+				placed[count++] = i;
+			}
+
+			if (ok) {
+				for (int j = 0; j < count; j++) {
+					t->slots[hashModel(t->cars[placed[j]].model, seed) % (uint32_t) t->size] = placed[j];
+				}
+
+				t->seeds[bucket] = seed;
+			}
+		}
+
+		if (!ok) {
+			// only happens with duplicate models
+			printf("Could not build the car table; check for duplicate models\n");
+			result = ARE_FILE;
+			goto done;
+		}
+	}
+
+done:
+	free(bucketOf);
+	free(sizes);
+	free(order);
+	free(placed);
+
+	return result;
+}
+
+/**
+ * Load the car metadata file and build its lookup table. A missing file
+ * results in an empty table.
+ * @param  path
+ * @param  ptr  Dereferenced and assigned the table on success.
+ * @return      0 on success, non-zero corresponding to errors in error.h.
+ */
+int loadCars(const wchar_t* path, CarTable** ptr) {
+	CarTable* t = calloc(1, sizeof(*t));
+
+	if (!t) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	int result = readCars(path, t);
+
+	if (result == 0 && t->count > 0) {
+		result = buildTable(t);
+	}
+
+	if (result != 0) {
+		freeCars(t);
+
+		return result;
+	}
+
+	*ptr = t;
+
+	return 0;
+}
+
+/**
+ * Find the metadata of a car model.
+ * @param  t
+ * @param  model
+ * @return       NULL if the model is unknown.
+ */
+const Car* carsFind(const CarTable* t, const wchar_t* model) {
+	if (t->count == 0) {
+		return NULL;
+	}
+
+	uint32_t seed = t->seeds[hashModel(model, 0) % (uint32_t) t->count];
+	int i = t->slots[hashModel(model, seed) % (uint32_t) t->size];
+
+	if (i < 0 || wcscmp(t->cars[i].model, model) != 0) {
+		return NULL;
+	}
+
+	return &t->cars[i];
+}
+
+/**
+ * Free a car table. Does nothing if t is NULL.
+ * @param t
+ */
+void freeCars(CarTable* t) {
+	if (!t) {
+		return;
+	}
+
+	free(t->cars);
+	free(t->seeds);
+	free(t->slots);
+	free(t);
+}
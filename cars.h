@@ -0,0 +1,60 @@
+#ifndef CARS_H
+#define CARS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <wchar.h>
+
+#include "error.h"
+
+// car metadata file; looked for next to the executable
+#define CARS_FILE L"cars.csv"
+
+// lengths including the null terminator; matches Properties.carModel
+#define CAR_MODEL_LEN 33
+#define CAR_CLASS_LEN 8
+
+// longest line accepted in the data file
+#define CARS_LINE_LEN 256
+
+// displacement seeds tried per bucket before giving up
+#define CARS_MAX_SEED 100000
+
+/**
+ * Per-model constants.
+ */
+typedef struct car {
+	wchar_t model[CAR_MODEL_LEN];
+
+	// added to the raw brake bias percentage to match the in game value
+	int biasOffset;
+
+	// GT3, GT4, CUP, or ST
+	char carClass[CAR_CLASS_LEN];
+} Car;
+
+/**
+ * Perfect hash (hash and displace) over the car models. A model's
+ * bucket selects a seed which is re-hashed with to find its slot, so a
+ * lookup is two hashes and one comparison.
+ */
+typedef struct carTable {
+	Car* cars;
+	int count;
+
+	// seed per bucket; count buckets
+	uint32_t* seeds;
+
+	// index into cars per slot or -1; size slots
+	int* slots;
+	int size;
+} CarTable;
+
+int loadCars(const wchar_t*, CarTable**);
+const Car* carsFind(const CarTable*, const wchar_t*);
+void freeCars(CarTable*);
+
+#endif
@@ -9,8 +9,8 @@ static void freeChannel(Channel* chan) {
 		return;
 	}
 
-	free(chan->id);
-	free(chan->name);
+	areFree(chan->id);
+	areFree(chan->name);
 	free(chan);
 }
 
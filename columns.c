@@ -0,0 +1,683 @@
+#include "columns.h"
+
+_Static_assert(sizeof(ColHeader) == 32, "ColHeader must not contain padding");
+_Static_assert(sizeof(ColDesc) == 48, "ColDesc must not contain padding");
+_Static_assert(sizeof(ColBlock) == 40, "ColBlock must not contain padding");
+_Static_assert(sizeof(ColPyramid) == 8, "ColPyramid must not contain padding");
+_Static_assert(sizeof(ColLevel) == 24, "ColLevel must not contain padding");
+_Static_assert(sizeof(ColSummary) == 16, "ColSummary must not contain padding");
+
+/**
+ * Running summary of values or of other summaries.
+ */
+struct summary {
+	double min;
+	double max;
+	double sum;
+	uint64_t count;
+};
+
+/**
+ * Where a column's values come from.
+ */
+struct colDef {
+	const char* name;
+	enum recBlockType source;
+	size_t offset;
+	uint8_t type;
+	uint8_t width;
+};
+
+// values of every exported member are 4 bytes wide
+#define X(s, t, m, ty) \
+	{#m, s, offsetof(t, m), ty, (uint8_t) (sizeof(((t*) 0)->m) / 4)},
+static const struct colDef defs[COLUMN_COUNT] = {
+	{"time", 0, 0, COL_U64, 1},
+	COLUMNS(X)
+};
+#undef X
+
+/**
+ * Size of a single value of type t.
+ */
+static size_t typeSize(uint8_t t) {
+	return t == COL_U64 ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+/**
+ * Append size bytes to a column buffer, doubling its capacity as required.
+ * @return False if out of memory.
+ */
+static bool push(struct colBuffer* b, const void* data, size_t size) {
+	if (b->size + size > b->cap) {
+		size_t cap = b->cap ? b->cap * 2 : 4096;
+
+		while (cap < b->size + size) {
+			cap *= 2;
+		}
+
+		uint8_t* temp = realloc(b->data, cap);
+
+		if (!temp) {
+			return false;
+		}
+
+		b->data = temp;
+		b->cap = cap;
+	}
+
+	memcpy(b->data + b->size, data, size);
+	b->size += size;
+
+	return true;
+}
+
+/**
+ * Create an empty set of columns.
+ * @param  start Wall clock time the row times are relative to (FILETIME).
+ * @return       NULL if out of memory.
+ */
+ColBuilder* createColBuilder(uint64_t start) {
+	ColBuilder* b = calloc(1, sizeof(*b));
+
+	if (!b) {
+		return NULL;
+	}
+
+	b->start = start;
+
+	return b;
+}
+
+/**
+ * Append a row taken from a frame.
+ * @param  b
+ * @param  time Microseconds since the builder's start time.
+ * @param  p
+ * @param  h
+ * @return      False if out of memory.
+ */
+bool colAppend(ColBuilder* b, uint64_t time, const Physics* p, const HUD* h) {
+	if (!push(&b->columns[COLUMN_TIME], &time, sizeof(time))) {
+		return false;
+	}
+
+	for (int i = COLUMN_TIME + 1; i < COLUMN_COUNT; i++) {
+		const struct colDef* d = &defs[i];
+		const uint8_t* src = (d->source == REC_BLOCK_HUD) ? (const uint8_t*) h : (const uint8_t*) p;
+
+		if (!push(&b->columns[i], src + d->offset, typeSize(d->type) * d->width)) {
+			return false;
+		}
+	}
+
+	b->rows++;
+
+	return true;
+}
+
+/**
+ * Get a value as a double for the block statistics.
+ */
+static double valueAt(const uint8_t* data, uint8_t type, size_t i) {
+	switch (type) {
+	case COL_U64:
+		return (double) ((const uint64_t*) data)[i];
+	case COL_I32:
+		return (double) ((const int32_t*) data)[i];
+	default:
+		return (double) ((const float*) data)[i];
+	}
+}
+
+/**
+ * Minimum and maximum of count values. NaNs are ignored; a block holding
+ * nothing but NaNs gets a min of +inf and a max of -inf.
+ */
+static void minMax(const uint8_t* data, uint8_t type, size_t count, double* min, double* max) {
+	*min = INFINITY;
+	*max = -INFINITY;
+
+	for (size_t i = 0; i < count; i++) {
+		double v = valueAt(data, type, i);
+
+		if (v < *min) {
+			*min = v;
+		}
+
+		if (v > *max) {
+			*max = v;
+		}
+	}
+}
+
+static void summaryStart(struct summary* s) {
+	s->min = INFINITY;
+	s->max = -INFINITY;
+	s->sum = 0.0;
+	s->count = 0;
+}
+
+static void summaryAdd(struct summary* s, double v) {
+	if (isnan(v)) {
+		return;
+	}
+
+	s->min = v < s->min ? v : s->min;
+	s->max = v > s->max ? v : s->max;
+	s->sum += v;
+	s->count++;
+}
+
+static void summaryMerge(struct summary* s, const ColSummary* c) {
+	if (c->count == 0) {
+		return;
+	}
+
+	s->min = c->min < s->min ? c->min : s->min;
+	s->max = c->max > s->max ? c->max : s->max;
+	s->sum += (double) c->mean * c->count;
+	s->count += c->count;
+}
+
+static void summaryEnd(const struct summary* s, ColSummary* c) {
+	c->min = (float) s->min;
+	c->max = (float) s->max;
+	c->mean = s->count ? (float) (s->sum / (double) s->count) : NAN;
+	c->count = (uint32_t) (s->count > UINT32_MAX ? UINT32_MAX : s->count);
+}
+
+/**
+ * Rows and entries of each pyramid level for a column of rows rows. Levels
+ * are added until one entry covers every row.
+ * @return Number of levels.
+ */
+static uint32_t pyramidShape(uint64_t rows, ColLevel* levels) {
+	uint64_t span = COL_PYRAMID_ROWS;
+	uint32_t count = 0;
+
+	while (rows > 0 && count < COL_PYRAMID_LEVELS) {
+		ColLevel* l = &levels[count++];
+
+		l->offset = 0;
+		l->rows = span;
+		l->entries = (rows + span - 1) / span;
+
+		if (l->entries == 1) {
+			break;
+		}
+
+		span *= COL_PYRAMID_FANOUT;
+	}
+
+	return count;
+}
+
+/**
+ * Bytes of a column's pyramid.
+ */
+static uint64_t pyramidSize(const ColLevel* levels, uint32_t count, uint8_t width) {
+	uint64_t size = sizeof(ColPyramid) + sizeof(ColLevel) * count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		size += sizeof(ColSummary) * width * levels[i].entries;
+	}
+
+	return size;
+}
+
+/**
+ * Summarise every COL_PYRAMID_ROWS rows of a column.
+ * @param out level->entries * width summaries.
+ */
+static void summariseRows(const uint8_t* data, const struct colDef* d, uint64_t rows, const ColLevel* level, ColSummary* out) {
+	for (uint64_t i = 0; i < level->entries; i++) {
+		uint64_t first = i * level->rows;
+		uint64_t last = first + level->rows < rows ? first + level->rows : rows;
+
+		for (uint8_t lane = 0; lane < d->width; lane++) {
+			struct summary s;
+
+			summaryStart(&s);
+
+			for (uint64_t row = first; row < last; row++) {
+				summaryAdd(&s, valueAt(data, d->type, (size_t) (row * d->width + lane)));
+			}
+
+			summaryEnd(&s, &out[i * d->width + lane]);
+		}
+	}
+}
+
+/**
+ * Summarise every COL_PYRAMID_FANOUT entries of a level into the next.
+ * @param in    entries * width summaries of the finer level.
+ * @param out   level->entries * width summaries.
+ */
+static void summariseLevel(const ColSummary* in, uint64_t entries, uint8_t width, const ColLevel* level, ColSummary* out) {
+	for (uint64_t i = 0; i < level->entries; i++) {
+		uint64_t first = i * COL_PYRAMID_FANOUT;
+		uint64_t last = first + COL_PYRAMID_FANOUT < entries ? first + COL_PYRAMID_FANOUT : entries;
+
+		for (uint8_t lane = 0; lane < width; lane++) {
+			struct summary s;
+
+			summaryStart(&s);
+
+			for (uint64_t j = first; j < last; j++) {
+				summaryMerge(&s, &in[j * width + lane]);
+			}
+
+			summaryEnd(&s, &out[i * width + lane]);
+		}
+	}
+}
+
+/**
+ * Write a column's pyramid: its level table followed by each level.
+ * @return False if a write failed or out of memory.
+ */
+static bool writePyramid(FILE* out, const uint8_t* data, const struct colDef* d, uint64_t rows,
+	const ColLevel* shape, uint32_t count, uint64_t offset) {
+	ColPyramid p = {count, 0};
+	ColLevel levels[COL_PYRAMID_LEVELS];
+	uint64_t at = offset + sizeof(p) + sizeof(ColLevel) * count;
+
+	for (uint32_t i = 0; i < count; i++) {
+		levels[i] = shape[i];
+		levels[i].offset = at;
+		at += sizeof(ColSummary) * d->width * levels[i].entries;
+	}
+
+	if (fwrite(&p, sizeof(p), 1, out) != 1 || fwrite(levels, sizeof(ColLevel), count, out) != count) {
+		return false;
+	}
+
+	// each level is built from the one before it
+	ColSummary* prev = malloc(sizeof(*prev) * d->width * levels[0].entries);
+	ColSummary* curr = malloc(sizeof(*curr) * d->width * levels[0].entries);
+	bool ok = prev && curr;
+
+	for (uint32_t i = 0; ok && i < count; i++) {
+		size_t n = (size_t) (d->width * levels[i].entries);
+
+		if (i == 0) {
+			summariseRows(data, d, rows, &levels[0], curr);
+		} else {
+			summariseLevel(prev, levels[i - 1].entries, d->width, &levels[i], curr);
+		}
+
+		ok = fwrite(curr, sizeof(*curr), n, out) == n;
+
+		ColSummary* temp = prev;
+
+		prev = curr;
+		curr = temp;
+	}
+
+	free(prev);
+	free(curr);
+
+	return ok;
+}
+
+/**
+ * Padding that keeps the next block table 8 byte aligned after size bytes.
+ */
+static size_t padding(size_t size) {
+	return (8 - size % 8) % 8;
+}
+
+/**
+ * Number of blocks holding rows.
+ */
+static uint32_t blockCount(uint64_t rows) {
+	return (uint32_t) ((rows + COL_BLOCK_ROWS - 1) / COL_BLOCK_ROWS);
+}
+
+/**
+ * Write the column file: header, column descriptions, then each column's
+ * block table followed by its blocks and its pyramid.
+ * @param  b
+ * @param  out
+ * @return     False if a write failed or out of memory.
+ */
+bool colWrite(const ColBuilder* b, FILE* out) {
+	ColHeader h = {
+		COL_MAGIC, COL_FORMAT_VERSION, REC_LAYOUT_VERSION,
+		b->rows, COL_BLOCK_ROWS, COLUMN_COUNT, b->start
+	};
+	ColDesc descs[COLUMN_COUNT];
+	uint32_t blocks = blockCount(b->rows);
+	uint64_t offset = sizeof(h) + sizeof(descs);
+	ColLevel shape[COL_PYRAMID_LEVELS];
+	uint32_t levels = pyramidShape(b->rows, shape);
+
+	memset(descs, 0, sizeof(descs));
+
+	for (int i = 0; i < COLUMN_COUNT; i++) {
+		ColDesc* d = &descs[i];
+
+		snprintf(d->name, sizeof(d->name), "%s", defs[i].name);
+		d->type = defs[i].type;
+		d->width = defs[i].width;
+		d->blocks = blocks;
+		d->table = offset;
+		offset += sizeof(ColBlock) * blocks + b->columns[i].size + padding(b->columns[i].size);
+
+		// times are already ordered
+		if (i != COLUMN_TIME && levels > 0) {
+			d->pyramid = offset;
+			offset += pyramidSize(shape, levels, d->width);
+		}
+	}
+
+	if (fwrite(&h, sizeof(h), 1, out) != 1 || fwrite(descs, sizeof(descs), 1, out) != 1) {
+		return false;
+	}
+
+	for (int i = 0; i < COLUMN_COUNT; i++) {
+		static const uint8_t zeros[8] = {0};
+		const ColDesc* d = &descs[i];
+		const struct colBuffer* c = &b->columns[i];
+		size_t pad = padding(c->size);
+		size_t rowSize = typeSize(d->type) * d->width;
+		uint64_t data = d->table + sizeof(ColBlock) * blocks;
+
+		for (uint32_t j = 0; j < blocks; j++) {
+			uint64_t first = (uint64_t) j * COL_BLOCK_ROWS;
+			uint64_t rows = b->rows - first < COL_BLOCK_ROWS ? b->rows - first : COL_BLOCK_ROWS;
+			ColBlock block = {0};
+
+			block.offset = data + first * rowSize;
+			block.rows = (uint32_t) rows;
+			block.bytes = (uint32_t) (rows * rowSize);
+			block.encoding = COL_RAW;
+			minMax(c->data + first * rowSize, d->type, (size_t) rows * d->width, &block.min, &block.max);
+
+			if (fwrite(&block, sizeof(block), 1, out) != 1) {
+				return false;
+			}
+		}
+
+		if ((c->size && fwrite(c->data, c->size, 1, out) != 1) ||
+			(pad && fwrite(zeros, pad, 1, out) != 1)) {
+			return false;
+		}
+
+		if (d->pyramid && !writePyramid(out, c->data, &defs[i], b->rows, shape, levels, d->pyramid)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Free a builder and its columns. Does nothing if b is NULL.
+ */
+void freeColBuilder(ColBuilder* b) {
+	if (!b) {
+		return;
+	}
+
+	for (int i = 0; i < COLUMN_COUNT; i++) {
+		free(b->columns[i].data);
+	}
+
+	free(b);
+}
+
+/**
+ * Check that every level of a column's pyramid lies within the file and has
+ * an entry for each of its spans of the file's rows.
+ */
+static bool pyramidValid(const ColReader* r, const ColDesc* d) {
+	if (d->pyramid > r->size || r->size - d->pyramid < sizeof(ColPyramid)) {
+		return false;
+	}
+
+	const ColPyramid* p = (const ColPyramid*) (r->base + d->pyramid);
+	const ColLevel* levels = (const ColLevel*) (p + 1);
+
+	if (p->levels > COL_PYRAMID_LEVELS ||
+		p->levels > (r->size - d->pyramid - sizeof(*p)) / sizeof(ColLevel)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < p->levels; i++) {
+		const ColLevel* l = &levels[i];
+
+		if (l->rows == 0 || l->offset > r->size ||
+			l->entries != (r->header->rows + l->rows - 1) / l->rows ||
+			l->entries > (r->size - l->offset) / sizeof(ColSummary) / (d->width ? d->width : 1)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Map a column file into memory and check its header and column descriptions.
+ * @param  path
+ * @param  out  Set to the reader on success.
+ * @return      ARE_FILE if the file cannot be opened or mapped,
+ *              ARE_RECORDING if it is not a column file made with this version,
+ *              ARE_OUT_OF_MEM, or zero on success.
+ */
+int colOpen(const char* path, ColReader** out) {
+	ColReader* r = calloc(1, sizeof(*r));
+
+	if (!r) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	r->file = CreateFileA(
+		path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+	);
+
+	if (r->file == INVALID_HANDLE_VALUE) {
+		r->file = NULL;
+		colClose(r);
+
+		return ARE_FILE;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(r->file, &size) || (uint64_t) size.QuadPart < sizeof(ColHeader)) {
+		colClose(r);
+
+		return ARE_RECORDING;
+	}
+
+	r->size = (size_t) size.QuadPart;
+	r->mapping = CreateFileMappingW(r->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	r->base = r->mapping ? MapViewOfFile(r->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (!r->base) {
+		colClose(r);
+
+		return ARE_FILE;
+	}
+
+	r->header = (const ColHeader*) r->base;
+	r->columns = (const ColDesc*) (r->header + 1);
+
+	const ColHeader* h = r->header;
+
+	if (h->magic != COL_MAGIC || h->format != COL_FORMAT_VERSION ||
+		h->columns > (r->size - sizeof(*h)) / sizeof(ColDesc)) {
+		colClose(r);
+
+		return ARE_RECORDING;
+	}
+
+	// every block must lie within the file. Rows are read at their offset from
+	// the first block, so the blocks must also follow each other and hold
+	// every row between them
+	for (uint32_t i = 0; i < h->columns; i++) {
+		const ColDesc* d = &r->columns[i];
+
+		if (d->table > r->size || d->blocks > (r->size - d->table) / sizeof(ColBlock)) {
+			colClose(r);
+
+			return ARE_RECORDING;
+		}
+
+		const ColBlock* blocks = colBlocks(r, d);
+		size_t rowSize = typeSize(d->type) * d->width;
+		uint64_t rows = 0;
+
+		for (uint32_t j = 0; j < d->blocks; j++) {
+			const ColBlock* b = &blocks[j];
+
+			if (b->offset > r->size || b->bytes > r->size - b->offset ||
+				b->encoding != COL_RAW || b->bytes != b->rows * rowSize ||
+				b->offset != blocks[0].offset + rows * rowSize) {
+				colClose(r);
+
+				return ARE_RECORDING;
+			}
+
+			rows += b->rows;
+		}
+
+		if (rows != h->rows || (d->pyramid && !pyramidValid(r, d))) {
+			colClose(r);
+
+			return ARE_RECORDING;
+		}
+	}
+
+	*out = r;
+
+	return 0;
+}
+
+/**
+ * Find a column by name.
+ * @return NULL if there is no such column.
+ */
+const ColDesc* colFind(const ColReader* r, const char* name) {
+	for (uint32_t i = 0; i < r->header->columns; i++) {
+		if (strncmp(r->columns[i].name, name, COL_NAME_SIZE) == 0) {
+			return &r->columns[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Block table of a column (d->blocks entries).
+ */
+const ColBlock* colBlocks(const ColReader* r, const ColDesc* d) {
+	return (const ColBlock*) (r->base + d->table);
+}
+
+/**
+ * Values of a block, read in place.
+ */
+const void* colBlockData(const ColReader* r, const ColBlock* b) {
+	return r->base + b->offset;
+}
+
+/**
+ * Summarise rows first to last (exclusive) of a lane of a column into buckets
+ * equal ranges, such as one per pixel of a plot. Reads O(buckets) pyramid
+ * entries regardless of the number of rows: each bucket is built from the
+ * coarsest level whose entries are at most a quarter of its width, or from
+ * the values themselves when buckets are narrower than that. Entries are
+ * assigned to the bucket their first row falls in.
+ * @param  r
+ * @param  d
+ * @param  lane    Value of the row, less than d->width.
+ * @param  first
+ * @param  last
+ * @param  buckets
+ * @param  out     buckets summaries.
+ * @return         Buckets filled: fewer than buckets if the range holds fewer rows.
+ */
+uint32_t colSummarise(const ColReader* r, const ColDesc* d, uint8_t lane, uint64_t first, uint64_t last,
+	uint32_t buckets, ColSummary* out) {
+	uint64_t rows = r->header->rows;
+	const ColLevel* level = NULL;
+
+	last = last < rows ? last : rows;
+
+	if (first >= last || buckets == 0 || lane >= d->width || d->blocks == 0) {
+		return 0;
+	}
+
+	if (last - first < buckets) {
+		buckets = (uint32_t) (last - first);
+	}
+
+	uint64_t width = (last - first) / buckets;
+
+	if (d->pyramid) {
+		const ColPyramid* p = (const ColPyramid*) (r->base + d->pyramid);
+		const ColLevel* levels = (const ColLevel*) (p + 1);
+
+		for (uint32_t i = 0; i < p->levels && levels[i].rows * COL_PYRAMID_FANOUT <= width; i++) {
+			level = &levels[i];
+		}
+	}
+
+	const uint8_t* values = colBlockData(r, &colBlocks(r, d)[0]);
+	const ColSummary* entries = level ? (const ColSummary*) (r->base + level->offset) : NULL;
+
+	for (uint32_t i = 0; i < buckets; i++) {
+		uint64_t lo = first + (last - first) * i / buckets;
+		uint64_t hi = first + (last - first) * (i + 1) / buckets;
+		struct summary s;
+
+		summaryStart(&s);
+
+		if (entries) {
+			uint64_t e = (lo + level->rows - 1) / level->rows;
+
+			// the first bucket also takes the entry it starts inside of
+			if (i == 0) {
+				e = lo / level->rows;
+			}
+
+			for (; e * level->rows < hi && e < level->entries; e++) {
+				summaryMerge(&s, &entries[e * d->width + lane]);
+			}
+		} else {
+			for (uint64_t row = lo; row < hi; row++) {
+				summaryAdd(&s, valueAt(values, d->type, (size_t) (row * d->width + lane)));
+			}
+		}
+
+		summaryEnd(&s, &out[i]);
+	}
+
+	return buckets;
+}
+
+/**
+ * Unmap and close a column file. Does nothing if r is NULL.
+ */
+void colClose(ColReader* r) {
+	if (!r) {
+		return;
+	}
+
+	if (r->base) {
+		UnmapViewOfFile(r->base);
+	}
+
+	if (r->mapping) {
+		CloseHandle(r->mapping);
+	}
+
+	if (r->file) {
+		CloseHandle(r->file);
+	}
+
+	free(r);
+}
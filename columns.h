@@ -0,0 +1,214 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "recording.h"
+
+// "ACOL" read as a little endian integer
+#define COL_MAGIC 0x4C4F4341
+
+// version of the container; 2 added the pyramids
+#define COL_FORMAT_VERSION 2
+
+// rows per block. Each block carries the min and max of its values
+#define COL_BLOCK_ROWS 4096
+
+// rows summarised by each entry of the finest pyramid level, and entries of
+// a level summarised by each entry of the next
+#define COL_PYRAMID_ROWS 16
+#define COL_PYRAMID_FANOUT 4
+
+// enough levels for 2^64 rows
+#define COL_PYRAMID_LEVELS 32
+
+#define COL_NAME_SIZE 24
+
+// exported fields: source block, struct, and member. Every member is made of
+// 4 byte values; arrays become a column whose rows hold every element
+#define COLUMNS(X) \
+	X(REC_BLOCK_PHYSICS, Physics, accelerator, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, brake, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, clutch, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, steering, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, gear, COL_I32) \
+	X(REC_BLOCK_PHYSICS, Physics, rpm, COL_I32) \
+	X(REC_BLOCK_PHYSICS, Physics, speed, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, fuelRemaining, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, brakeBias, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, velocityVector, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, accelerationVector, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, wheelSlip, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, tyrePressure, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, tyreCoreTemp, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, tyreWear, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, suspensionTravel, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, brakeTemp, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, padDepth, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, rotorDepth, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, carDamage, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, tcIntervention, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, absIntervention, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, ambientTemp, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, trackTemp, COL_F32) \
+	X(REC_BLOCK_PHYSICS, Physics, waterTemp, COL_F32) \
+	X(REC_BLOCK_HUD, HUD, session, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, sessionIndex, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, completedLaps, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, position, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, currLapTime, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, currSectorIndex, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, normalizedCarPosition, COL_F32) \
+	X(REC_BLOCK_HUD, HUD, distanceTraveled, COL_F32) \
+	X(REC_BLOCK_HUD, HUD, isInPitLane, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, isValidLap, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, delta, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, tc, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, abs, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, engineMap, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, fuelUsed, COL_F32) \
+	X(REC_BLOCK_HUD, HUD, trackGrip, COL_I32) \
+	X(REC_BLOCK_HUD, HUD, rainIntensityCurr, COL_I32)
+
+// value types
+enum colType {
+	COL_U64 = 1,
+	COL_I32,
+	COL_F32
+};
+
+// how a block's values are stored
+enum colEncoding {
+	COL_RAW = 0
+};
+
+// column ids: the shared time stamps followed by the exported fields
+#define X(s, t, m, ty) COLUMN_##m,
+enum column {
+	COLUMN_TIME = 0,
+	COLUMNS(X)
+	COLUMN_COUNT
+};
+#undef X
+
+/**
+ * Start of a column file. Followed by a ColDesc per column.
+ */
+typedef struct colHeader {
+	uint32_t magic;
+	uint16_t format;
+
+	// REC_LAYOUT_VERSION of the recordings the columns were taken from
+	uint16_t layout;
+
+	uint64_t rows;
+	uint32_t blockRows;
+	uint32_t columns;
+
+	// wall clock time the time column is relative to (FILETIME)
+	uint64_t start;
+} ColHeader;
+
+/**
+ * Describes a column and locates its block table.
+ */
+typedef struct colDesc {
+	char name[COL_NAME_SIZE];
+	uint8_t type;
+
+	// values per row
+	uint8_t width;
+	uint16_t reserved;
+	uint32_t blocks;
+
+	// offset of blocks ColBlocks; the blocks of a column are contiguous
+	uint64_t table;
+
+	// offset of the ColPyramid, zero for the time column
+	uint64_t pyramid;
+} ColDesc;
+
+/**
+ * Locates a block of rows and summarises its values.
+ */
+typedef struct colBlock {
+	uint64_t offset;
+	uint32_t rows;
+	uint32_t bytes;
+	uint16_t encoding;
+	uint16_t reserved;
+	uint32_t reserved2;
+
+	// over every value of every row in the block
+	double min;
+	double max;
+} ColBlock;
+
+/**
+ * Start of a column's pyramid. Followed by levels ColLevels, finest first.
+ */
+typedef struct colPyramid {
+	uint32_t levels;
+	uint32_t reserved;
+} ColPyramid;
+
+/**
+ * A level of a pyramid: entries * width ColSummaries, the summaries of
+ * every value of a row (lane) next to each other.
+ */
+typedef struct colLevel {
+	uint64_t offset;
+	uint64_t entries;
+
+	// rows summarised by each entry; the last entry may hold fewer
+	uint64_t rows;
+} ColLevel;
+
+/**
+ * Summary of the values of a lane over a range of rows. NaNs are ignored;
+ * without values min is +inf, max is -inf, and mean is NaN.
+ */
+typedef struct colSummary {
+	float min;
+	float max;
+	float mean;
+	uint32_t count;
+} ColSummary;
+
+/**
+ * Column values gathered in memory until they are written.
+ */
+struct colBuffer {
+	uint8_t* data;
+	size_t size;
+	size_t cap;
+};
+
+typedef struct colBuilder {
+	uint64_t rows;
+	uint64_t start;
+	struct colBuffer columns[COLUMN_COUNT];
+} ColBuilder;
+
+/**
+ * Read only view of a mapped column file.
+ */
+typedef struct colReader {
+	HANDLE file;
+	HANDLE mapping;
+	const uint8_t* base;
+	size_t size;
+	const ColHeader* header;
+	const ColDesc* columns;
+} ColReader;
+
+ColBuilder* createColBuilder(uint64_t);
+bool colAppend(ColBuilder*, uint64_t, const Physics*, const HUD*);
+bool colWrite(const ColBuilder*, FILE*);
+void freeColBuilder(ColBuilder*);
+int colOpen(const char*, ColReader**);
+const ColDesc* colFind(const ColReader*, const char*);
+const ColBlock* colBlocks(const ColReader*, const ColDesc*);
+const void* colBlockData(const ColReader*, const ColBlock*);
+uint32_t colSummarise(const ColReader*, const ColDesc*, uint8_t, uint64_t, uint64_t, uint32_t, ColSummary*);
+void colClose(ColReader*);
+
+#endif
@@ -7,8 +7,8 @@
  */
 int getHandlerText(InstanceData* data) {
 	// free the current pointers
-	free(data->channel);
-	free(data->password);
+	areFree(data->channel);
+	areFree(data->password);
 
 	// copy the input from the password handle into a useable buffer
 	// GetWindowTextW will truncate and append the the wide null terminator
@@ -2,10 +2,13 @@
 #define DELTA_H
 
 #include "tracked.h"
+#include "session.h"
+#include "dict.h"
 #include "shared_mem.h"
+#include "tracing.h"
 
 #define JSON_BUF_SIZE 2048
 
-char* deltaJSON(SharedMem*, Tracked*, bool);
+char* deltaJSON(SharedMem*, Tracked*, const Session*, bool);
 
 #endif
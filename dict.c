@@ -0,0 +1,166 @@
+#include "dict.h"
+
+// the dictionary serialised once at startup along with its version
+static char* raw = NULL;
+static uint32_t version = 0;
+
+/**
+ * FNV-1a over a string.
+ */
+static uint32_t hashStr(const char* str) {
+	uint32_t hash = 2166136261u;
+
+	for (; *str; str++) {
+		hash = (hash ^ (unsigned char) *str) * 16777619u;
+	}
+
+	return hash;
+}
+
+/**
+ * Add the names of the enum values from first to last under path.
+ */
+static cJSON* addEnum(cJSON* enums, const char* path, int first, int last, const char* (*name)(int)) {
+	cJSON* obj = cJSON_AddObjectToObject(enums, path);
+
+	if (!obj) {
+		return NULL;
+	}
+
+	for (int i = first; i <= last; i++) {
+		char code[12];
+
+		snprintf(code, sizeof(code), "%d", i);
+
+		if (!cJSON_AddStringToObject(obj, code, name(i))) {
+			return NULL;
+		}
+	}
+
+	return obj;
+}
+
+// adapters for addEnum
+static const char* sessionName(int i) {
+	return strSession((SessionType) i);
+}
+
+static const char* rainName(int i) {
+	return strRain((RainIntensity) i);
+}
+
+static const char* gripName(int i) {
+	return strTrackGrip((TrackGrip) i);
+}
+
+/**
+ * Build the dictionary: short key to path for every field and sub-object, and
+ * code to name for every enum sent as a code.
+ */
+static cJSON* createDict() {
+	cJSON* dict = cJSON_CreateObject();
+
+	if (!dict) {
+		return NULL;
+	}
+
+	cJSON* fields = cJSON_AddObjectToObject(dict, "fields");
+	cJSON* objects = cJSON_AddObjectToObject(dict, "objects");
+	cJSON* enums = cJSON_AddObjectToObject(dict, "enums");
+
+	if (!fields || !objects || !enums) {
+		RET_NULL(dict);
+	}
+
+	for (int i = 0; i < FIELD_COUNT; i++) {
+		if (!cJSON_AddStringToObject(fields, fieldShortKeys[i], fieldPath((enum field) i))) {
+			RET_NULL(dict);
+		}
+	}
+
+	for (int i = 0; i < OBJECT_COUNT; i++) {
+		if (!cJSON_AddStringToObject(objects, objectShortKeys[i], objectPath((enum object) i))) {
+			RET_NULL(dict);
+		}
+	}
+
+	if (!addEnum(enums, fieldPath(FLD_SESSION_TYPE), ST_UNKNOWN, ST_SUPERPOLE, &sessionName) ||
+		!addEnum(enums, fieldPath(FLD_CONDITIONS_TRACK), TG_GREEN, TG_FLOODED, &gripName) ||
+		!addEnum(enums, objectPath(OBJ_CONDITIONS_RAIN), R_NONE, R_THUNDERSTORM, &rainName)) {
+		RET_NULL(dict);
+	}
+
+	return dict;
+}
+
+/**
+ * Build and serialise the compact mode dictionary. The version is a hash of
+ * its contents so it only changes when fields, keys, or enums change.
+ * Must be called after fieldsInit().
+ * @return False if out of memory.
+ */
+bool dictInit() {
+	cJSON* dict = createDict();
+
+	if (!dict) {
+		return false;
+	}
+
+	char* str = cJSON_PrintUnformatted(dict);
+
+	if (!str) {
+		cJSON_Delete(dict);
+
+		return false;
+	}
+
+	version = hashStr(str);
+	cJSON_free(str);
+
+	if (!cJSON_AddNumberToObject(dict, "version", version)) {
+		cJSON_Delete(dict);
+
+		return false;
+	}
+
+	raw = cJSON_PrintUnformatted(dict);
+	cJSON_Delete(dict);
+
+	return raw != NULL;
+}
+
+/**
+ * Version of the dictionary.
+ */
+uint32_t dictVersion() {
+	return version;
+}
+
+/**
+ * Add the dictionary version to a compact mode frame and, if complete is set,
+ * the dictionary itself. Does nothing unless compact mode is in use.
+ * @param  obj
+ * @param  complete
+ * @return          NULL if out of memory (obj is deleted).
+ */
+cJSON* dictToJSON(cJSON* obj, bool complete) {
+	if (!FIELDS_COMPACT()) {
+		return obj;
+	}
+
+	INT_2_OBJ(obj, DICT_VERSION_KEY, version);
+
+	if (complete && !cJSON_AddRawToObject(obj, DICT_KEY, raw)) {
+		RET_NULL(obj);
+	}
+
+	return obj;
+}
+
+/**
+ * Free the serialised dictionary.
+ */
+void dictFree() {
+	cJSON_free(raw);
+	raw = NULL;
+}
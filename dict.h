@@ -0,0 +1,15 @@
+#ifndef DICT_H
+#define DICT_H
+
+#include "hud.h"
+
+// keys the dictionary and its version are sent under in compact mode
+#define DICT_KEY "dict"
+#define DICT_VERSION_KEY "_v"
+
+bool dictInit();
+uint32_t dictVersion();
+cJSON* dictToJSON(cJSON*, bool);
+void dictFree();
+
+#endif
@@ -29,6 +29,10 @@ wchar_t* errorToWstr(enum areError e) {
 		return L"Log file error";
 	case ARE_EVENT:
 		return L"Thread event error";
+	case ARE_SOCKET:
+		return L"Metrics socket error";
+	case ARE_RECORDING:
+		return L"Invalid or incompatible recording";
 	}
 
 	return L"Unknown";
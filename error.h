@@ -14,9 +14,15 @@ enum areError {
 	ARE_USER_INPUT,
 	ARE_THREAD,
 	ARE_FILE,
-	ARE_EVENT
+	ARE_EVENT,
+	ARE_SOCKET,
+	ARE_RECORDING
 };
 
+// first error code and the number of error codes
+#define ARE_ERROR_FIRST ARE_SHARED_MEM_INIT
+#define ARE_ERROR_COUNT (ARE_RECORDING - ARE_SHARED_MEM_INIT + 1)
+
 wchar_t* errorToWstr(enum areError);
 
 #endif
@@ -0,0 +1,218 @@
+#include "fields.h"
+
+#define FIELD_PATH(id, path) path,
+
+_Static_assert(FIELD_COUNT <= FIELD_WORDS * 64, "FIELD_WORDS must be raised");
+
+// full path of every field and sub-object
+static const char* paths[FIELD_COUNT] = {
+	FIELDS(FIELD_PATH)
+};
+
+static const char* objectPaths[OBJECT_COUNT] = {
+	OBJECTS(FIELD_PATH)
+};
+
+// characters short keys are made of
+static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+#define ALPHABET_LEN (sizeof(alphabet) - 1)
+
+_Static_assert(FIELD_COUNT + OBJECT_COUNT <= ALPHABET_LEN * (ALPHABET_LEN + 1), "SHORT_KEY_LEN must be raised");
+
+static const Encoding full = {{{~0ULL, ~0ULL, ~0ULL, ~0ULL}}, false};
+
+__declspec(thread) const Encoding* fieldsEncoding = &full;
+const char* fieldKeys[FIELD_COUNT];
+const char* objectKeys[OBJECT_COUNT];
+char fieldShortKeys[FIELD_COUNT][SHORT_KEY_LEN];
+char objectShortKeys[OBJECT_COUNT][SHORT_KEY_LEN];
+
+/**
+ * The last component of path.
+ */
+static const char* lastComponent(const char* path) {
+	const char* dot = strrchr(path, '.');
+
+	return dot ? dot + 1 : path;
+}
+
+/**
+ * Write the n-th short key: "a" .. "Z", then "aa", "ab" ..
+ */
+static void shortKey(int n, char* key) {
+	if (n < (int) ALPHABET_LEN) {
+		key[0] = alphabet[n];
+		key[1] = '\0';
+	} else {
+		n -= ALPHABET_LEN;
+		key[0] = alphabet[n / ALPHABET_LEN];
+		key[1] = alphabet[n % ALPHABET_LEN];
+		key[2] = '\0';
+	}
+}
+
+/**
+ * Derive the full and short keys of every field and sub-object. Short keys
+ * are unique across both so that they never collide within an object.
+ * Must be called before any other thread is started.
+ */
+void fieldsInit() {
+	for (int i = 0; i < FIELD_COUNT; i++) {
+		fieldKeys[i] = lastComponent(paths[i]);
+		shortKey(i, fieldShortKeys[i]);
+	}
+
+	for (int i = 0; i < OBJECT_COUNT; i++) {
+		objectKeys[i] = lastComponent(objectPaths[i]);
+		shortKey(FIELD_COUNT + i, objectShortKeys[i]);
+	}
+}
+
+/**
+ * Every field with full keys.
+ * @param e
+ */
+void fieldsDefault(Encoding* e) {
+	*e = full;
+}
+
+/**
+ * Subscribe m to every field.
+ * @param m
+ */
+void fieldsAll(FieldMask* m) {
+	*m = full.mask;
+}
+
+/**
+ * Subscribe m to the field f.
+ * @param m
+ * @param f
+ */
+void fieldsSet(FieldMask* m, enum field f) {
+	m->words[f >> 6] |= 1ULL << (f & 63);
+}
+
+/**
+ * Whether or not any field from first to last (inclusive) is subscribed to on
+ * this thread. Used to skip whole sub-objects.
+ * @param first
+ * @param last
+ */
+bool fieldsAny(enum field first, enum field last) {
+	for (int f = first; f <= (int) last; f++) {
+		if (FIELD_ON(f)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Whether or not two masks subscribe to the same fields.
+ * @param a
+ * @param b
+ */
+bool fieldsEqual(const FieldMask* a, const FieldMask* b) {
+	for (int i = 0; i < FIELD_WORDS; i++) {
+		if (a->words[i] != b->words[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Subscribe m to every field under path. Eg. "tyres" or "tyres.pressure".
+ * @return False if no field matched.
+ */
+static bool subscribePath(FieldMask* m, const char* path) {
+	size_t len = strlen(path);
+	bool found = false;
+
+	if (strcmp(path, "*") == 0) {
+		fieldsAll(m);
+
+		return true;
+	}
+
+	for (int i = 0; i < FIELD_COUNT; i++) {
+		if (strncmp(paths[i], path, len) == 0 && (paths[i][len] == '\0' || paths[i][len] == '.')) {
+			fieldsSet(m, (enum field) i);
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+/**
+ * Build a mask from a subscription: either "*" or an array of field paths
+ * and sub-object paths.
+ * Example:
+ * ["speed", "laptimes", "tyres.pressure"]
+ * @param  m
+ * @param  value
+ * @return       False if value is not a subscription. m is left untouched.
+ */
+bool fieldsParse(FieldMask* m, const cJSON* value) {
+	FieldMask parsed = {0};
+
+	if (cJSON_IsString(value)) {
+		if (!subscribePath(&parsed, value->valuestring)) {
+			return false;
+		}
+	} else if (cJSON_IsArray(value)) {
+		const cJSON* path = NULL;
+
+		cJSON_ArrayForEach(path, value) {
+			if (!cJSON_IsString(path)) {
+				return false;
+			}
+
+			if (!subscribePath(&parsed, path->valuestring)) {
+				// not fatal; the server may know about fields this version doesn't
+				printf("Unknown subscription: %s\n", path->valuestring);
+			}
+		}
+	} else {
+		return false;
+	}
+
+	*m = parsed;
+
+	return true;
+}
+
+/**
+ * Full path of the field f.
+ * @param f
+ */
+const char* fieldPath(enum field f) {
+	return paths[f];
+}
+
+/**
+ * Full path of the sub-object o.
+ * @param o
+ */
+const char* objectPath(enum object o) {
+	return objectPaths[o];
+}
+
+/**
+ * Build JSON for the calling thread with the encoding e (NULL for all fields
+ * with full keys).
+ * @param  e
+ * @return   The previous encoding.
+ */
+const Encoding* fieldsUse(const Encoding* e) {
+	const Encoding* prev = fieldsEncoding;
+
+	fieldsEncoding = e ? e : &full;
+
+	return prev;
+}
@@ -0,0 +1,259 @@
+#ifndef FIELDS_H
+#define FIELDS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <cjson/cJSON.h>
+
+/**
+ * Every field the publisher can send, in the order it is sent, along with its
+ * path in the broadcast body. Fields of a sub-object must be contiguous so that
+ * the sub-object can be described by its first and last field.
+ * Properties and newSession are always sent and are not listed here.
+ */
+#define FIELDS(X)\
+	X(FLD_POSITION, "position")\
+	X(FLD_DISTANCE_TRAVELED, "distanceTraveled")\
+	X(FLD_LAPS, "laps")\
+	X(FLD_TYRE_SET, "tyreSet")\
+	X(FLD_IS_BOXED, "isBoxed")\
+	X(FLD_IS_IN_PIT_LANE, "isInPitLane")\
+	X(FLD_MANDATORY_PIT_DONE, "mandatoryPitDone")\
+	X(FLD_RAIN_TYRES, "rainTyres")\
+	X(FLD_LAPTIMES_CURR, "laptimes.curr")\
+	X(FLD_LAPTIMES_ESTIMATED, "laptimes.estimated")\
+	X(FLD_LAPTIMES_PREV, "laptimes.prev")\
+	X(FLD_LAPTIMES_BEST, "laptimes.best")\
+	X(FLD_LAPTIMES_DELTA, "laptimes.delta")\
+	X(FLD_LAPTIMES_CURR_SECTOR_INDEX, "laptimes.currSectorIndex")\
+	X(FLD_LAPTIMES_CURR_SECTOR, "laptimes.currSector")\
+	X(FLD_LAPTIMES_IS_DELTA_POSITIVE, "laptimes.isDeltaPositive")\
+	X(FLD_LAPTIMES_IS_VALID_LAP, "laptimes.isValidLap")\
+	X(FLD_LAPTIMES_PREV_SECTOR, "laptimes.prevSector")\
+	X(FLD_LAPTIMES_REFERENCE_DELTA, "laptimes.referenceDelta")\
+	X(FLD_ELECTRONICS_TC, "electronics.tc")\
+	X(FLD_ELECTRONICS_TC_CUT, "electronics.tcCut")\
+	X(FLD_ELECTRONICS_ENGINE_MAP, "electronics.engineMap")\
+	X(FLD_ELECTRONICS_ABS, "electronics.abs")\
+	X(FLD_ELECTRONICS_HEADLIGHT_STATE, "electronics.headlightState")\
+	X(FLD_ELECTRONICS_WIPER_STATE, "electronics.wiperState")\
+	X(FLD_ELECTRONICS_RAIN_LIGHT, "electronics.rainLight")\
+	X(FLD_ELECTRONICS_FLASHER, "electronics.flasher")\
+	X(FLD_ELECTRONICS_LEFT_INDICATOR, "electronics.leftIndicator")\
+	X(FLD_ELECTRONICS_RIGHT_INDICATOR, "electronics.rightIndicator")\
+	X(FLD_SESSION_TYPE, "session.type")\
+	X(FLD_SESSION_TIME_LEFT, "session.timeLeft")\
+	X(FLD_SESSION_ACTIVE_CARS, "session.activeCars")\
+	X(FLD_SESSION_CLOCK, "session.clock")\
+	X(FLD_CONDITIONS_WIND_SPEED, "conditions.windSpeed")\
+	X(FLD_CONDITIONS_WIND_DIRECTION, "conditions.windDirection")\
+	X(FLD_CONDITIONS_TRACK, "conditions.track")\
+	X(FLD_CONDITIONS_RAIN_CURR, "conditions.rain.curr")\
+	X(FLD_CONDITIONS_RAIN_IN10, "conditions.rain.in10")\
+	X(FLD_CONDITIONS_RAIN_IN30, "conditions.rain.in30")\
+	X(FLD_PITSTOP_TYRE_SET, "pitstop.tyreSet")\
+	X(FLD_PITSTOP_FUEL, "pitstop.fuel")\
+	X(FLD_PITSTOP_PRESSURE_FL, "pitstop.pressure.fl")\
+	X(FLD_PITSTOP_PRESSURE_FR, "pitstop.pressure.fr")\
+	X(FLD_PITSTOP_PRESSURE_RL, "pitstop.pressure.rl")\
+	X(FLD_PITSTOP_PRESSURE_RR, "pitstop.pressure.rr")\
+	X(FLD_PENALTY_TYPE, "penalty.type")\
+	X(FLD_PENALTY_DURATION, "penalty.duration")\
+	X(FLD_DRIVING_TIME_TOTAL_REMAINING, "drivingTime.totalRemaining")\
+	X(FLD_DRIVING_TIME_STINT_REMAINING, "drivingTime.stintRemaining")\
+	X(FLD_FUEL_USED, "fuel.used")\
+	X(FLD_FUEL_RATE, "fuel.rate")\
+	X(FLD_FLAG_CURR, "flag.curr")\
+	X(FLD_FLAG_GREEN, "flag.green")\
+	X(FLD_FLAG_CHEQUERED, "flag.chequered")\
+	X(FLD_FLAG_RED, "flag.red")\
+	X(FLD_FLAG_WHITE, "flag.white")\
+	X(FLD_FLAG_YELLOW_GLOBAL, "flag.yellow.global")\
+	X(FLD_FLAG_YELLOW_SECTOR1, "flag.yellow.sector1")\
+	X(FLD_FLAG_YELLOW_SECTOR2, "flag.yellow.sector2")\
+	X(FLD_FLAG_YELLOW_SECTOR3, "flag.yellow.sector3")\
+	X(FLD_SPEED, "speed")\
+	X(FLD_GEAR, "gear")\
+	X(FLD_TC_INTERVENTION, "tcIntervention")\
+	X(FLD_ABS_INTERVENTION, "absIntervention")\
+	X(FLD_FUEL_REMAINING, "fuelRemaining")\
+	X(FLD_INPUT_ACCELERATOR, "input.accelerator")\
+	X(FLD_INPUT_BRAKE, "input.brake")\
+	X(FLD_INPUT_STEERING, "input.steering")\
+	X(FLD_INPUT_PIT_LIMITER, "input.pitLimiter")\
+	X(FLD_BRAKES_BIAS, "brakes.bias")\
+	X(FLD_BRAKES_COMPOUND_FRONT, "brakes.compound.front")\
+	X(FLD_BRAKES_COMPOUND_REAR, "brakes.compound.rear")\
+	X(FLD_BRAKES_PAD_DEPTH_FL, "brakes.padDepth.fl")\
+	X(FLD_BRAKES_PAD_DEPTH_FR, "brakes.padDepth.fr")\
+	X(FLD_BRAKES_PAD_DEPTH_RL, "brakes.padDepth.rl")\
+	X(FLD_BRAKES_PAD_DEPTH_RR, "brakes.padDepth.rr")\
+	X(FLD_BRAKES_ROTOR_DEPTH_FL, "brakes.rotorDepth.fl")\
+	X(FLD_BRAKES_ROTOR_DEPTH_FR, "brakes.rotorDepth.fr")\
+	X(FLD_BRAKES_ROTOR_DEPTH_RL, "brakes.rotorDepth.rl")\
+	X(FLD_BRAKES_ROTOR_DEPTH_RR, "brakes.rotorDepth.rr")\
+	X(FLD_BRAKES_TEMP_FL, "brakes.temp.fl")\
+	X(FLD_BRAKES_TEMP_FR, "brakes.temp.fr")\
+	X(FLD_BRAKES_TEMP_RL, "brakes.temp.rl")\
+	X(FLD_BRAKES_TEMP_RR, "brakes.temp.rr")\
+	X(FLD_TEMP_AMBIENT, "temp.ambient")\
+	X(FLD_TEMP_TRACK, "temp.track")\
+	X(FLD_MOTOR_RPM, "motor.rpm")\
+	X(FLD_MOTOR_BOOST_PRESSURE, "motor.boostPressure")\
+	X(FLD_MOTOR_RUNNING, "motor.running")\
+	X(FLD_MOTOR_STARTER, "motor.starter")\
+	X(FLD_MOTOR_IGNITION, "motor.ignition")\
+	X(FLD_TYRES_PRESSURE_FL, "tyres.pressure.fl")\
+	X(FLD_TYRES_PRESSURE_FR, "tyres.pressure.fr")\
+	X(FLD_TYRES_PRESSURE_RL, "tyres.pressure.rl")\
+	X(FLD_TYRES_PRESSURE_RR, "tyres.pressure.rr")\
+	X(FLD_TYRES_TEMP_FL, "tyres.temp.fl")\
+	X(FLD_TYRES_TEMP_FR, "tyres.temp.fr")\
+	X(FLD_TYRES_TEMP_RL, "tyres.temp.rl")\
+	X(FLD_TYRES_TEMP_RR, "tyres.temp.rr")\
+	X(FLD_DAMAGE_FRONT, "damage.front")\
+	X(FLD_DAMAGE_REAR, "damage.rear")\
+	X(FLD_DAMAGE_LEFT, "damage.left")\
+	X(FLD_DAMAGE_RIGHT, "damage.right")\
+	X(FLD_DAMAGE_CENTRE, "damage.centre")\
+	X(FLD_LAP_SUMMARY_LAP, "lapSummary.lap")\
+	X(FLD_LAP_SUMMARY_TIME, "lapSummary.time")\
+	X(FLD_LAP_SUMMARY_PARTIAL, "lapSummary.partial")\
+	X(FLD_LAP_SUMMARY_FUEL_USED, "lapSummary.fuelUsed")\
+	X(FLD_LAP_SUMMARY_MAX_SPEED, "lapSummary.maxSpeed")\
+	X(FLD_LAP_SUMMARY_TC_TIME, "lapSummary.tcTime")\
+	X(FLD_LAP_SUMMARY_ABS_TIME, "lapSummary.absTime")\
+	X(FLD_LAP_SUMMARY_TYRE_PRESSURE, "lapSummary.tyrePressure")\
+	X(FLD_LAP_SUMMARY_TYRE_TEMP, "lapSummary.tyreTemp")\
+	X(FLD_LAP_SUMMARY_BRAKE_TEMP, "lapSummary.brakeTemp")\
+	X(FLD_MINI_SECTORS_TIMES, "miniSectors.times")\
+	X(FLD_MINI_SECTORS_BEST, "miniSectors.best")\
+	X(FLD_MINI_SECTORS_THEORETICAL_BEST, "miniSectors.theoreticalBest")\
+	X(FLD_LAP_TRACE_LAP, "lapTrace.lap")\
+	X(FLD_LAP_TRACE_PARTIAL, "lapTrace.partial")\
+	X(FLD_LAP_TRACE_DATA, "lapTrace.data")\
+	X(FLD_TRACK_MAP_POINTS, "trackMap.points")\
+	X(FLD_TRACK_MAP_DATA, "trackMap.data")\
+	X(FLD_CAR_POSITIONS, "carPositions")\
+	X(FLD_PROXIMITY_AHEAD, "proximity.ahead")\
+	X(FLD_PROXIMITY_BEHIND, "proximity.behind")\
+	X(FLD_PROXIMITY_CARS, "proximity.cars")
+
+/**
+ * Every sub-object the fields above are grouped in along with its path.
+ */
+#define OBJECTS(X)\
+	X(OBJ_LAPTIMES, "laptimes")\
+	X(OBJ_ELECTRONICS, "electronics")\
+	X(OBJ_SESSION, "session")\
+	X(OBJ_CONDITIONS, "conditions")\
+	X(OBJ_CONDITIONS_RAIN, "conditions.rain")\
+	X(OBJ_PITSTOP, "pitstop")\
+	X(OBJ_PITSTOP_PRESSURE, "pitstop.pressure")\
+	X(OBJ_PENALTY, "penalty")\
+	X(OBJ_DRIVING_TIME, "drivingTime")\
+	X(OBJ_FUEL, "fuel")\
+	X(OBJ_FLAG, "flag")\
+	X(OBJ_FLAG_YELLOW, "flag.yellow")\
+	X(OBJ_INPUT, "input")\
+	X(OBJ_BRAKES, "brakes")\
+	X(OBJ_BRAKES_COMPOUND, "brakes.compound")\
+	X(OBJ_BRAKES_PAD_DEPTH, "brakes.padDepth")\
+	X(OBJ_BRAKES_ROTOR_DEPTH, "brakes.rotorDepth")\
+	X(OBJ_BRAKES_TEMP, "brakes.temp")\
+	X(OBJ_TEMP, "temp")\
+	X(OBJ_MOTOR, "motor")\
+	X(OBJ_TYRES, "tyres")\
+	X(OBJ_TYRES_PRESSURE, "tyres.pressure")\
+	X(OBJ_TYRES_TEMP, "tyres.temp")\
+	X(OBJ_DAMAGE, "damage")\
+	X(OBJ_LAP_SUMMARY, "lapSummary")\
+	X(OBJ_MINI_SECTORS, "miniSectors")\
+	X(OBJ_LAP_TRACE, "lapTrace")\
+	X(OBJ_TRACK_MAP, "trackMap")\
+	X(OBJ_PROXIMITY, "proximity")
+
+#define FIELD_ENUM(id, path) id,
+
+enum field {
+	FIELDS(FIELD_ENUM)
+	FIELD_COUNT
+};
+
+enum object {
+	OBJECTS(FIELD_ENUM)
+	OBJECT_COUNT
+};
+
+// longest short key including the null terminator
+#define SHORT_KEY_LEN 3
+
+// 64 fields per word; raise when FIELD_COUNT exceeds 64 * FIELD_WORDS
+#define FIELD_WORDS 4
+
+/**
+ * One bit per field. Set bits are sent, clear bits are neither compared
+ * nor serialised.
+ */
+typedef struct fieldMask {
+	uint64_t words[FIELD_WORDS];
+} FieldMask;
+
+/**
+ * How fields are encoded for a server: which ones are sent, and whether they
+ * are sent with short keys and enums as integer codes (compact) or with their
+ * full keys and enums as strings.
+ */
+typedef struct encoding {
+	FieldMask mask;
+	bool compact;
+} Encoding;
+
+// encoding of the JSON being built on this thread (all fields, full keys by default)
+extern __declspec(thread) const Encoding* fieldsEncoding;
+
+// full (last path component) and short keys; set by fieldsInit()
+extern const char* fieldKeys[FIELD_COUNT];
+extern const char* objectKeys[OBJECT_COUNT];
+extern char fieldShortKeys[FIELD_COUNT][SHORT_KEY_LEN];
+extern char objectShortKeys[OBJECT_COUNT][SHORT_KEY_LEN];
+
+/**
+ * Whether or not the field f is set in the mask m.
+ */
+#define FIELD_TEST(m, f) (((m)->words[(f) >> 6] >> ((f) & 63)) & 1)
+
+/**
+ * Whether or not the field f is subscribed to on this thread.
+ */
+#define FIELD_ON(f) FIELD_TEST(&fieldsEncoding->mask, f)
+
+/**
+ * Whether or not short keys and enum codes are used on this thread.
+ */
+#define FIELDS_COMPACT() (fieldsEncoding->compact)
+
+/**
+ * The JSON key of the field f.
+ */
+#define FIELD_KEY(f) (FIELDS_COMPACT() ? fieldShortKeys[f] : fieldKeys[f])
+
+/**
+ * The JSON key of the sub-object o.
+ */
+#define OBJECT_KEY(o) (FIELDS_COMPACT() ? objectShortKeys[o] : objectKeys[o])
+
+void fieldsInit();
+void fieldsDefault(Encoding*);
+void fieldsAll(FieldMask*);
+void fieldsSet(FieldMask*, enum field);
+bool fieldsAny(enum field, enum field);
+bool fieldsEqual(const FieldMask*, const FieldMask*);
+bool fieldsParse(FieldMask*, const cJSON*);
+const char* fieldPath(enum field);
+const char* objectPath(enum object);
+const Encoding* fieldsUse(const Encoding*);
+
+#endif
@@ -0,0 +1,53 @@
+#include "group.h"
+
+// per-thread for the same reason as the allocation counters
+static __declspec(thread) GroupStats stats;
+
+/**
+ * Whether or not any of the fields covered by spans differ between curr and prev.
+ * Bitwise equality is stricter than the comparisons made while building so a
+ * changed group may still end up empty, but an unchanged one always would.
+ * @param  curr
+ * @param  prev  NULL for a complete frame.
+ * @param  spans NULL if the group must always be built.
+ */
+bool groupChanged(const void* curr, const void* prev, const struct span* spans) {
+	if (!prev || !spans) {
+		return true;
+	}
+
+	const unsigned char* a = curr;
+	const unsigned char* b = prev;
+
+	for (const struct span* s = spans; s->size; s++) {
+		if (memcmp(a + s->offset, b + s->offset, s->size) != 0) {
+			stats.misses++;
+
+			return true;
+		}
+	}
+
+	stats.hits++;
+
+	return false;
+}
+
+/**
+ * The calling thread's counters.
+ */
+const GroupStats* groupStats() {
+	return &stats;
+}
+
+/**
+ * Write the calling thread's hit rate to stdout (log.txt in release builds).
+ */
+void groupPrint() {
+	uint64_t total = stats.hits + stats.misses;
+
+	printf("Groups: %llu skipped, %llu built (%.1f%% skipped)\n",
+		(unsigned long long) stats.hits, (unsigned long long) stats.misses,
+		total ? 100.0 * (double) stats.hits / (double) total : 0.0);
+
+	fflush(stdout);
+}
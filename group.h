@@ -0,0 +1,42 @@
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * A run of bytes in a source struct (HUD or Physics) that a JSON group is
+ * built from. Span lists are terminated by an entry with a size of zero.
+ */
+struct span {
+	size_t offset;
+	size_t size;
+};
+
+/**
+ * Span covering the member m of the struct type t.
+ * Example:
+ * static const struct span fuelSpans[] = {SPAN(HUD, fuelUsed), SPAN(HUD, fuelPerLap), {0}};
+ */
+#define SPAN(t, m) {offsetof(t, m), sizeof(((t*) 0)->m)}
+
+/**
+ * Counts of groups skipped and built on the calling thread. Complete frames
+ * (no previous frame) are not counted.
+ */
+typedef struct groupStats {
+	// skipped because none of the source fields changed
+	uint64_t hits;
+
+	// built because at least one source field changed
+	uint64_t misses;
+} GroupStats;
+
+bool groupChanged(const void*, const void*, const struct span*);
+const GroupStats* groupStats();
+void groupPrint();
+
+#endif
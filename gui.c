@@ -267,13 +267,20 @@ static LRESULT infoHandler(HWND wnd, UINT msg, WPARAM w, LPARAM l) {
 	swprintf(buf, MSG_BOX_BUF_SIZE,
 		L"Server URL: %hs\n"
 		L"Sample frequency: %dHz\n"
+		L"Catch up missed samples: %d\n"
 		L"Debug mode: %d\n"
 		L"Broadcasting disabled: %d\n"
 		L"Record data: %d\n"
 		L"Curl skip peer verification: %d\n"
+		L"Metrics port (0 = off): %d\n"
 		L"Version: %d.%d.%d\n",
 		API_URL,
-		1000 / MAX_LOOP_TIME,
+		SAMPLE_RATE,
+	#ifdef CATCH_UP_MISSED
+		true,
+	#else
+		false,
+	#endif
 	#ifdef DEBUG
 		true,
 	#else
@@ -293,6 +300,11 @@ static LRESULT infoHandler(HWND wnd, UINT msg, WPARAM w, LPARAM l) {
 		true,
 	#else
 		false,
+	#endif
+	#ifdef METRICS
+		METRICS_PORT,
+	#else
+		0,
 	#endif
 		ARE_VERSION_MAJOR,
 		ARE_VERSION_MINOR,
@@ -453,8 +465,10 @@ static int dispatch(HWND wnd, MSG* msg) {
 		if (result > 0) {
 			// not WM_QUIT
 			// message received; dispatch and process it
+			TRACE_BEGIN(span, "dispatch");
 			TranslateMessage(msg);
 			DispatchMessage(msg);
+			TRACE_END(span);
 		}
 
 		return result;
@@ -553,6 +567,8 @@ static void messageLoop(HWND wnd, InstanceData* data) {
  * @param  cmdShow
  */
 void gui(HINSTANCE h, int cmdShow, InstanceData* data) {
+	TRACE_THREAD("gui");
+
 	HWND wnd = init(h, data);
 
 	if (!wnd) {
@@ -1,9 +1,14 @@
 #include "hud.h"
 
-// struct grouping together the json key and the function that creates the json object.
+// struct grouping together the json key, the function that creates the json object,
+// the fields the object is built from (NULL to always build it), and the range of
+// fields the object contains.
 struct item {
-	char* key;
+	enum object key;
 	cJSON* (*create)(const HUD*, const HUD*);
+	const struct span* spans;
+	enum field first;
+	enum field last;
 };
 
 // for no apparent reason, kunos have decided to set invalid laptime values
@@ -28,36 +33,38 @@ static cJSON* createLaptimes(const HUD* curr, const HUD* prev) {
 
 	// always add the current lap time
 	// it's always increasing, even when the car is in the pits
-	INT_2_OBJ(obj, "curr", curr->currLapTime);
+	if (FIELD_ON(FLD_LAPTIMES_CURR)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAPTIMES_CURR), curr->currLapTime);
+	}
 
 	// always add the estimated lap time
 	// prevent adding bogus values greater than MAX_TIME
-	if (curr->estimatedLapTime < MAX_TIME) {
-		INT_2_OBJ(obj, "estimated", curr->estimatedLapTime);
+	if (FIELD_ON(FLD_LAPTIMES_ESTIMATED) && curr->estimatedLapTime < MAX_TIME) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAPTIMES_ESTIMATED), curr->estimatedLapTime);
 	}
 
 	// only add the previous laptime if prev is not NULL
-	if (prev) {
+	if (prev && FIELD_ON(FLD_LAPTIMES_PREV)) {
 		if (curr->completedLaps > prev->completedLaps) {
 			// new lap started
 			// this should never be a bogus value because it is only added when
 			// completedLaps differs (and therefore this should be set appropriately)
-			INT_2_OBJ(obj, "prev", curr->prevLapTime);
+			INT_2_OBJ(obj, FIELD_KEY(FLD_LAPTIMES_PREV), curr->prevLapTime);
 		}
 	}
 
 	// prevent adding bogus values greater than MAX_TIME
 	if (curr->bestLapTime < MAX_TIME) {
-		INT_2_OBJ_CMP(obj, "best", prev, prev->bestLapTime, curr->bestLapTime);
+		INT_2_OBJ_CMP(obj, FLD_LAPTIMES_BEST, prev, prev->bestLapTime, curr->bestLapTime);
 	}
 
-	INT_2_OBJ_CMP(obj, "delta", prev, prev->delta, curr->delta);
+	INT_2_OBJ_CMP(obj, FLD_LAPTIMES_DELTA, prev, prev->delta, curr->delta);
 
-	INT_2_OBJ_CMP(obj, "currSectorIndex", prev, prev->currSectorIndex, curr->currSectorIndex);
-	INT_2_OBJ_CMP(obj, "currSector", prev, prev->currSectorTime, curr->currSectorTime);
+	INT_2_OBJ_CMP(obj, FLD_LAPTIMES_CURR_SECTOR_INDEX, prev, prev->currSectorIndex, curr->currSectorIndex);
+	INT_2_OBJ_CMP(obj, FLD_LAPTIMES_CURR_SECTOR, prev, prev->currSectorTime, curr->currSectorTime);
 
-	BOOL_2_OBJ_CMP(obj, "isDeltaPositive", prev, prev->isDeltaPositive, curr->isDeltaPositive);
-	BOOL_2_OBJ_CMP(obj, "isValidLap", prev, prev->isValidLap, curr->isValidLap);
+	BOOL_2_OBJ_CMP(obj, FLD_LAPTIMES_IS_DELTA_POSITIVE, prev, prev->isDeltaPositive, curr->isDeltaPositive);
+	BOOL_2_OBJ_CMP(obj, FLD_LAPTIMES_IS_VALID_LAP, prev, prev->isValidLap, curr->isValidLap);
 
 	return obj;
 }
@@ -76,18 +83,18 @@ static cJSON* createElectronics(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "tc", prev, prev->tc, curr->tc);
-	INT_2_OBJ_CMP(obj, "tcCut", prev, prev->tcCut, curr->tcCut);
-	INT_2_OBJ_CMP(obj, "engineMap", prev, prev->engineMap, curr->engineMap);
-	INT_2_OBJ_CMP(obj, "abs", prev, prev->abs, curr->abs);
-	INT_2_OBJ_CMP(obj, "headlightState", prev, prev->headlightState, curr->headlightState);
-	INT_2_OBJ_CMP(obj, "wiperState", prev, prev->wiperState, curr->wiperState);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_TC, prev, prev->tc, curr->tc);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_TC_CUT, prev, prev->tcCut, curr->tcCut);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_ENGINE_MAP, prev, prev->engineMap, curr->engineMap);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_ABS, prev, prev->abs, curr->abs);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_HEADLIGHT_STATE, prev, prev->headlightState, curr->headlightState);
+	INT_2_OBJ_CMP(obj, FLD_ELECTRONICS_WIPER_STATE, prev, prev->wiperState, curr->wiperState);
 
-	BOOL_2_OBJ_CMP(obj, "rainLight", prev, prev->rainLight, curr->rainLight);
-	BOOL_2_OBJ_CMP(obj, "flasher", prev, prev->flasher, curr->flasher);
+	BOOL_2_OBJ_CMP(obj, FLD_ELECTRONICS_RAIN_LIGHT, prev, prev->rainLight, curr->rainLight);
+	BOOL_2_OBJ_CMP(obj, FLD_ELECTRONICS_FLASHER, prev, prev->flasher, curr->flasher);
 
-	BOOL_2_OBJ_CMP(obj, "leftIndicator", prev, prev->leftIndicator, curr->leftIndicator);
-	BOOL_2_OBJ_CMP(obj, "rightIndicator", prev, prev->rightIndicator, curr->rightIndicator);
+	BOOL_2_OBJ_CMP(obj, FLD_ELECTRONICS_LEFT_INDICATOR, prev, prev->leftIndicator, curr->leftIndicator);
+	BOOL_2_OBJ_CMP(obj, FLD_ELECTRONICS_RIGHT_INDICATOR, prev, prev->rightIndicator, curr->rightIndicator);
 
 	return obj;
 }
@@ -105,78 +112,44 @@ static cJSON* createSession(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	if (!prev || prev->session != curr->session) {
-		char* str;
-
-		switch (curr->session) {
-			case ST_PRACTICE:
-				str = "Practice";
-				break;
-			case ST_QUALIFY:
-				str = "Qualifying";
-				break;
-			case ST_RACE:
-				str = "Race";
-				break;
-			case ST_HOTLAP:
-				str = "Hot Lap";
-				break;
-			case ST_HOTSTINT:
-				str = "Hot Stint";
-				break;
-			case ST_SUPERPOLE:
-				str = "Super Pole";
-				break;
-			default:
-				str = "Unknown";
-		}
-
-		if (!cJSON_AddStringToObject(obj, "type", str)) {
+	if (FIELD_ON(FLD_SESSION_TYPE) && (!prev || prev->session != curr->session)) {
+		if (FIELDS_COMPACT()) {
+			INT_2_OBJ(obj, FIELD_KEY(FLD_SESSION_TYPE), curr->session);
+		} else if (!cJSON_AddStringToObject(obj, FIELD_KEY(FLD_SESSION_TYPE), strSession(curr->session))) {
 			RET_NULL(obj);
 		}
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "timeLeft", prev, prev->sessionTimeLeft, curr->sessionTimeLeft);
-	INT_2_OBJ_CMP(obj, "activeCars", prev, prev->activeCars, curr->activeCars);
-	FLOAT_2_OBJ_CMP(obj, "clock", prev, prev->clock, curr->clock);
+	FLOAT_2_OBJ_CMP(obj, FLD_SESSION_TIME_LEFT, prev, prev->sessionTimeLeft, curr->sessionTimeLeft);
+	INT_2_OBJ_CMP(obj, FLD_SESSION_ACTIVE_CARS, prev, prev->activeCars, curr->activeCars);
+	FLOAT_2_OBJ_CMP(obj, FLD_SESSION_CLOCK, prev, prev->clock, curr->clock);
 
 	return obj;
 }
 
 /**
- * Determine the rain intensity level and embed the corresponding string
- * in obj under key.
+ * Embed the rain intensity level in obj under key; as a string or as
+ * its code in compact mode.
  *
  * @param ri
  * @param obj
  * @param key
  */
-static cJSON* rainIntensity(RainIntensity ri, cJSON* obj, char* key) {
-	char* str;
+static cJSON* rainIntensity(RainIntensity ri, cJSON* obj, const char* key) {
+	if (FIELDS_COMPACT()) {
+		return cJSON_AddNumberToObject(obj, key, ri);
+	}
 
-	switch (ri) {
-		case R_DRIZZLE:
-			str = "Drizzle";
-			break;
-		case R_LIGHT:
-			str = "Light";
-			break;
-		case R_MEDIUM:
-			str = "Medium";
-			break;
-		case R_HEAVY:
-			str = "Heavy";
-			break;
-		case R_THUNDERSTORM:
-			str = "Thunderstorm";
-			break;
-		default:
-			str = "None";
-	}
-
-	return cJSON_AddStringToObject(obj, key, str);
+	return cJSON_AddStringToObject(obj, key, strRain(ri));
 }
 
+static const struct span rainSpans[] = {
+	SPAN(HUD, rainIntensityCurr),
+	SPAN(HUD, rainIntensity10),
+	SPAN(HUD, rainIntensity30),
+	{0}
+};
+
 /**
  * curr, in10, in30.
  *
@@ -190,20 +163,20 @@ static cJSON* createRain(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	if (!prev || prev->rainIntensityCurr != curr->rainIntensityCurr) {
-		if (!rainIntensity(curr->rainIntensityCurr, obj, "curr")) {
+	if (FIELD_ON(FLD_CONDITIONS_RAIN_CURR) && (!prev || prev->rainIntensityCurr != curr->rainIntensityCurr)) {
+		if (!rainIntensity(curr->rainIntensityCurr, obj, FIELD_KEY(FLD_CONDITIONS_RAIN_CURR))) {
 			RET_NULL(obj);
 		}
 	}
 
-	if (!prev || prev->rainIntensity10 != curr->rainIntensity10) {
-		if (!rainIntensity(curr->rainIntensity10, obj, "in10")) {
+	if (FIELD_ON(FLD_CONDITIONS_RAIN_IN10) && (!prev || prev->rainIntensity10 != curr->rainIntensity10)) {
+		if (!rainIntensity(curr->rainIntensity10, obj, FIELD_KEY(FLD_CONDITIONS_RAIN_IN10))) {
 			RET_NULL(obj);
 		}
 	}
 
-	if (!prev || prev->rainIntensity30 != curr->rainIntensity30) {
-		if (!rainIntensity(curr->rainIntensity30, obj, "in30")) {
+	if (FIELD_ON(FLD_CONDITIONS_RAIN_IN30) && (!prev || prev->rainIntensity30 != curr->rainIntensity30)) {
+		if (!rainIntensity(curr->rainIntensity30, obj, FIELD_KEY(FLD_CONDITIONS_RAIN_IN30))) {
 			RET_NULL(obj);
 		}
 	}
@@ -224,16 +197,22 @@ static cJSON* createConditions(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "windSpeed", prev, prev->windSpeed, curr->windSpeed);
-	FLOAT_2_OBJ_CMP(obj, "windDirection", prev, prev->windDirection, curr->windDirection);
+	FLOAT_2_OBJ_CMP(obj, FLD_CONDITIONS_WIND_SPEED, prev, prev->windSpeed, curr->windSpeed);
+	FLOAT_2_OBJ_CMP(obj, FLD_CONDITIONS_WIND_DIRECTION, prev, prev->windDirection, curr->windDirection);
 
 	// track grip
-	if (!prev || wcscmp(prev->trackStatus, curr->trackStatus) != 0) {
-		if (!addWstrToObject(obj, "track", curr->trackStatus)) {
+	if (FIELDS_COMPACT()) {
+		INT_2_OBJ_CMP(obj, FLD_CONDITIONS_TRACK, prev, prev->trackGrip, curr->trackGrip);
+	} else if (FIELD_ON(FLD_CONDITIONS_TRACK) && (!prev || wcscmp(prev->trackStatus, curr->trackStatus) != 0)) {
+		if (!addWstrToObject(obj, FIELD_KEY(FLD_CONDITIONS_TRACK), curr->trackStatus)) {
 			RET_NULL(obj);
 		}
 	}
 
+	if (!fieldsAny(FLD_CONDITIONS_RAIN_CURR, FLD_CONDITIONS_RAIN_IN30) || !groupChanged(curr, prev, rainSpans)) {
+		return obj;
+	}
+
 	// add rain parameters
 	cJSON* ptr = createRain(curr, prev);
 
@@ -242,17 +221,27 @@ static cJSON* createConditions(const HUD* curr, const HUD* prev) {
 	}
 
 	if (cJSON_GetArraySize(ptr) > 0) {
-		if (!cJSON_AddItemToObject(obj, "rain", ptr)) {
+		if (!cJSON_AddItemToObject(obj, OBJECT_KEY(OBJ_CONDITIONS_RAIN), ptr)) {
 			cJSON_Delete(ptr);
 			cJSON_Delete(obj);
 
 			return NULL;
 		}
+	} else {
+		cJSON_Delete(ptr);
 	}
 
 	return obj;
 }
 
+static const struct span pressureSpans[] = {
+	SPAN(HUD, pitStopFL),
+	SPAN(HUD, pitStopFR),
+	SPAN(HUD, pitStopRL),
+	SPAN(HUD, pitStopRR),
+	{0}
+};
+
 /**
  * fl, fr, rl, rr.
  */
@@ -263,10 +252,10 @@ static cJSON* createPressure(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->pitStopFL, curr->pitStopFL);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->pitStopFR, curr->pitStopFR);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->pitStopRL, curr->pitStopRL);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->pitStopRR, curr->pitStopRR);
+	FLOAT_2_OBJ_CMP(obj, FLD_PITSTOP_PRESSURE_FL, prev, prev->pitStopFL, curr->pitStopFL);
+	FLOAT_2_OBJ_CMP(obj, FLD_PITSTOP_PRESSURE_FR, prev, prev->pitStopFR, curr->pitStopFR);
+	FLOAT_2_OBJ_CMP(obj, FLD_PITSTOP_PRESSURE_RL, prev, prev->pitStopRL, curr->pitStopRL);
+	FLOAT_2_OBJ_CMP(obj, FLD_PITSTOP_PRESSURE_RR, prev, prev->pitStopRR, curr->pitStopRR);
 
 	return obj;
 }
@@ -284,8 +273,12 @@ static cJSON* createPitstop(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "tyreSet", prev, prev->pitStopTyreSet, curr->pitStopTyreSet);
-	INT_2_OBJ_CMP(obj, "fuel", prev, prev->pitStopFuel, curr->pitStopFuel);
+	INT_2_OBJ_CMP(obj, FLD_PITSTOP_TYRE_SET, prev, prev->pitStopTyreSet, curr->pitStopTyreSet);
+	INT_2_OBJ_CMP(obj, FLD_PITSTOP_FUEL, prev, prev->pitStopFuel, curr->pitStopFuel);
+
+	if (!fieldsAny(FLD_PITSTOP_PRESSURE_FL, FLD_PITSTOP_PRESSURE_RR) || !groupChanged(curr, prev, pressureSpans)) {
+		return obj;
+	}
 
 	cJSON* pressure = createPressure(curr, prev);
 
@@ -294,12 +287,14 @@ static cJSON* createPitstop(const HUD* curr, const HUD* prev) {
 	}
 
 	if (cJSON_GetArraySize(pressure) > 0) {
-		if (!cJSON_AddItemToObject(obj, "pressure", pressure)) {
+		if (!cJSON_AddItemToObject(obj, OBJECT_KEY(OBJ_PITSTOP_PRESSURE), pressure)) {
 			cJSON_Delete(obj);
 			cJSON_Delete(pressure);
 
 			return NULL;
 		}
+	} else {
+		cJSON_Delete(pressure);
 	}
 
 	return obj;
@@ -318,8 +313,8 @@ static cJSON* createPenalty(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "type", prev, prev->penalty, curr->penalty);
-	FLOAT_2_OBJ_CMP(obj, "duration", prev, prev->penaltyTime, curr->penaltyTime);
+	INT_2_OBJ_CMP(obj, FLD_PENALTY_TYPE, prev, prev->penalty, curr->penalty);
+	FLOAT_2_OBJ_CMP(obj, FLD_PENALTY_DURATION, prev, prev->penaltyTime, curr->penaltyTime);
 
 	return obj;
 }
@@ -337,8 +332,8 @@ static cJSON* createDrivingTime(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "totalRemaining", prev, prev->totalTimeLeft, curr->totalTimeLeft);
-	INT_2_OBJ_CMP(obj, "stintRemaining", prev, prev->stintTimeLeft, curr->stintTimeLeft);
+	INT_2_OBJ_CMP(obj, FLD_DRIVING_TIME_TOTAL_REMAINING, prev, prev->totalTimeLeft, curr->totalTimeLeft);
+	INT_2_OBJ_CMP(obj, FLD_DRIVING_TIME_STINT_REMAINING, prev, prev->stintTimeLeft, curr->stintTimeLeft);
 
 	return obj;
 }
@@ -356,12 +351,20 @@ static cJSON* createFuel(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "used", prev, prev->fuelUsed, curr->fuelUsed);
-	FLOAT_2_OBJ_CMP(obj, "rate", prev, prev->fuelPerLap, curr->fuelPerLap);
+	FLOAT_2_OBJ_CMP(obj, FLD_FUEL_USED, prev, prev->fuelUsed, curr->fuelUsed);
+	FLOAT_2_OBJ_CMP(obj, FLD_FUEL_RATE, prev, prev->fuelPerLap, curr->fuelPerLap);
 
 	return obj;
 }
 
+static const struct span yellowSpans[] = {
+	SPAN(HUD, globalYellow),
+	SPAN(HUD, yellow1),
+	SPAN(HUD, yellow2),
+	SPAN(HUD, yellow3),
+	{0}
+};
+
 static cJSON* createYellow(const HUD* curr, const HUD* prev) {
 	cJSON* obj = cJSON_CreateObject();
 
@@ -369,10 +372,10 @@ static cJSON* createYellow(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	BOOL_2_OBJ_CMP(obj, "global", prev, prev->globalYellow, curr->globalYellow);
-	BOOL_2_OBJ_CMP(obj, "sector1", prev, prev->yellow1, curr->yellow1);
-	BOOL_2_OBJ_CMP(obj, "sector2", prev, prev->yellow2, curr->yellow2);
-	BOOL_2_OBJ_CMP(obj, "sector3", prev, prev->yellow3, curr->yellow3);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_YELLOW_GLOBAL, prev, prev->globalYellow, curr->globalYellow);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_YELLOW_SECTOR1, prev, prev->yellow1, curr->yellow1);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_YELLOW_SECTOR2, prev, prev->yellow2, curr->yellow2);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_YELLOW_SECTOR3, prev, prev->yellow3, curr->yellow3);
 
 	return obj;
 }
@@ -391,11 +394,15 @@ static cJSON* createFlag(const HUD* curr, const HUD* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "curr", prev, prev->flag, curr->flag);
-	BOOL_2_OBJ_CMP(obj, "green", prev, prev->globalGreen, curr->globalGreen);
-	BOOL_2_OBJ_CMP(obj, "chequered", prev, prev->chequered, curr->chequered);
-	BOOL_2_OBJ_CMP(obj, "red", prev, prev->globalRed, curr->globalRed);
-	BOOL_2_OBJ_CMP(obj, "white", prev, prev->globalWhite, curr->globalWhite);
+	INT_2_OBJ_CMP(obj, FLD_FLAG_CURR, prev, prev->flag, curr->flag);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_GREEN, prev, prev->globalGreen, curr->globalGreen);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_CHEQUERED, prev, prev->chequered, curr->chequered);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_RED, prev, prev->globalRed, curr->globalRed);
+	BOOL_2_OBJ_CMP(obj, FLD_FLAG_WHITE, prev, prev->globalWhite, curr->globalWhite);
+
+	if (!fieldsAny(FLD_FLAG_YELLOW_GLOBAL, FLD_FLAG_YELLOW_SECTOR3) || !groupChanged(curr, prev, yellowSpans)) {
+		return obj;
+	}
 
 	cJSON* yellow = createYellow(curr, prev);
 
@@ -404,30 +411,109 @@ static cJSON* createFlag(const HUD* curr, const HUD* prev) {
 	}
 
 	if (cJSON_GetArraySize(yellow) > 0) {
-		if (!cJSON_AddItemToObject(obj, "yellow", yellow)) {
+		if (!cJSON_AddItemToObject(obj, OBJECT_KEY(OBJ_FLAG_YELLOW), yellow)) {
 			cJSON_Delete(yellow);
 			cJSON_Delete(obj);
 
 			return NULL;
 		}
+	} else {
+		cJSON_Delete(yellow);
 	}
 
 	return obj;
 }
 
+// fields each sub-object is built from
+// remember to update these when adding fields to the create functions above
+static const struct span electronicsSpans[] = {
+	SPAN(HUD, tc),
+	SPAN(HUD, tcCut),
+	SPAN(HUD, engineMap),
+	SPAN(HUD, abs),
+	SPAN(HUD, headlightState),
+	SPAN(HUD, wiperState),
+	SPAN(HUD, rainLight),
+	SPAN(HUD, flasher),
+	SPAN(HUD, leftIndicator),
+	SPAN(HUD, rightIndicator),
+	{0}
+};
+
+static const struct span sessionSpans[] = {
+	SPAN(HUD, session),
+	SPAN(HUD, sessionTimeLeft),
+	SPAN(HUD, activeCars),
+	SPAN(HUD, clock),
+	{0}
+};
+
+static const struct span conditionsSpans[] = {
+	SPAN(HUD, windSpeed),
+	SPAN(HUD, windDirection),
+	SPAN(HUD, trackStatus),
+	SPAN(HUD, trackGrip),
+	SPAN(HUD, rainIntensityCurr),
+	SPAN(HUD, rainIntensity10),
+	SPAN(HUD, rainIntensity30),
+	{0}
+};
+
+static const struct span pitstopSpans[] = {
+	SPAN(HUD, pitStopTyreSet),
+	SPAN(HUD, pitStopFuel),
+	SPAN(HUD, pitStopFL),
+	SPAN(HUD, pitStopFR),
+	SPAN(HUD, pitStopRL),
+	SPAN(HUD, pitStopRR),
+	{0}
+};
+
+static const struct span penaltySpans[] = {
+	SPAN(HUD, penalty),
+	SPAN(HUD, penaltyTime),
+	{0}
+};
+
+static const struct span drivingTimeSpans[] = {
+	SPAN(HUD, totalTimeLeft),
+	SPAN(HUD, stintTimeLeft),
+	{0}
+};
+
+static const struct span fuelSpans[] = {
+	SPAN(HUD, fuelUsed),
+	SPAN(HUD, fuelPerLap),
+	{0}
+};
+
+static const struct span flagSpans[] = {
+	SPAN(HUD, flag),
+	SPAN(HUD, globalGreen),
+	SPAN(HUD, chequered),
+	SPAN(HUD, globalRed),
+	SPAN(HUD, globalWhite),
+	SPAN(HUD, globalYellow),
+	SPAN(HUD, yellow1),
+	SPAN(HUD, yellow2),
+	SPAN(HUD, yellow3),
+	{0}
+};
+
 // remember to update when adding additional sub-objects
 #define HUD_ITEM_COUNT 9
 
 static const struct item items[HUD_ITEM_COUNT] = {
-	{"laptimes", &createLaptimes},
-	{"electronics", &createElectronics},
-	{"session", &createSession},
-	{"conditions", &createConditions},
-	{"pitstop", &createPitstop},
-	{"penalty", &createPenalty},
-	{"drivingTime", &createDrivingTime},
-	{"fuel", &createFuel},
-	{"flag", &createFlag}
+	// the current lap time is always sent
+	{OBJ_LAPTIMES, &createLaptimes, NULL, FLD_LAPTIMES_CURR, FLD_LAPTIMES_IS_VALID_LAP},
+	{OBJ_ELECTRONICS, &createElectronics, electronicsSpans, FLD_ELECTRONICS_TC, FLD_ELECTRONICS_RIGHT_INDICATOR},
+	{OBJ_SESSION, &createSession, sessionSpans, FLD_SESSION_TYPE, FLD_SESSION_CLOCK},
+	{OBJ_CONDITIONS, &createConditions, conditionsSpans, FLD_CONDITIONS_WIND_SPEED, FLD_CONDITIONS_RAIN_IN30},
+	{OBJ_PITSTOP, &createPitstop, pitstopSpans, FLD_PITSTOP_TYRE_SET, FLD_PITSTOP_PRESSURE_RR},
+	{OBJ_PENALTY, &createPenalty, penaltySpans, FLD_PENALTY_TYPE, FLD_PENALTY_DURATION},
+	{OBJ_DRIVING_TIME, &createDrivingTime, drivingTimeSpans, FLD_DRIVING_TIME_TOTAL_REMAINING, FLD_DRIVING_TIME_STINT_REMAINING},
+	{OBJ_FUEL, &createFuel, fuelSpans, FLD_FUEL_USED, FLD_FUEL_RATE},
+	{OBJ_FLAG, &createFlag, flagSpans, FLD_FLAG_CURR, FLD_FLAG_YELLOW_SECTOR3}
 };
 
 /**
@@ -439,18 +525,23 @@ static const struct item items[HUD_ITEM_COUNT] = {
  * @param prev Previous frame HUD data.
  */
 cJSON* hudToJSON(cJSON* obj, const HUD* curr, const HUD* prev) {
-	INT_2_OBJ_CMP(obj, "position", prev, prev->position, curr->position);
-	FLOAT_2_OBJ_CMP(obj, "distanceTraveled", prev, prev->distanceTraveled, curr->distanceTraveled);
-	INT_2_OBJ_CMP(obj, "laps", prev, prev->completedLaps, curr->completedLaps);
-	INT_2_OBJ_CMP(obj, "tyreSet", prev, prev->currTyreSet, curr->currTyreSet);
+	INT_2_OBJ_CMP(obj, FLD_POSITION, prev, prev->position, curr->position);
+	FLOAT_2_OBJ_CMP(obj, FLD_DISTANCE_TRAVELED, prev, prev->distanceTraveled, curr->distanceTraveled);
+	INT_2_OBJ_CMP(obj, FLD_LAPS, prev, prev->completedLaps, curr->completedLaps);
+	INT_2_OBJ_CMP(obj, FLD_TYRE_SET, prev, prev->currTyreSet, curr->currTyreSet);
 
-	BOOL_2_OBJ_CMP(obj, "isBoxed", prev, prev->isBoxed, curr->isBoxed);
-	BOOL_2_OBJ_CMP(obj, "isInPitLane", prev, prev->isInPitLane, curr->isInPitLane);
-	BOOL_2_OBJ_CMP(obj, "mandatoryPitDone", prev, prev->mandatoryPitDone, curr->mandatoryPitDone);
-	BOOL_2_OBJ_CMP(obj, "rainTyres", prev, prev->rainTyres, curr->rainTyres);
+	BOOL_2_OBJ_CMP(obj, FLD_IS_BOXED, prev, prev->isBoxed, curr->isBoxed);
+	BOOL_2_OBJ_CMP(obj, FLD_IS_IN_PIT_LANE, prev, prev->isInPitLane, curr->isInPitLane);
+	BOOL_2_OBJ_CMP(obj, FLD_MANDATORY_PIT_DONE, prev, prev->mandatoryPitDone, curr->mandatoryPitDone);
+	BOOL_2_OBJ_CMP(obj, FLD_RAIN_TYRES, prev, prev->rainTyres, curr->rainTyres);
 
 	// add sub-objects
 	for (int i = 0; i < HUD_ITEM_COUNT; i++) {
+		// skip groups that would end up empty
+		if (!fieldsAny(items[i].first, items[i].last) || !groupChanged(curr, prev, items[i].spans)) {
+			continue;
+		}
+
 		cJSON* ptr = items[i].create(curr, prev);
 
 		if (!ptr) {
@@ -459,7 +550,7 @@ cJSON* hudToJSON(cJSON* obj, const HUD* curr, const HUD* prev) {
 
 		// only add ptr to the object if it has at least one sub key
 		if (cJSON_GetArraySize(ptr) > 0) {
-			if (!cJSON_AddItemToObject(obj, items[i].key, ptr)) {
+			if (!cJSON_AddItemToObject(obj, OBJECT_KEY(items[i].key), ptr)) {
 				cJSON_Delete(ptr);
 				cJSON_Delete(obj);
 
@@ -473,6 +564,78 @@ cJSON* hudToJSON(cJSON* obj, const HUD* curr, const HUD* prev) {
 	return obj;
 }
 
+/**
+ * Get a session type as a string.
+ * @param  s
+ * @return   No need to free.
+ */
+const char* strSession(SessionType s) {
+	switch (s) {
+	case ST_PRACTICE:
+		return "Practice";
+	case ST_QUALIFY:
+		return "Qualifying";
+	case ST_RACE:
+		return "Race";
+	case ST_HOTLAP:
+		return "Hot Lap";
+	case ST_HOTSTINT:
+		return "Hot Stint";
+	case ST_SUPERPOLE:
+		return "Super Pole";
+	default:
+		return "Unknown";
+	}
+}
+
+/**
+ * Get a rain intensity as a string.
+ * @param  ri
+ * @return    No need to free.
+ */
+const char* strRain(RainIntensity ri) {
+	switch (ri) {
+	case R_DRIZZLE:
+		return "Drizzle";
+	case R_LIGHT:
+		return "Light";
+	case R_MEDIUM:
+		return "Medium";
+	case R_HEAVY:
+		return "Heavy";
+	case R_THUNDERSTORM:
+		return "Thunderstorm";
+	default:
+		return "None";
+	}
+}
+
+/**
+ * Get a track grip level as a string. Matches HUD.trackStatus.
+ * @param  tg
+ * @return    No need to free.
+ */
+const char* strTrackGrip(TrackGrip tg) {
+	switch (tg) {
+	case TG_GREEN:
+		return "Green";
+	case TG_FAST:
+		return "Fast";
+	case TG_OPTIMUM:
+		return "Optimum";
+	case TG_GREASY:
+		return "Greasy";
+	case TG_DAMP:
+		return "Damp";
+	case TG_WET:
+		return "Wet";
+	case TG_FLOODED:
+		return "Flooded";
+	}
+
+	return "Unknown";
+}
+
 /**
  * Get a status as a wchar_t*.
  * @param  s
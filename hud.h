@@ -344,6 +344,9 @@ typedef struct hud {
 } HUD;
 
 cJSON* hudToJSON(cJSON*, const HUD*, const HUD*);
+const char* strSession(SessionType);
+const char* strRain(RainIntensity);
+const char* strTrackGrip(TrackGrip);
 const wchar_t* wstrStatus(Status);
 
 #endif
@@ -25,6 +25,7 @@ InstanceData* createInstanceData(SharedMem* sm) {
 
 	data->sm = sm;
 	data->chanList = NULL;
+	data->cars = NULL;
 	data->running = false;
 	data->thread = NULL;
 	data->threadId = 0;
@@ -43,7 +44,8 @@ void freeInstanceData(InstanceData* data) {
 	}
 
 	freeChannelList(data->chanList);
-	free(data->channel);
-	free(data->password);
+	freeCars(data->cars);
+	areFree(data->channel);
+	areFree(data->password);
 	free(data);
 }
@@ -1,6 +1,7 @@
 #ifndef INSTANCE_DATA_H
 #define INSTANCE_DATA_H
 
+#include "cars.h"
 #include "channel.h"
 #include "shared_mem.h"
 
@@ -44,6 +45,9 @@ typedef struct instanceData {
 
 	// channel list
 	ChannelList* chanList;
+
+	// car metadata loaded at startup
+	CarTable* cars;
 } InstanceData;
 
 InstanceData* createInstanceData(SharedMem* sm);
@@ -0,0 +1,69 @@
+#include "lap_cursor.h"
+
+/**
+ * Start following a lap from a sample.
+ * @param c
+ * @param points Grid points per lap.
+ * @param pos    Position of the sample.
+ * @param atLine The sample is the first after the line, wherever pos is.
+ */
+void lapCursorStart(LapCursor* c, int points, float pos, bool atLine) {
+	int point = (int) (pos * points);
+
+	c->points = points;
+	c->point = atLine ? 0 : (point < points - 1 ? point : points - 1);
+	c->timed = c->point == 0;
+	c->pos = pos;
+}
+
+/**
+ * Classify a sample against the last one that moved forwards.
+ * @param  c
+ * @param  pos
+ * @param  next Assigned pos, or pos + 1 if the line was crossed.
+ * @return      What the sample does.
+ */
+enum lapStep lapCursorStep(const LapCursor* c, float pos, float* next) {
+	float step = pos - c->pos;
+
+	*next = pos;
+
+	if (step < 0.0f && step + 1.0f < LAP_CURSOR_MAX_STEP) {
+		*next = pos + 1.0f;
+
+		return LAP_STEP_LINE;
+	}
+
+	if (step < 0.0f || step > LAP_CURSOR_MAX_STEP) {
+		return LAP_STEP_SKIP;
+	}
+
+	return LAP_STEP_FORWARD;
+}
+
+/**
+ * Pass the next grid point at or before next. Called until it returns false,
+ * after which the caller moves c->pos up to the sample.
+ * @param  c
+ * @param  next  Position of the sample (from lapCursorStep()).
+ * @param  limit Last grid point that may be passed.
+ * @param  f     Assigned the fraction of the way from c->pos to next the
+ *               point lies at.
+ * @return       False once no point is left before next or limit.
+ */
+bool lapCursorCross(LapCursor* c, float next, int limit, float* f) {
+	if (c->point >= limit) {
+		return false;
+	}
+
+	float point = (float) (c->point + 1) / c->points;
+
+	if (point > next) {
+		return false;
+	}
+
+	*f = (point - c->pos) / (next - c->pos);
+	c->point++;
+
+	return true;
+}
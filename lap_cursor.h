@@ -0,0 +1,46 @@
+#ifndef LAP_CURSOR_H
+#define LAP_CURSOR_H
+
+#include <stdbool.h>
+
+// position changes larger than this between samples are glitches, such as
+// normalizedCarPosition still reading ~1 just after the line
+#define LAP_CURSOR_MAX_STEP 0.5f
+
+// what a sample does to a cursor
+enum lapStep {
+	// backwards or implausibly far: wait for a sample that makes sense
+	LAP_STEP_SKIP = 0,
+
+	// forwards along the lap
+	LAP_STEP_FORWARD,
+
+	// forwards across the line
+	LAP_STEP_LINE
+};
+
+/**
+ * Follows a lap over a grid of equal intervals of normalizedCarPosition.
+ * Only moves forwards, and yields every grid point between two samples with
+ * the fraction of the way from the first to the second it lies at, so the
+ * caller can interpolate whatever it records there.
+ */
+typedef struct lapCursor {
+	// grid points per lap; point i is at position i / points
+	int points;
+
+	// last grid point passed
+	int point;
+
+	// the lap was followed from its first interval so every point is known
+	bool timed;
+
+	// position of the last sample that moved forwards
+	float pos;
+} LapCursor;
+
+void lapCursorStart(LapCursor*, int, float, bool);
+enum lapStep lapCursorStep(const LapCursor*, float, float*);
+bool lapCursorCross(LapCursor*, float, int, float*);
+
+#endif
@@ -0,0 +1,173 @@
+#include "lap_summary.h"
+
+/**
+ * Forget the current lap. The next sample starts a new one.
+ */
+void lapSummaryReset(LapSummary* l) {
+	memset(l, 0, sizeof(*l));
+}
+
+static void rangeStart(struct lapRange* r, float v) {
+	r->min = v;
+	r->max = v;
+	r->sum = v;
+}
+
+static void rangeAdd(struct lapRange* r, float v) {
+	r->min = v < r->min ? v : r->min;
+	r->max = v > r->max ? v : r->max;
+	r->sum += v;
+}
+
+/**
+ * Add a sample to the current lap. A change of session starts over.
+ * @param l
+ * @param p
+ * @param h
+ */
+void lapSummaryAdd(LapSummary* l, const Physics* p, const HUD* h) {
+	if (l->started && (h->sessionIndex != l->sessionIndex || h->completedLaps < l->completedLaps)) {
+		lapSummaryReset(l);
+	}
+
+	if (!l->started) {
+		l->started = true;
+		l->partial = h->currLapTime > LAP_JOIN_MS;
+		l->sessionIndex = h->sessionIndex;
+		l->completedLaps = h->completedLaps;
+		l->lastLapTime = h->currLapTime;
+		l->fuelStart = p->fuelRemaining;
+
+		for (int i = 0; i < LAP_WHEELS; i++) {
+			rangeStart(&l->tyrePressure[i], p->tyrePressure[i]);
+			rangeStart(&l->tyreTemp[i], p->tyreCoreTemp[i]);
+			rangeStart(&l->brakeTemp[i], p->brakeTemp[i]);
+		}
+	} else {
+		for (int i = 0; i < LAP_WHEELS; i++) {
+			rangeAdd(&l->tyrePressure[i], p->tyrePressure[i]);
+			rangeAdd(&l->tyreTemp[i], p->tyreCoreTemp[i]);
+			rangeAdd(&l->brakeTemp[i], p->brakeTemp[i]);
+		}
+	}
+
+	// game time since the last sample; nothing accrues while paused
+	int elapsed = h->currLapTime - l->lastLapTime;
+
+	if (elapsed > 0) {
+		l->tcTime += p->tcIntervention > 0.0f ? elapsed : 0;
+		l->absTime += p->absIntervention > 0.0f ? elapsed : 0;
+	}
+
+	l->lastLapTime = h->currLapTime;
+	l->samples++;
+	l->fuelUsed = l->fuelStart - p->fuelRemaining;
+	l->maxSpeed = p->speed > l->maxSpeed ? p->speed : l->maxSpeed;
+}
+
+/**
+ * Format [min, mean, max] of each wheel as a raw JSON array.
+ */
+static void rangesToRaw(const struct lapRange* r, uint32_t samples, const char* format, char* raw) {
+	size_t len = 0;
+
+	raw[len++] = '[';
+
+	for (int i = 0; i < LAP_WHEELS; i++) {
+		double mean = samples ? r[i].sum / samples : 0.0;
+
+		len += snprintf(raw + len, LAP_ARRAY_WIDTH - len, format, i ? "," : "", r[i].min, mean, r[i].max);
+	}
+
+	snprintf(raw + len, LAP_ARRAY_WIDTH - len, "]");
+}
+
+/**
+ * lap, time, partial, fuelUsed, maxSpeed, tcTime, absTime, tyrePressure,
+ * tyreTemp, brakeTemp.
+ */
+static cJSON* createLapSummary(const LapSummary* l, int time) {
+	char ranges[LAP_ARRAY_WIDTH];
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return NULL;
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_LAP)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_LAP), l->completedLaps + 1);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_TIME)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_TIME), time);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_PARTIAL)) {
+		BOOL_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_PARTIAL), l->partial);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_FUEL_USED)) {
+		FLOAT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_FUEL_USED), l->fuelUsed);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_MAX_SPEED)) {
+		FLOAT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_MAX_SPEED), l->maxSpeed);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_TC_TIME)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_TC_TIME), l->tcTime);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_ABS_TIME)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAP_SUMMARY_ABS_TIME), l->absTime);
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_TYRE_PRESSURE)) {
+		rangesToRaw(l->tyrePressure, l->samples, "%s%.2f,%.2f,%.2f", ranges);
+
+		if (!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_LAP_SUMMARY_TYRE_PRESSURE), ranges)) {
+			RET_NULL(obj);
+		}
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_TYRE_TEMP)) {
+		rangesToRaw(l->tyreTemp, l->samples, "%s%.1f,%.1f,%.1f", ranges);
+
+		if (!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_LAP_SUMMARY_TYRE_TEMP), ranges)) {
+			RET_NULL(obj);
+		}
+	}
+
+	if (FIELD_ON(FLD_LAP_SUMMARY_BRAKE_TEMP)) {
+		rangesToRaw(l->brakeTemp, l->samples, "%s%.1f,%.1f,%.1f", ranges);
+
+		if (!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_LAP_SUMMARY_BRAKE_TEMP), ranges)) {
+			RET_NULL(obj);
+		}
+	}
+
+	return obj;
+}
+
+/**
+ * Add a completed lap under "lapSummary". The pressure and temperature
+ * arrays hold min, mean, and max of FL, FR, RL, then RR.
+ * @param  parent
+ * @param  l
+ * @param  time   Lap time reported by the game (prevLapTime).
+ * @return        NULL if out of memory (parent is deleted).
+ */
+cJSON* lapSummaryToJSON(cJSON* parent, const LapSummary* l, int time) {
+	if (!fieldsAny(FLD_LAP_SUMMARY_LAP, FLD_LAP_SUMMARY_BRAKE_TEMP)) {
+		return parent;
+	}
+
+	cJSON* obj = createLapSummary(l, time);
+
+	if (!obj || !cJSON_AddItemToObject(parent, OBJECT_KEY(OBJ_LAP_SUMMARY), obj)) {
+		cJSON_Delete(obj);
+		RET_NULL(parent);
+	}
+
+	return parent;
+}
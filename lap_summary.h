@@ -0,0 +1,63 @@
+#ifndef LAP_SUMMARY_H
+#define LAP_SUMMARY_H
+
+#include "auxiliary.h"
+#include "physics.h"
+#include "hud.h"
+
+#define LAP_WHEELS (W_RR + 1)
+
+// a lap whose first sample is further into it than this (milliseconds) was
+// joined part way through. One and a half broadcast periods, so that a
+// recording (one frame per period) is judged the same as the live laps
+#define LAP_JOIN_MS (LOOP_PERIOD * 3 / 2000)
+
+// bytes of a [min, mean, max] per wheel array
+#define LAP_ARRAY_WIDTH (LAP_WHEELS * 3 * JSON_RAW_FLOAT_WIDTH)
+
+/**
+ * Minimum, maximum, and sum of a value over a lap.
+ */
+struct lapRange {
+	float min;
+	float max;
+	double sum;
+};
+
+/**
+ * Streaming accumulators of the current lap. Each sample is added in O(1).
+ * Samples arrive at LAP_RATE (see trackedSample()), so peaks and TC or ABS
+ * time are resolved to LAP_PERIOD rather than to the broadcasts.
+ */
+typedef struct lapSummary {
+	bool started;
+
+	// joined part way through the lap (or the publisher started mid-lap)
+	bool partial;
+
+	// sessionIndex and completedLaps while the lap is driven
+	int sessionIndex;
+	int completedLaps;
+
+	// currLapTime of the last sample
+	int lastLapTime;
+
+	uint32_t samples;
+	float fuelStart;
+	float fuelUsed;
+	float maxSpeed;
+
+	// game time with TC or ABS intervening (milliseconds)
+	int tcTime;
+	int absTime;
+
+	struct lapRange tyrePressure[LAP_WHEELS];
+	struct lapRange tyreTemp[LAP_WHEELS];
+	struct lapRange brakeTemp[LAP_WHEELS];
+} LapSummary;
+
+void lapSummaryReset(LapSummary*);
+void lapSummaryAdd(LapSummary*, const Physics*, const HUD*);
+cJSON* lapSummaryToJSON(cJSON*, const LapSummary*, int);
+
+#endif
@@ -0,0 +1,345 @@
+#include "lap_trace.h"
+
+/**
+ * A run of samples between two kept points and the sample furthest from
+ * the straight line between them.
+ */
+struct lapTraceSegment {
+	uint32_t first;
+	uint32_t last;
+	uint32_t worst;
+	float error;
+};
+
+/**
+ * Allocate an empty lap trace on the heap.
+ * @return NULL if out of memory.
+ */
+LapTrace* createLapTrace() {
+	LapTrace* lt = calloc(1, sizeof(*lt));
+
+	if (!lt) {
+		return NULL;
+	}
+
+	lt->cap = LAP_TRACE_INITIAL_CAP;
+	lt->points = malloc(sizeof(*lt->points) * lt->cap);
+	lt->keep = malloc(sizeof(bool) * lt->cap);
+	lt->heap = malloc(sizeof(*lt->heap) * LAP_TRACE_BUDGET);
+	lt->encoded = malloc(BASE64_LEN(LAP_TRACE_BUDGET * LAP_TRACE_POINT_SIZE) + 1);
+
+	if (!lt->points || !lt->keep || !lt->heap || !lt->encoded) {
+		freeLapTrace(lt);
+
+		return NULL;
+	}
+
+	return lt;
+}
+
+/**
+ * Add a sample to the lap being driven. A new session, or completedLaps
+ * going backwards, discards it.
+ * @param  lt
+ * @param  p
+ * @param  h
+ * @return    False if out of memory.
+ */
+bool lapTraceAdd(LapTrace* lt, const Physics* p, const HUD* h) {
+	float pos = h->normalizedCarPosition;
+	float next;
+
+	if (!lt->started || h->sessionIndex != lt->sessionIndex || h->completedLaps < lt->completedLaps) {
+		lt->started = true;
+		lt->sessionIndex = h->sessionIndex;
+		lt->count = 0;
+		lapCursorStart(&lt->cursor, LAP_TRACE_JOIN_POINTS, pos, false);
+	}
+
+	lt->completedLaps = h->completedLaps;
+
+	// the line is crossed by lapTraceFinish() on the rollover
+	if (lapCursorStep(&lt->cursor, pos, &next) != LAP_STEP_FORWARD) {
+		return true;
+	}
+
+	if (lt->count == lt->cap) {
+		size_t cap = lt->cap * 2;
+		struct lapTracePoint* points = realloc(lt->points, sizeof(*points) * cap);
+
+		if (!points) {
+			return false;
+		}
+
+		lt->points = points;
+
+		bool* keep = realloc(lt->keep, sizeof(bool) * cap);
+
+		if (!keep) {
+			return false;
+		}
+
+		lt->keep = keep;
+		lt->cap = cap;
+	}
+
+	struct lapTracePoint* pt = &lt->points[lt->count++];
+
+	pt->pos = pos;
+	pt->speed = p->speed / LAP_TRACE_SPEED_SCALE;
+	pt->throttle = p->accelerator;
+	pt->brake = p->brake;
+	lt->cursor.pos = pos;
+
+	return true;
+}
+
+/**
+ * Find the sample of s furthest from the line between its end points. The
+ * distance is the largest difference of a channel from its linear
+ * interpolation at the sample's position.
+ */
+static void measure(const LapTrace* lt, struct lapTraceSegment* s) {
+	const struct lapTracePoint* a = &lt->points[s->first];
+	const struct lapTracePoint* b = &lt->points[s->last];
+	float span = b->pos - a->pos;
+
+	s->worst = s->first;
+	s->error = 0.0f;
+
+	for (uint32_t i = s->first + 1; i < s->last; i++) {
+		const struct lapTracePoint* c = &lt->points[i];
+		float f = span > 0.0f ? (c->pos - a->pos) / span : 0.0f;
+		float e = fabsf(c->speed - (a->speed + f * (b->speed - a->speed)));
+
+		e = fmaxf(e, fabsf(c->throttle - (a->throttle + f * (b->throttle - a->throttle))));
+		e = fmaxf(e, fabsf(c->brake - (a->brake + f * (b->brake - a->brake))));
+
+		if (e > s->error) {
+			s->error = e;
+			s->worst = i;
+		}
+	}
+}
+
+/**
+ * Add a segment to the max-heap of split candidates.
+ */
+static void heapPush(struct lapTraceSegment* heap, size_t* n, struct lapTraceSegment s) {
+	size_t i = (*n)++;
+
+	while (i > 0 && heap[(i - 1) / 2].error < s.error) {
+		heap[i] = heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+
+	heap[i] = s;
+}
+
+/**
+ * Remove the segment with the largest error from the heap.
+ */
+static struct lapTraceSegment heapPop(struct lapTraceSegment* heap, size_t* n) {
+	struct lapTraceSegment top = heap[0];
+	struct lapTraceSegment last = heap[--(*n)];
+	size_t i = 0;
+
+	for (size_t child = 1; child < *n; child = i * 2 + 1) {
+		if (child + 1 < *n && heap[child + 1].error > heap[child].error) {
+			child++;
+		}
+
+		if (heap[child].error <= last.error) {
+			break;
+		}
+
+		heap[i] = heap[child];
+		i = child;
+	}
+
+	heap[i] = last;
+
+	return top;
+}
+
+/**
+ * Ramer-Douglas-Peucker with a point budget: starting from the first and
+ * last samples, repeatedly keep the sample furthest from the simplified
+ * trace until the budget is spent or every sample is within the tolerance.
+ * @return Points kept.
+ */
+static size_t simplify(LapTrace* lt) {
+	memset(lt->keep, 0, sizeof(bool) * lt->count);
+	lt->keep[0] = true;
+	lt->keep[lt->count - 1] = true;
+
+	size_t kept = lt->count > 1 ? 2 : 1;
+	size_t n = 0;
+	struct lapTraceSegment s = {0, (uint32_t) lt->count - 1, 0, 0.0f};
+
+	measure(lt, &s);
+	heapPush(lt->heap, &n, s);
+
+	// each split adds a point and at most one more segment than it removes
+	while (n > 0 && kept < LAP_TRACE_BUDGET) {
+		s = heapPop(lt->heap, &n);
+
+		if (s.error <= LAP_TRACE_TOLERANCE) {
+			break;
+		}
+
+		lt->keep[s.worst] = true;
+		kept++;
+
+		struct lapTraceSegment left = {s.first, s.worst, 0, 0.0f};
+		struct lapTraceSegment right = {s.worst, s.last, 0, 0.0f};
+
+		measure(lt, &left);
+		measure(lt, &right);
+
+		if (left.error > LAP_TRACE_TOLERANCE) {
+			heapPush(lt->heap, &n, left);
+		}
+
+		if (right.error > LAP_TRACE_TOLERANCE) {
+			heapPush(lt->heap, &n, right);
+		}
+	}
+
+	return kept;
+}
+
+/**
+ * Quantise v in [0, 1] to max.
+ */
+static uint32_t quantise(float v, uint32_t max) {
+	v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+
+	return (uint32_t) lroundf(v * (float) max);
+}
+
+/**
+ * Simplify and encode the trace of the lap.
+ * @return False if out of memory.
+ */
+static bool encode(LapTrace* lt, int lap) {
+	size_t kept = simplify(lt);
+	uint8_t* bytes = malloc(kept * LAP_TRACE_POINT_SIZE);
+
+	if (!bytes) {
+		return false;
+	}
+
+	uint8_t* b = bytes;
+
+	// little endian u16 position and speed, u8 throttle and brake
+	for (size_t i = 0; i < lt->count; i++) {
+		if (!lt->keep[i]) {
+			continue;
+		}
+
+		const struct lapTracePoint* pt = &lt->points[i];
+		uint32_t pos = quantise(pt->pos, UINT16_MAX);
+		uint32_t speed = quantise(pt->speed, UINT16_MAX);
+
+		*b++ = pos & 0xFF;
+		*b++ = pos >> 8;
+		*b++ = speed & 0xFF;
+		*b++ = speed >> 8;
+		*b++ = (uint8_t) quantise(pt->throttle, UINT8_MAX);
+		*b++ = (uint8_t) quantise(pt->brake, UINT8_MAX);
+	}
+
+	base64Encode(lt->encoded, bytes, kept * LAP_TRACE_POINT_SIZE);
+	free(bytes);
+
+	lt->encodedLap = lap;
+	lt->encodedPartial = !lt->cursor.timed;
+	lt->lapCompleted = true;
+
+	return true;
+}
+
+/**
+ * Complete the lap: simplify and encode its trace for publishing, then start
+ * the next lap. Called on the completedLaps rollover.
+ * @param  lt
+ * @param  lap Number of the lap completed (completed laps + 1).
+ * @return     False if out of memory.
+ */
+bool lapTraceFinish(LapTrace* lt, int lap) {
+	if (lt->count > 0 && !encode(lt, lap)) {
+		return false;
+	}
+
+	// the next lap starts at the line
+	lt->count = 0;
+	lapCursorStart(&lt->cursor, LAP_TRACE_JOIN_POINTS, 0.0f, true);
+
+	return true;
+}
+
+/**
+ * lap, partial, data.
+ */
+static cJSON* createTrace(LapTrace* lt) {
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return NULL;
+	}
+
+	if (FIELD_ON(FLD_LAP_TRACE_LAP)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_LAP_TRACE_LAP), lt->encodedLap);
+	}
+
+	if (FIELD_ON(FLD_LAP_TRACE_PARTIAL)) {
+		BOOL_2_OBJ(obj, FIELD_KEY(FLD_LAP_TRACE_PARTIAL), lt->encodedPartial);
+	}
+
+	if (FIELD_ON(FLD_LAP_TRACE_DATA) && !cJSON_AddStringToObject(obj, FIELD_KEY(FLD_LAP_TRACE_DATA), lt->encoded)) {
+		RET_NULL(obj);
+	}
+
+	return obj;
+}
+
+/**
+ * Add the trace of the last completed lap until it is published, under "lapTrace".
+ * @param  parent
+ * @param  lt
+ * @return        NULL if out of memory (parent is deleted).
+ */
+cJSON* lapTraceToJSON(cJSON* parent, LapTrace* lt) {
+	if (!lt->lapCompleted) {
+		return parent;
+	}
+
+	if (!fieldsAny(FLD_LAP_TRACE_LAP, FLD_LAP_TRACE_DATA)) {
+		return parent;
+	}
+
+	cJSON* obj = createTrace(lt);
+
+	if (!obj || !cJSON_AddItemToObject(parent, OBJECT_KEY(OBJ_LAP_TRACE), obj)) {
+		cJSON_Delete(obj);
+		RET_NULL(parent);
+	}
+
+	return parent;
+}
+
+/**
+ * Free a lap trace. Does nothing if lt is NULL.
+ */
+void freeLapTrace(LapTrace* lt) {
+	if (!lt) {
+		return;
+	}
+
+	free(lt->points);
+	free(lt->keep);
+	free(lt->heap);
+	free(lt->encoded);
+	free(lt);
+}
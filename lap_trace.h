@@ -0,0 +1,78 @@
+#ifndef LAP_TRACE_H
+#define LAP_TRACE_H
+
+#include "auxiliary.h"
+#include "physics.h"
+#include "hud.h"
+#include "lap_cursor.h"
+
+// most points a lap is simplified to, at least 2 (build time; see
+// LAP_TRACE_POINTS in CMakeLists.txt)
+#define LAP_TRACE_BUDGET LAP_TRACE_POINTS
+
+// simplification stops early once no point is further than this from the
+// simplified trace (as a fraction of each channel's full scale)
+#define LAP_TRACE_TOLERANCE 0.005f
+
+// full scale of the speed channel (km/h)
+#define LAP_TRACE_SPEED_SCALE 400.0f
+
+// samples a trace starts with room for; grows as needed
+#define LAP_TRACE_INITIAL_CAP 1024
+
+// intervals of the lap cursor; a trace joined in the first one still counts
+// as the whole lap
+#define LAP_TRACE_JOIN_POINTS 100
+
+// bytes of an encoded point: u16 position, u16 speed, u8 throttle, u8 brake
+#define LAP_TRACE_POINT_SIZE 6
+
+/**
+ * A sample of the lap indexed by normalizedCarPosition.
+ */
+struct lapTracePoint {
+	float pos;
+	float speed;
+	float throttle;
+	float brake;
+};
+
+/**
+ * Speed, throttle, and brake of every sample of the lap being driven. At the
+ * end of the lap the trace is simplified to at most LAP_TRACE_BUDGET points
+ * and encoded for publishing. Samples arrive at LAP_RATE (see
+ * trackedSample()); a lap with no more samples than the budget, such as a
+ * replayed one at 1 Hz, is only simplified down to LAP_TRACE_TOLERANCE.
+ */
+typedef struct lapTrace {
+	struct lapTracePoint* points;
+	size_t count;
+	size_t cap;
+
+	// points kept by the simplification; as many as points
+	bool* keep;
+
+	// split candidates during the simplification; LAP_TRACE_BUDGET long
+	struct lapTraceSegment* heap;
+
+	// follows the lap; not timed if it was joined part way around
+	LapCursor cursor;
+
+	bool started;
+	int sessionIndex;
+	int completedLaps;
+
+	// base64 of the last completed lap; lapCompleted is set until it is published
+	char* encoded;
+	int encodedLap;
+	bool encodedPartial;
+	bool lapCompleted;
+} LapTrace;
+
+LapTrace* createLapTrace();
+bool lapTraceAdd(LapTrace*, const Physics*, const HUD*);
+bool lapTraceFinish(LapTrace*, int);
+cJSON* lapTraceToJSON(cJSON*, LapTrace*);
+void freeLapTrace(LapTrace*);
+
+#endif
@@ -7,6 +7,7 @@
 	curl_global_cleanup();\
 	freeSharedMem(s);\
 	freeInstanceData(d);\
+	dictFree();\
 } while(0)
 
 /**
@@ -31,6 +32,25 @@ int WINAPI wWinMain(HINSTANCE curr, HINSTANCE prev, wchar_t* args, int cmdShow)
 	}
 #endif
 
+	// install cJSON allocation hooks before any other thread starts
+	allocInit();
+	fieldsInit();
+	recInit();
+
+	// compact mode key dictionary
+	if (!dictInit()) {
+		msgBoxErr(NULL, ARE_OUT_OF_MEM, L"Out of memory");
+
+		return EXIT_FAILURE;
+	}
+
+#ifdef TRACE
+	// not fatal; the program works just the same without a trace
+	if (!traceStart("trace.json")) {
+		wprintf(L"Could not create trace.json\n");
+	}
+#endif
+
 	// initialise curl globally
 	CURLcode cc = curl_global_init(CURL_GLOBAL_DEFAULT);
 
@@ -60,10 +80,29 @@ int WINAPI wWinMain(HINSTANCE curr, HINSTANCE prev, wchar_t* args, int cmdShow)
 		return EXIT_FAILURE;
 	}
 
+	// load the per-model constants from next to the executable
+	wchar_t carsPath[EXE_PATH_SIZE];
+	int error = ARE_FILE;
+
+	if (exeRelativePath(carsPath, EXE_PATH_SIZE, CARS_FILE)) {
+		error = loadCars(carsPath, &data->cars);
+	}
+
+	if (error != 0) {
+		CLEANUP(sm, data);
+		msgBoxErr(NULL, error, L"Could not load " CARS_FILE);
+
+		return EXIT_FAILURE;
+	}
+
 	// create and run the GUI
 	gui(curr, cmdShow, data);
 	CLEANUP(sm, data);
 
+#ifdef TRACE
+	traceStop();
+#endif
+
 #ifdef DEBUG
 	// debug defined so don't exit until the user requests it
 	wprintf(L"Press enter to exit...\n");
@@ -0,0 +1,374 @@
+#include "metrics.h"
+
+// quantiles exported for every loop stage
+static const double quantiles[] = {0.5, 0.9, 0.99};
+
+static const size_t quantilesLen = sizeof(quantiles) / sizeof(quantiles[0]);
+
+/**
+ * Append formatted text to the buffer. Output is silently truncated when
+ * the buffer is full.
+ * @param buf
+ * @param len Current length of buf. Advanced by the number of bytes written.
+ * @param fmt
+ */
+static void append(char* buf, size_t* len, const char* fmt, ...) {
+	va_list argList;
+
+	if (*len >= METRICS_BUF_SIZE - 1) {
+		return;
+	}
+
+	va_start(argList, fmt);
+	int n = vsnprintf(buf + *len, METRICS_BUF_SIZE - *len, fmt, argList);
+	va_end(argList);
+
+	if (n > 0) {
+		*len += (size_t) n;
+
+		if (*len > METRICS_BUF_SIZE - 1) {
+			*len = METRICS_BUF_SIZE - 1;
+		}
+	}
+}
+
+/**
+ * Append the HELP and TYPE lines of a metric.
+ */
+static void header(char* buf, size_t* len, const char* name, const char* type, const char* help) {
+	append(buf, len, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * Render every metric into m->buf. The caller must hold the lock.
+ * @param  m
+ * @return   Length of the rendered text.
+ */
+static size_t render(Metrics* m) {
+	char* buf = m->buf;
+	size_t len = 0;
+
+	header(buf, &len, "are_ticks_total", "counter", "Completed sampling loop iterations.");
+	append(buf, &len, "are_ticks_total %llu\n", (unsigned long long) m->stats.ticks);
+
+	header(buf, &len, "are_publish_success_total", "counter", "Successful publish requests.");
+	append(buf, &len, "are_publish_success_total %llu\n", (unsigned long long) m->published);
+
+	header(buf, &len, "are_publish_failure_total", "counter", "Failed publish requests by error code.");
+
+	for (int i = 0; i < ARE_ERROR_COUNT; i++) {
+		append(buf, &len, "are_publish_failure_total{code=\"%d\",error=\"%ls\"} %llu\n",
+			ARE_ERROR_FIRST + i, errorToWstr(ARE_ERROR_FIRST + i),
+			(unsigned long long) m->failures[i]);
+	}
+
+	header(buf, &len, "are_payload_bytes_total", "counter", "JSON bytes handed to the publisher.");
+	append(buf, &len, "are_payload_bytes_total %llu\n", (unsigned long long) m->payloadBytes);
+
+	header(buf, &len, "are_stage_duration_seconds", "summary", "Sampling loop stage latencies.");
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		const Histogram* h = &m->stats.stages[i];
+		const char* stage = stageToStr(i);
+
+		for (size_t j = 0; j < quantilesLen; j++) {
+			append(buf, &len, "are_stage_duration_seconds{stage=\"%s\",quantile=\"%g\"} %.6f\n",
+				stage, quantiles[j], histogramPercentile(h, quantiles[j]) / 1e6);
+		}
+
+		append(buf, &len, "are_stage_duration_seconds_sum{stage=\"%s\"} %.6f\n", stage, h->sum / 1e6);
+		append(buf, &len, "are_stage_duration_seconds_count{stage=\"%s\"} %llu\n",
+			stage, (unsigned long long) h->count);
+	}
+
+	header(buf, &len, "are_scheduler_overruns_total", "counter", "Iterations that ran past the next deadline.");
+	append(buf, &len, "are_scheduler_overruns_total %llu\n", (unsigned long long) m->overruns);
+
+	header(buf, &len, "are_scheduler_skipped_total", "counter", "Iterations dropped to catch up with the schedule.");
+	append(buf, &len, "are_scheduler_skipped_total %llu\n", (unsigned long long) m->skipped);
+
+	header(buf, &len, "are_queue_depth", "gauge", "Entries waiting to be written by the recorder.");
+	append(buf, &len, "are_queue_depth %llu\n", (unsigned long long) m->queueDepth);
+
+	header(buf, &len, "are_queue_dropped_total", "counter", "Entries dropped because the recorder queue was full.");
+	append(buf, &len, "are_queue_dropped_total %llu\n", (unsigned long long) m->queueDropped);
+
+	header(buf, &len, "are_shared_mem_retries_total", "counter", "Shared memory copies repeated due to torn frames.");
+	append(buf, &len, "are_shared_mem_retries_total %llu\n", (unsigned long long) m->retries);
+
+	header(buf, &len, "are_groups_total", "counter", "JSON groups skipped because their fields were unchanged, and groups built.");
+	append(buf, &len, "are_groups_total{result=\"skipped\"} %llu\n", (unsigned long long) m->groups.hits);
+	append(buf, &len, "are_groups_total{result=\"built\"} %llu\n", (unsigned long long) m->groups.misses);
+
+	header(buf, &len, "are_in_car", "gauge", "Whether or not the player is in the car.");
+	append(buf, &len, "are_in_car %d\n", m->inCar ? 1 : 0);
+
+	return len;
+}
+
+/**
+ * Send all len bytes of data.
+ * @return False if the connection failed.
+ */
+static bool sendAll(SOCKET s, const char* data, size_t len) {
+	while (len > 0) {
+		int n = send(s, data, (int) len, 0);
+
+		if (n == SOCKET_ERROR) {
+			return false;
+		}
+
+		data += n;
+		len -= (size_t) n;
+	}
+
+	return true;
+}
+
+/**
+ * Answer a single scrape. Any GET is answered with the metrics; the path is ignored.
+ * @param m
+ * @param client
+ */
+static void serve(Metrics* m, SOCKET client) {
+	char req[METRICS_REQ_SIZE];
+	char head[256];
+	int n = recv(client, req, METRICS_REQ_SIZE - 1, 0);
+
+	if (n <= 0) {
+		return;
+	}
+
+	req[n] = '\0';
+
+	if (strncmp(req, "GET ", 4) != 0) {
+		const char* res = "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+		sendAll(client, res, strlen(res));
+
+		return;
+	}
+
+	AcquireSRWLockShared(&m->lock);
+	size_t len = render(m);
+	ReleaseSRWLockShared(&m->lock);
+
+	snprintf(head, sizeof(head),
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/plain; version=0.0.4\r\n"
+		"Content-Length: %zu\r\n"
+		"Connection: close\r\n\r\n", len);
+
+	if (sendAll(client, head, strlen(head))) {
+		sendAll(client, m->buf, len);
+	}
+}
+
+/**
+ * Listener thread. Implements ThreadProc. Exits once the listening socket is closed.
+ * @param  arg Cast to Metrics*
+ */
+static DWORD WINAPI listenProc(void* arg) {
+	Metrics* m = (Metrics*) arg;
+	DWORD timeout = METRICS_IO_TIMEOUT;
+
+	for (;;) {
+		SOCKET client = accept(m->listener, NULL, NULL);
+
+		if (client == INVALID_SOCKET) {
+			// listener closed by freeMetrics()
+			return 0;
+		}
+
+		// an idle or slow client must not hold up the scrapes behind it
+		setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*) &timeout, sizeof(timeout));
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, (const char*) &timeout, sizeof(timeout));
+
+		AcquireSRWLockExclusive(&m->lock);
+		bool stopping = m->stopping;
+
+		if (!stopping) {
+			m->client = client;
+		}
+
+		ReleaseSRWLockExclusive(&m->lock);
+
+		if (!stopping) {
+			serve(m, client);
+			shutdown(client, SD_SEND);
+		}
+
+		AcquireSRWLockExclusive(&m->lock);
+		m->client = INVALID_SOCKET;
+		ReleaseSRWLockExclusive(&m->lock);
+
+		closesocket(client);
+	}
+}
+
+/**
+ * Allocate a metrics object and start listening for scrapes on addr:port.
+ * @param  addr IPv4 address to bind to. Eg. "127.0.0.1" or "0.0.0.0".
+ * @param  port
+ * @return      NULL if out of memory or the listener could not be created.
+ */
+Metrics* createMetrics(const char* addr, unsigned short port) {
+	WSADATA wsa;
+
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+		return NULL;
+	}
+
+	Metrics* m = calloc(1, sizeof(*m));
+
+	if (!m) {
+		WSACleanup();
+
+		return NULL;
+	}
+
+	InitializeSRWLock(&m->lock);
+	statsReset(&m->stats);
+	m->thread = NULL;
+	m->client = INVALID_SOCKET;
+	m->stopping = false;
+	m->buf = malloc(METRICS_BUF_SIZE);
+	m->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	if (!m->buf || m->listener == INVALID_SOCKET) {
+		freeMetrics(m);
+
+		return NULL;
+	}
+
+	struct sockaddr_in sa = {0};
+
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(port);
+
+	if (inet_pton(AF_INET, addr, &sa.sin_addr) != 1 ||
+		bind(m->listener, (struct sockaddr*) &sa, sizeof(sa)) == SOCKET_ERROR ||
+		listen(m->listener, SOMAXCONN) == SOCKET_ERROR) {
+		freeMetrics(m);
+
+		return NULL;
+	}
+
+	m->thread = CreateThread(NULL, 0, &listenProc, m, 0, NULL);
+
+	if (!m->thread) {
+		freeMetrics(m);
+
+		return NULL;
+	}
+
+	return m;
+}
+
+/**
+ * Set the in-car gauge.
+ * @param m
+ * @param inCar Result of physicsIsInCar().
+ */
+void metricsInCar(Metrics* m, bool inCar) {
+	AcquireSRWLockExclusive(&m->lock);
+	m->inCar = inCar;
+	ReleaseSRWLockExclusive(&m->lock);
+}
+
+/**
+ * Count a publish attempt.
+ * @param m
+ * @param result Zero on success, otherwise an error code defined in error.h.
+ * @param bytes  Length of the JSON body.
+ */
+void metricsPublished(Metrics* m, int result, size_t bytes) {
+	AcquireSRWLockExclusive(&m->lock);
+
+	m->payloadBytes += bytes;
+
+	if (result == 0) {
+		m->published++;
+	} else if (result >= ARE_ERROR_FIRST && result < ARE_ERROR_FIRST + ARE_ERROR_COUNT) {
+		m->failures[result - ARE_ERROR_FIRST]++;
+	}
+
+	ReleaseSRWLockExclusive(&m->lock);
+}
+
+/**
+ * Set the recorder queue depth gauge and dropped counter.
+ * @param m
+ * @param depth
+ * @param dropped
+ */
+void metricsQueueDepth(Metrics* m, uint64_t depth, uint64_t dropped) {
+	AcquireSRWLockExclusive(&m->lock);
+	m->queueDepth = depth;
+	m->queueDropped = dropped;
+	ReleaseSRWLockExclusive(&m->lock);
+}
+
+/**
+ * Take a copy of the loop stats, scheduler counters, and shared memory
+ * counters at the end of an iteration.
+ * @param m
+ * @param stats
+ * @param s
+ * @param sm
+ */
+void metricsTick(Metrics* m, const LoopStats* stats, const Scheduler* s, const SharedMem* sm) {
+	AcquireSRWLockExclusive(&m->lock);
+
+	memcpy(&m->stats, stats, sizeof(*stats));
+	m->overruns = s->overruns;
+	m->skipped = s->skipped;
+	m->retries = sm->retries;
+
+	// counted on this (the processing) thread
+	m->groups = *groupStats();
+
+	ReleaseSRWLockExclusive(&m->lock);
+}
+
+/**
+ * Stop the listener thread and free the metrics object. Does nothing if m is NULL.
+ * @param m
+ */
+void freeMetrics(Metrics* m) {
+	if (!m) {
+		return;
+	}
+
+	AcquireSRWLockExclusive(&m->lock);
+	m->stopping = true;
+
+	if (m->client != INVALID_SOCKET) {
+		// unblocks recv() or send() on the connection being served
+		shutdown(m->client, SD_BOTH);
+	}
+
+	ReleaseSRWLockExclusive(&m->lock);
+
+	if (m->listener != INVALID_SOCKET) {
+		// unblocks accept() in the listener thread
+		closesocket(m->listener);
+	}
+
+	if (m->thread) {
+		DWORD wait = WaitForSingleObject(m->thread, METRICS_STOP_TIMEOUT);
+
+		CloseHandle(m->thread);
+
+		if (wait != WAIT_OBJECT_0) {
+			// the thread may still touch m, so leak it rather than free it
+			printf("Metrics listener did not stop within %dms\n", METRICS_STOP_TIMEOUT);
+
+			return;
+		}
+	}
+
+	free(m->buf);
+	free(m);
+	WSACleanup();
+}
@@ -0,0 +1,81 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdarg.h>
+
+#include "stats.h"
+#include "scheduler.h"
+#include "shared_mem.h"
+
+// windows.h has already been included with WIN32_LEAN_AND_MEAN so winsock 2
+// can be included here. Same C5105 dance as in auxiliary.h
+#pragma warning(disable:5105)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma warning(default:5105)
+
+// size of the buffer the exposition text is rendered into
+#define METRICS_BUF_SIZE 32768
+
+// bytes of an incoming request that are read (the rest is ignored)
+#define METRICS_REQ_SIZE 1024
+
+// milliseconds a scrape may take to send its request or read the response
+#define METRICS_IO_TIMEOUT 2000
+
+// milliseconds freeMetrics() waits for the listener thread to exit
+#define METRICS_STOP_TIMEOUT 5000
+
+/**
+ * Publisher health counters and gauges served in the Prometheus text format.
+ * Written by the processing thread and read by the listener thread.
+ */
+typedef struct metrics {
+	SRWLOCK lock;
+	SOCKET listener;
+	HANDLE thread;
+
+	// connection being served and whether freeMetrics() has been called;
+	// both guarded by the lock
+	SOCKET client;
+	bool stopping;
+
+	// rendering buffer; only touched by the listener thread
+	char* buf;
+
+	// loop iterations and stage latencies
+	LoopStats stats;
+
+	// scheduler counters
+	uint64_t overruns;
+	uint64_t skipped;
+
+	// successful publishes and failures indexed by areError - ARE_ERROR_FIRST
+	uint64_t published;
+	uint64_t failures[ARE_ERROR_COUNT];
+
+	// JSON bytes handed to the publisher
+	uint64_t payloadBytes;
+
+	// entries waiting to be written by the recorder and entries it dropped
+	uint64_t queueDepth;
+	uint64_t queueDropped;
+
+	// shared memory copies repeated due to torn frames
+	uint64_t retries;
+
+	// JSON groups skipped and built
+	GroupStats groups;
+
+	// whether or not physicsIsInCar() was true on the last check
+	bool inCar;
+} Metrics;
+
+Metrics* createMetrics(const char*, unsigned short);
+void metricsInCar(Metrics*, bool);
+void metricsPublished(Metrics*, int, size_t);
+void metricsQueueDepth(Metrics*, uint64_t, uint64_t);
+void metricsTick(Metrics*, const LoopStats*, const Scheduler*, const SharedMem*);
+void freeMetrics(Metrics*);
+
+#endif
@@ -0,0 +1,210 @@
+#include "mini_sectors.h"
+
+// longest int in a JSON array including the separator
+#define MINI_SECTOR_INT_WIDTH 12
+
+/**
+ * Allocate mini sector timing for count splits per lap.
+ * @param  count At least 2.
+ * @return       NULL if out of memory.
+ */
+MiniSectors* createMiniSectors(int count) {
+	MiniSectors* m = calloc(1, sizeof(*m));
+
+	if (!m) {
+		return NULL;
+	}
+
+	m->count = count;
+	m->crossings = calloc(count, sizeof(int));
+	m->lap = calloc(count, sizeof(int));
+	m->best = calloc(count, sizeof(int));
+	m->raw = malloc((size_t) count * MINI_SECTOR_INT_WIDTH + 3);
+
+	if (!m->crossings || !m->lap || !m->best || !m->raw) {
+		freeMiniSectors(m);
+
+		return NULL;
+	}
+
+	return m;
+}
+
+/**
+ * Start timing a lap from a position part way around it.
+ */
+static void startLap(MiniSectors* m, float pos, int time) {
+	lapCursorStart(&m->cursor, m->count, pos, false);
+	m->prevTime = time;
+}
+
+/**
+ * Record every boundary before the line between the last sample and pos.
+ */
+static void cross(MiniSectors* m, float pos, int time) {
+	float f;
+
+	while (lapCursorCross(&m->cursor, pos, m->count - 1, &f)) {
+		m->crossings[m->cursor.point - 1] = m->prevTime + (int) lroundf(f * (float) (time - m->prevTime));
+	}
+}
+
+/**
+ * Add a sample. A new session clears the best splits.
+ * @param m
+ * @param h
+ */
+void miniSectorsAdd(MiniSectors* m, const HUD* h) {
+	float pos = h->normalizedCarPosition;
+	float next;
+
+	if (m->started && (h->sessionIndex != m->sessionIndex || h->completedLaps < m->completedLaps)) {
+		memset(m->best, 0, sizeof(int) * m->count);
+		m->theoreticalBest = 0;
+		m->started = false;
+	}
+
+	if (!m->started) {
+		m->started = true;
+		m->sessionIndex = h->sessionIndex;
+		startLap(m, pos, h->currLapTime);
+	}
+
+	m->completedLaps = h->completedLaps;
+
+	// the line is crossed by miniSectorsFinish() on the rollover
+	if (lapCursorStep(&m->cursor, pos, &next) != LAP_STEP_FORWARD || h->currLapTime < m->prevTime) {
+		return;
+	}
+
+	cross(m, pos, h->currLapTime);
+	m->cursor.pos = pos;
+	m->prevTime = h->currLapTime;
+}
+
+/**
+ * Complete the lap at the line and start the next one. Called on the
+ * completedLaps rollover before the first sample of the next lap is added.
+ * @param m
+ * @param lapTime Lap time reported by the game (prevLapTime).
+ * @param valid   Whether or not the lap counts towards the best splits.
+ */
+void miniSectorsFinish(MiniSectors* m, int lapTime, bool valid) {
+	if (!m->started) {
+		return;
+	}
+
+	// boundaries between the last sample and the line
+	if (lapTime > m->prevTime) {
+		cross(m, 1.0f, lapTime);
+	}
+
+	m->crossings[m->count - 1] = lapTime;
+	m->lapTimed = m->cursor.timed && m->cursor.point == m->count - 1;
+
+	if (m->lapTimed) {
+		int sum = 0;
+
+		for (int i = 0; i < m->count; i++) {
+			m->lap[i] = m->crossings[i] - (i ? m->crossings[i - 1] : 0);
+
+			if (valid && m->lap[i] > 0 && (m->best[i] == 0 || m->lap[i] < m->best[i])) {
+				m->best[i] = m->lap[i];
+			}
+
+			sum = (sum >= 0 && m->best[i] > 0) ? sum + m->best[i] : -1;
+		}
+
+		m->theoreticalBest = sum > 0 ? sum : 0;
+	}
+
+	m->lapCompleted = true;
+	startLap(m, 0.0f, 0);
+}
+
+/**
+ * Format an array of ints as a raw JSON array in m->raw.
+ */
+static const char* intsToRaw(MiniSectors* m, const int* values) {
+	size_t len = 0;
+	size_t size = (size_t) m->count * MINI_SECTOR_INT_WIDTH + 3;
+
+	m->raw[len++] = '[';
+
+	for (int i = 0; i < m->count; i++) {
+		len += snprintf(m->raw + len, size - len, i ? ",%d" : "%d", values[i]);
+	}
+
+	snprintf(m->raw + len, size - len, "]");
+
+	return m->raw;
+}
+
+/**
+ * times, best, theoreticalBest.
+ */
+static cJSON* createSplits(MiniSectors* m) {
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return NULL;
+	}
+
+	// split times are only known for laps followed from the line
+	if (FIELD_ON(FLD_MINI_SECTORS_TIMES) && m->lapTimed &&
+		!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_MINI_SECTORS_TIMES), intsToRaw(m, m->lap))) {
+		RET_NULL(obj);
+	}
+
+	if (FIELD_ON(FLD_MINI_SECTORS_BEST) &&
+		!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_MINI_SECTORS_BEST), intsToRaw(m, m->best))) {
+		RET_NULL(obj);
+	}
+
+	if (FIELD_ON(FLD_MINI_SECTORS_THEORETICAL_BEST) && m->theoreticalBest > 0) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_MINI_SECTORS_THEORETICAL_BEST), m->theoreticalBest);
+	}
+
+	return obj;
+}
+
+/**
+ * Add the splits of the last completed lap until they are published, under
+ * "miniSectors".
+ * @param  parent
+ * @param  m
+ * @return        NULL if out of memory (parent is deleted).
+ */
+cJSON* miniSectorsToJSON(cJSON* parent, MiniSectors* m) {
+	if (!m->lapCompleted) {
+		return parent;
+	}
+
+	if (!fieldsAny(FLD_MINI_SECTORS_TIMES, FLD_MINI_SECTORS_THEORETICAL_BEST)) {
+		return parent;
+	}
+
+	cJSON* obj = createSplits(m);
+
+	if (!obj || !cJSON_AddItemToObject(parent, OBJECT_KEY(OBJ_MINI_SECTORS), obj)) {
+		cJSON_Delete(obj);
+		RET_NULL(parent);
+	}
+
+	return parent;
+}
+
+/**
+ * Free mini sector timing. Does nothing if m is NULL.
+ */
+void freeMiniSectors(MiniSectors* m) {
+	if (!m) {
+		return;
+	}
+
+	free(m->crossings);
+	free(m->lap);
+	free(m->best);
+	free(m->raw);
+	free(m);
+}
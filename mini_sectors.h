@@ -0,0 +1,67 @@
+#ifndef MINI_SECTORS_H
+#define MINI_SECTORS_H
+
+#include "auxiliary.h"
+#include "hud.h"
+#include "lap_cursor.h"
+
+// shortest lap (seconds) and fewest samples per split the split count is
+// limited for. Splits crossed without a sample inside them are timed by
+// interpolation alone, which makes their bests (and the theoretical best)
+// optimistic
+#define MINI_SECTOR_SHORT_LAP 60
+#define MINI_SECTOR_SAMPLES 2
+
+// most splits LAP_RATE supports
+#define MINI_SECTOR_LIMIT (LAP_RATE * MINI_SECTOR_SHORT_LAP / MINI_SECTOR_SAMPLES)
+
+// splits per lap (build time; see MINI_SECTORS in CMakeLists.txt)
+#define MINI_SECTOR_COUNT (MINI_SECTORS < MINI_SECTOR_LIMIT ? MINI_SECTORS : MINI_SECTOR_LIMIT)
+
+/**
+ * Times each of count equal splits of a lap by normalizedCarPosition. A
+ * boundary's crossing time is interpolated between the samples either side
+ * of it, each crossing costs O(1), and the best time of each split is kept
+ * for the session.
+ */
+typedef struct miniSectors {
+	int count;
+
+	// time into the current lap each boundary was crossed; boundary i is at
+	// (i + 1) / count and the last one is the line
+	int* crossings;
+
+	// split times of the last completed lap and the best of each split this
+	// session (zero until set)
+	int* lap;
+	int* best;
+
+	// boundaries are the cursor's grid points; its point is the number of
+	// boundaries crossed
+	LapCursor cursor;
+
+	// currLapTime of the last sample that moved forward
+	int prevTime;
+
+	bool started;
+	int sessionIndex;
+	int completedLaps;
+
+	// set when a lap is completed until it is published
+	bool lapCompleted;
+	bool lapTimed;
+
+	// sum of the best splits or zero if a split has no time yet
+	int theoreticalBest;
+
+	// JSON array scratch space
+	char* raw;
+} MiniSectors;
+
+MiniSectors* createMiniSectors(int);
+void miniSectorsAdd(MiniSectors*, const HUD*);
+void miniSectorsFinish(MiniSectors*, int, bool);
+cJSON* miniSectorsToJSON(cJSON*, MiniSectors*);
+void freeMiniSectors(MiniSectors*);
+
+#endif
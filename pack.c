@@ -0,0 +1,327 @@
+#include "pack.h"
+
+/**
+ * Appends bits most significant first.
+ */
+struct bitWriter {
+	uint8_t* buf;
+	size_t len;
+	uint64_t acc;
+	int bits;
+};
+
+/**
+ * Reads bits most significant first. Reading past the end yields zeros and
+ * sets overrun.
+ */
+struct bitReader {
+	const uint8_t* buf;
+	size_t size;
+	size_t pos;
+	uint64_t acc;
+	int bits;
+	bool overrun;
+};
+
+/**
+ * Write the low n (at most 32) bits of v.
+ */
+static void put(struct bitWriter* w, uint64_t v, int n) {
+	w->acc = (w->acc << n) | (v & ((1ull << n) - 1));
+	w->bits += n;
+
+	while (w->bits >= 8) {
+		w->bits -= 8;
+		w->buf[w->len++] = (uint8_t) (w->acc >> w->bits);
+	}
+}
+
+/**
+ * Write the low n (at most 64) bits of v.
+ */
+static void putWide(struct bitWriter* w, uint64_t v, int n) {
+	if (n > 32) {
+		put(w, v >> 32, n - 32);
+		n = 32;
+	}
+
+	put(w, v, n);
+}
+
+/**
+ * Write the remaining bits padded with zeros.
+ */
+static void flush(struct bitWriter* w) {
+	if (w->bits > 0) {
+		put(w, 0, 8 - w->bits);
+	}
+}
+
+/**
+ * Read n (at most 32) bits.
+ */
+static uint64_t get(struct bitReader* r, int n) {
+	while (r->bits < n) {
+		uint8_t byte = 0;
+
+		if (r->pos < r->size) {
+			byte = r->buf[r->pos++];
+		} else {
+			r->overrun = true;
+		}
+
+		r->acc = (r->acc << 8) | byte;
+		r->bits += 8;
+	}
+
+	r->bits -= n;
+
+	return (r->acc >> r->bits) & ((1ull << n) - 1);
+}
+
+/**
+ * Read n (at most 64) bits.
+ */
+static uint64_t getWide(struct bitReader* r, int n) {
+	if (n <= 32) {
+		return get(r, n);
+	}
+
+	uint64_t high = get(r, n - 32);
+
+	return (high << 32) | get(r, 32);
+}
+
+// zigzag maps signed values to unsigned so small magnitudes have few bits
+static uint64_t zigzag(int64_t v) {
+	return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+	return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+/**
+ * Write a delta-of-delta: 0 for none, then 10, 110, and 1110 prefixes for
+ * 7, 9, and 12 bit values and 1111 for anything larger (wide bits).
+ */
+static void putDod(struct bitWriter* w, int64_t dod, int wide) {
+	uint64_t z = zigzag(dod);
+
+	if (z == 0) {
+		put(w, 0, 1);
+	} else if (z < (1u << 7)) {
+		put(w, 0x2, 2);
+		put(w, z, 7);
+	} else if (z < (1u << 9)) {
+		put(w, 0x6, 3);
+		put(w, z, 9);
+	} else if (z < (1u << 12)) {
+		put(w, 0xE, 4);
+		put(w, z, 12);
+	} else {
+		put(w, 0xF, 4);
+		putWide(w, z, wide);
+	}
+}
+
+/**
+ * Read a value written by putDod().
+ */
+static int64_t getDod(struct bitReader* r, int wide) {
+	if (!get(r, 1)) {
+		return 0;
+	}
+
+	if (!get(r, 1)) {
+		return unzigzag(get(r, 7));
+	}
+
+	if (!get(r, 1)) {
+		return unzigzag(get(r, 9));
+	}
+
+	if (!get(r, 1)) {
+		return unzigzag(get(r, 12));
+	}
+
+	return unzigzag(getWide(r, wide));
+}
+
+// leading and trailing zero counts of a non-zero 32 bit value
+static int clz32(uint32_t v) {
+	int n = 0;
+
+	while (!(v & 0x80000000u)) {
+		v <<= 1;
+		n++;
+	}
+
+	return n;
+}
+
+static int ctz32(uint32_t v) {
+	int n = 0;
+
+	while (!(v & 1)) {
+		v >>= 1;
+		n++;
+	}
+
+	return n;
+}
+
+/**
+ * Upper bound of the bit stream size of count frames of size bytes.
+ */
+size_t packBound(size_t size, uint32_t count) {
+	// per value at most 44 bits for XOR (2 + 5 + 5 + 32) and 37 for
+	// delta-of-delta (4 + 33); 68 per time (4 + 64)
+	size_t bits = (size / 4) * (size_t) count * 44 + (size_t) count * 68;
+
+	return bits / 8 + 8;
+}
+
+/**
+ * Compress count frames. Every word (4 bytes) of the struct is encoded across
+ * all frames before the next word so slowly changing words cost a bit a frame.
+ * @param  out    At least packBound(size, count) bytes.
+ * @param  lanes  enum packLane for each word of the struct.
+ * @param  frames count contiguous structs.
+ * @param  size   Bytes of a struct; a multiple of 4.
+ * @param  times  Time of each frame.
+ * @param  count
+ * @return        Bytes written to out.
+ */
+size_t packFrames(uint8_t* out, const uint8_t* lanes, const void* frames, size_t size, const uint64_t* times, uint32_t count) {
+	struct bitWriter w = {out, 0, 0, 0};
+	const uint8_t* base = frames;
+	size_t words = size / 4;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	// times: first as is, then delta-of-delta
+	putWide(&w, times[0], 64);
+
+	for (uint32_t i = 1; i < count; i++) {
+		uint64_t delta = times[i] - times[i - 1];
+		uint64_t prev = i > 1 ? times[i - 1] - times[i - 2] : 0;
+
+		// unsigned so wrapping deltas stay defined
+		putDod(&w, (int64_t) (delta - prev), 64);
+	}
+
+	for (size_t j = 0; j < words; j++) {
+		uint32_t prev;
+		int32_t prevDelta = 0;
+		int lead = -1;
+		int trail = 0;
+
+		memcpy(&prev, base + j * 4, 4);
+		put(&w, prev, 32);
+
+		for (uint32_t i = 1; i < count; i++) {
+			uint32_t v;
+
+			memcpy(&v, base + (size_t) i * size + j * 4, 4);
+
+			if (lanes[j] == PACK_DOD) {
+				int32_t delta = (int32_t) (v - prev);
+
+				putDod(&w, (int64_t) delta - prevDelta, 33);
+				prevDelta = delta;
+			} else {
+				uint32_t x = v ^ prev;
+
+				if (x == 0) {
+					put(&w, 0, 1);
+				} else {
+					int l = clz32(x);
+					int t = ctz32(x);
+
+					if (lead >= 0 && l >= lead && t >= trail) {
+						// fits in the previous window of meaningful bits
+						put(&w, 0x2, 2);
+						put(&w, x >> trail, 32 - lead - trail);
+					} else {
+						lead = l;
+						trail = t;
+						put(&w, 0x3, 2);
+						put(&w, (uint64_t) lead, 5);
+						put(&w, (uint64_t) (32 - lead - trail - 1), 5);
+						put(&w, x >> trail, 32 - lead - trail);
+					}
+				}
+			}
+
+			prev = v;
+		}
+	}
+
+	flush(&w);
+
+	return w.len;
+}
+
+/**
+ * Decompress count frames written by packFrames().
+ * @param  in
+ * @param  bytes  Bytes of the bit stream.
+ * @param  lanes  Must match the lanes the frames were packed with.
+ * @param  frames Receives count contiguous structs.
+ * @param  size
+ * @param  times  Receives the time of each frame.
+ * @param  count
+ * @return        False if the stream is shorter than it should be.
+ */
+bool unpackFrames(const uint8_t* in, size_t bytes, const uint8_t* lanes, void* frames, size_t size, uint64_t* times, uint32_t count) {
+	struct bitReader r = {in, bytes, 0, 0, 0, false};
+	uint8_t* base = frames;
+	size_t words = size / 4;
+
+	if (count == 0) {
+		return true;
+	}
+
+	times[0] = getWide(&r, 64);
+
+	for (uint32_t i = 1; i < count; i++) {
+		uint64_t prev = i > 1 ? times[i - 1] - times[i - 2] : 0;
+
+		times[i] = times[i - 1] + prev + (uint64_t) getDod(&r, 64);
+	}
+
+	for (size_t j = 0; j < words; j++) {
+		uint32_t prev = (uint32_t) get(&r, 32);
+		int32_t prevDelta = 0;
+		int lead = 0;
+		int trail = 0;
+
+		memcpy(base + j * 4, &prev, 4);
+
+		for (uint32_t i = 1; i < count; i++) {
+			uint32_t v = prev;
+
+			if (lanes[j] == PACK_DOD) {
+				int32_t delta = (int32_t) ((int64_t) prevDelta + getDod(&r, 33));
+
+				v = prev + (uint32_t) delta;
+				prevDelta = delta;
+			} else if (get(&r, 1)) {
+				if (get(&r, 1)) {
+					lead = (int) get(&r, 5);
+					trail = 32 - lead - ((int) get(&r, 5) + 1);
+				}
+
+				v = prev ^ (uint32_t) (get(&r, 32 - lead - trail) << trail);
+			}
+
+			memcpy(base + (size_t) i * size + j * 4, &v, 4);
+			prev = v;
+		}
+	}
+
+	return !r.overrun;
+}
@@ -0,0 +1,22 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// how a word of a struct is encoded relative to the same word of the
+// previous frame
+enum packLane {
+	// XOR with the previous value; for floats and flags (Gorilla style)
+	PACK_XOR = 0,
+
+	// delta-of-delta; for counters that change at a steady rate
+	PACK_DOD
+};
+
+size_t packBound(size_t, uint32_t);
+size_t packFrames(uint8_t*, const uint8_t*, const void*, size_t, const uint64_t*, uint32_t);
+bool unpackFrames(const uint8_t*, size_t, const uint8_t*, void*, size_t, uint64_t*, uint32_t);
+
+#endif
@@ -1,8 +1,14 @@
 #include "physics.h"
 
+// struct grouping together the json key, the function that creates the json object,
+// the fields the object is built from (NULL to always build it), and the range of
+// fields the object contains.
 struct item {
-	char* key;
+	enum object key;
 	cJSON* (*create)(const Physics*, const Physics*);
+	const struct span* spans;
+	enum field first;
+	enum field last;
 };
 
 /**
@@ -18,10 +24,10 @@ static cJSON* createInput(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "accelerator", prev, prev->accelerator, curr->accelerator);
-	FLOAT_2_OBJ_CMP(obj, "brake", prev, prev->brake, curr->brake);
-	FLOAT_2_OBJ_CMP(obj, "steering", prev, prev->steering, curr->steering);
-	BOOL_2_OBJ_CMP(obj, "pitLimiter", prev, prev->pitLimiter, curr->pitLimiter);
+	FLOAT_2_OBJ_CMP(obj, FLD_INPUT_ACCELERATOR, prev, prev->accelerator, curr->accelerator);
+	FLOAT_2_OBJ_CMP(obj, FLD_INPUT_BRAKE, prev, prev->brake, curr->brake);
+	FLOAT_2_OBJ_CMP(obj, FLD_INPUT_STEERING, prev, prev->steering, curr->steering);
+	BOOL_2_OBJ_CMP(obj, FLD_INPUT_PIT_LIMITER, prev, prev->pitLimiter, curr->pitLimiter);
 
 	return obj;
 }
@@ -33,10 +39,10 @@ static cJSON* createPadWear(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->padDepth[W_FL], curr->padDepth[W_FL]);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->padDepth[W_FR], curr->padDepth[W_FR]);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->padDepth[W_RL], curr->padDepth[W_RL]);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->padDepth[W_RR], curr->padDepth[W_RR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_PAD_DEPTH_FL, prev, prev->padDepth[W_FL], curr->padDepth[W_FL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_PAD_DEPTH_FR, prev, prev->padDepth[W_FR], curr->padDepth[W_FR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_PAD_DEPTH_RL, prev, prev->padDepth[W_RL], curr->padDepth[W_RL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_PAD_DEPTH_RR, prev, prev->padDepth[W_RR], curr->padDepth[W_RR]);
 
 	return obj;
 }
@@ -48,10 +54,10 @@ static cJSON* createDiscWear(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->rotorDepth[W_FL], curr->rotorDepth[W_FL]);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->rotorDepth[W_FR], curr->rotorDepth[W_FR]);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->rotorDepth[W_RL], curr->rotorDepth[W_RL]);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->rotorDepth[W_RR], curr->rotorDepth[W_RR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_ROTOR_DEPTH_FL, prev, prev->rotorDepth[W_FL], curr->rotorDepth[W_FL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_ROTOR_DEPTH_FR, prev, prev->rotorDepth[W_FR], curr->rotorDepth[W_FR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_ROTOR_DEPTH_RL, prev, prev->rotorDepth[W_RL], curr->rotorDepth[W_RL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_ROTOR_DEPTH_RR, prev, prev->rotorDepth[W_RR], curr->rotorDepth[W_RR]);
 
 	return obj;
 }
@@ -63,10 +69,10 @@ static cJSON* createBrakeTemp(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->brakeTemp[W_FL], curr->brakeTemp[W_FL]);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->brakeTemp[W_FR], curr->brakeTemp[W_FR]);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->brakeTemp[W_RL], curr->brakeTemp[W_RL]);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->brakeTemp[W_RR], curr->brakeTemp[W_RR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_TEMP_FL, prev, prev->brakeTemp[W_FL], curr->brakeTemp[W_FL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_TEMP_FR, prev, prev->brakeTemp[W_FR], curr->brakeTemp[W_FR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_TEMP_RL, prev, prev->brakeTemp[W_RL], curr->brakeTemp[W_RL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_BRAKES_TEMP_RR, prev, prev->brakeTemp[W_RR], curr->brakeTemp[W_RR]);
 
 	return obj;
 }
@@ -78,28 +84,37 @@ static cJSON* createBrakeCompound(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	if (!prev || prev->frontBrakeCompound != curr->frontBrakeCompound) {
-		INT_2_OBJ(obj, "front", curr->frontBrakeCompound + 1);
+	if (FIELD_ON(FLD_BRAKES_COMPOUND_FRONT) && (!prev || prev->frontBrakeCompound != curr->frontBrakeCompound)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_BRAKES_COMPOUND_FRONT), curr->frontBrakeCompound + 1);
 	}
 
-	if (!prev || prev->rearBrakeCompound != curr->rearBrakeCompound) {
-		INT_2_OBJ(obj, "rear", curr->rearBrakeCompound + 1);
+	if (FIELD_ON(FLD_BRAKES_COMPOUND_REAR) && (!prev || prev->rearBrakeCompound != curr->rearBrakeCompound)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_BRAKES_COMPOUND_REAR), curr->rearBrakeCompound + 1);
 	}
 
 	return obj;
 }
 
+static const struct span compoundSpans[] = {
+	SPAN(Physics, frontBrakeCompound),
+	SPAN(Physics, rearBrakeCompound),
+	{0}
+};
+
+static const struct span padDepthSpans[] = {SPAN(Physics, padDepth), {0}};
+static const struct span rotorDepthSpans[] = {SPAN(Physics, rotorDepth), {0}};
+static const struct span brakeTempSpans[] = {SPAN(Physics, brakeTemp), {0}};
+
 #define PHYSICS_BRAKE_ITEM_COUNT 4
 
-struct item brakeItems[PHYSICS_BRAKE_ITEM_COUNT] = {
-	{"compound", &createBrakeCompound},
-	{"padDepth", &createPadWear},
-	{"rotorDepth", &createDiscWear},
-	{"temp", &createBrakeTemp}
+static const struct item brakeItems[PHYSICS_BRAKE_ITEM_COUNT] = {
+	{OBJ_BRAKES_COMPOUND, &createBrakeCompound, compoundSpans, FLD_BRAKES_COMPOUND_FRONT, FLD_BRAKES_COMPOUND_REAR},
+	{OBJ_BRAKES_PAD_DEPTH, &createPadWear, padDepthSpans, FLD_BRAKES_PAD_DEPTH_FL, FLD_BRAKES_PAD_DEPTH_RR},
+	{OBJ_BRAKES_ROTOR_DEPTH, &createDiscWear, rotorDepthSpans, FLD_BRAKES_ROTOR_DEPTH_FL, FLD_BRAKES_ROTOR_DEPTH_RR},
+	{OBJ_BRAKES_TEMP, &createBrakeTemp, brakeTempSpans, FLD_BRAKES_TEMP_FL, FLD_BRAKES_TEMP_RR}
 };
 
 /**
- * bias, pressure, pressure.fl, pressure.fr, pressure.rl, pressure.rr,
  * compound, compound.front, compound.rear,
  * padDepth, padDepth.fl, padDepth.fr, padDepth.rl, padDepth.rr,
  * rotorDepth, rotorDepth.fl, rotorDepth.fr, rotorDepth.rl, rotorDepth.rr,
@@ -115,9 +130,11 @@ static cJSON* createBrakes(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "bias", prev, prev->brakeBias, curr->brakeBias);
-
 	for (int i = 0; i < PHYSICS_BRAKE_ITEM_COUNT; i++) {
+		if (!fieldsAny(brakeItems[i].first, brakeItems[i].last) || !groupChanged(curr, prev, brakeItems[i].spans)) {
+			continue;
+		}
+
 		cJSON* ptr = brakeItems[i].create(curr, prev);
 
 		if (!ptr) {
@@ -125,7 +142,7 @@ static cJSON* createBrakes(const Physics* curr, const Physics* prev) {
 		}
 
 		if (cJSON_GetArraySize(ptr) > 0) {
-			if (!cJSON_AddItemToObject(obj, brakeItems[i].key, ptr)) {
+			if (!cJSON_AddItemToObject(obj, OBJECT_KEY(brakeItems[i].key), ptr)) {
 				cJSON_Delete(obj);
 				cJSON_Delete(ptr);
 
@@ -152,8 +169,8 @@ static cJSON* createTemperature(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "ambient", prev, prev->ambientTemp, curr->ambientTemp);
-	FLOAT_2_OBJ_CMP(obj, "track", prev, prev->trackTemp, curr->trackTemp);
+	FLOAT_2_OBJ_CMP(obj, FLD_TEMP_AMBIENT, prev, prev->ambientTemp, curr->ambientTemp);
+	FLOAT_2_OBJ_CMP(obj, FLD_TEMP_TRACK, prev, prev->trackTemp, curr->trackTemp);
 
 	return obj;
 }
@@ -171,12 +188,12 @@ static cJSON* createMotor(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	INT_2_OBJ_CMP(obj, "rpm", prev, prev->rpm, curr->rpm);
-	FLOAT_2_OBJ_CMP(obj, "boostPressure", prev, prev->boostPressure, curr->boostPressure);
+	INT_2_OBJ_CMP(obj, FLD_MOTOR_RPM, prev, prev->rpm, curr->rpm);
+	FLOAT_2_OBJ_CMP(obj, FLD_MOTOR_BOOST_PRESSURE, prev, prev->boostPressure, curr->boostPressure);
 
-	BOOL_2_OBJ_CMP(obj, "running", prev, prev->engineRunning, curr->engineRunning);
-	BOOL_2_OBJ_CMP(obj, "starter", prev, prev->starterMotorOn, curr->starterMotorOn);
-	BOOL_2_OBJ_CMP(obj, "ignition", prev, prev->ignitionOn, curr->ignitionOn);
+	BOOL_2_OBJ_CMP(obj, FLD_MOTOR_RUNNING, prev, prev->engineRunning, curr->engineRunning);
+	BOOL_2_OBJ_CMP(obj, FLD_MOTOR_STARTER, prev, prev->starterMotorOn, curr->starterMotorOn);
+	BOOL_2_OBJ_CMP(obj, FLD_MOTOR_IGNITION, prev, prev->ignitionOn, curr->ignitionOn);
 
 	return obj;
 }
@@ -188,10 +205,10 @@ static cJSON* createTyrePressure(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->tyrePressure[W_FL], curr->tyrePressure[W_FL]);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->tyrePressure[W_FR], curr->tyrePressure[W_FR]);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->tyrePressure[W_RL], curr->tyrePressure[W_RL]);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->tyrePressure[W_RR], curr->tyrePressure[W_RR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_PRESSURE_FL, prev, prev->tyrePressure[W_FL], curr->tyrePressure[W_FL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_PRESSURE_FR, prev, prev->tyrePressure[W_FR], curr->tyrePressure[W_FR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_PRESSURE_RL, prev, prev->tyrePressure[W_RL], curr->tyrePressure[W_RL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_PRESSURE_RR, prev, prev->tyrePressure[W_RR], curr->tyrePressure[W_RR]);
 
 	return obj;
 }
@@ -203,19 +220,22 @@ static cJSON* createTyreTemp(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "fl", prev, prev->tyreCoreTemp[W_FL], curr->tyreCoreTemp[W_FL]);
-	FLOAT_2_OBJ_CMP(obj, "fr", prev, prev->tyreCoreTemp[W_FR], curr->tyreCoreTemp[W_FR]);
-	FLOAT_2_OBJ_CMP(obj, "rl", prev, prev->tyreCoreTemp[W_RL], curr->tyreCoreTemp[W_RL]);
-	FLOAT_2_OBJ_CMP(obj, "rr", prev, prev->tyreCoreTemp[W_RR], curr->tyreCoreTemp[W_RR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_TEMP_FL, prev, prev->tyreCoreTemp[W_FL], curr->tyreCoreTemp[W_FL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_TEMP_FR, prev, prev->tyreCoreTemp[W_FR], curr->tyreCoreTemp[W_FR]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_TEMP_RL, prev, prev->tyreCoreTemp[W_RL], curr->tyreCoreTemp[W_RL]);
+	FLOAT_2_OBJ_CMP(obj, FLD_TYRES_TEMP_RR, prev, prev->tyreCoreTemp[W_RR], curr->tyreCoreTemp[W_RR]);
 
 	return obj;
 }
 
+static const struct span tyrePressureSpans[] = {SPAN(Physics, tyrePressure), {0}};
+static const struct span tyreTempSpans[] = {SPAN(Physics, tyreCoreTemp), {0}};
+
 #define PHYSICS_TYRE_ITEM_COUNT 2
 
-struct item tyreItems[PHYSICS_TYRE_ITEM_COUNT] = {
-	{"pressure", &createTyrePressure},
-	{"temp", &createTyreTemp}
+static const struct item tyreItems[PHYSICS_TYRE_ITEM_COUNT] = {
+	{OBJ_TYRES_PRESSURE, &createTyrePressure, tyrePressureSpans, FLD_TYRES_PRESSURE_FL, FLD_TYRES_PRESSURE_RR},
+	{OBJ_TYRES_TEMP, &createTyreTemp, tyreTempSpans, FLD_TYRES_TEMP_FL, FLD_TYRES_TEMP_RR}
 };
 
 /**
@@ -233,6 +253,10 @@ static cJSON* createTyres(const Physics* curr, const Physics* prev) {
 	}
 
 	for (int i = 0; i < PHYSICS_TYRE_ITEM_COUNT; i++) {
+		if (!fieldsAny(tyreItems[i].first, tyreItems[i].last) || !groupChanged(curr, prev, tyreItems[i].spans)) {
+			continue;
+		}
+
 		cJSON* ptr = tyreItems[i].create(curr, prev);
 
 		if (!ptr) {
@@ -240,12 +264,14 @@ static cJSON* createTyres(const Physics* curr, const Physics* prev) {
 		}
 
 		if (cJSON_GetArraySize(ptr) > 0) {
-			if (!cJSON_AddItemToObject(obj, tyreItems[i].key, ptr)) {
+			if (!cJSON_AddItemToObject(obj, OBJECT_KEY(tyreItems[i].key), ptr)) {
 				cJSON_Delete(obj);
 				cJSON_Delete(ptr);
 
 				return NULL;
 			}
+		} else {
+			cJSON_Delete(ptr);
 		}
 	}
 
@@ -265,24 +291,67 @@ static cJSON* createDamage(const Physics* curr, const Physics* prev) {
 		return NULL;
 	}
 
-	FLOAT_2_OBJ_CMP(obj, "front", prev, prev->carDamage[DMG_F], curr->carDamage[DMG_F]);
-	FLOAT_2_OBJ_CMP(obj, "rear", prev, prev->carDamage[DMG_B], curr->carDamage[DMG_B]);
-	FLOAT_2_OBJ_CMP(obj, "left", prev, prev->carDamage[DMG_L], curr->carDamage[DMG_L]);
-	FLOAT_2_OBJ_CMP(obj, "right", prev, prev->carDamage[DMG_R], curr->carDamage[DMG_R]);
-	FLOAT_2_OBJ_CMP(obj, "centre", prev, prev->carDamage[DMG_C], curr->carDamage[DMG_C]);
+	FLOAT_2_OBJ_CMP(obj, FLD_DAMAGE_FRONT, prev, prev->carDamage[DMG_F], curr->carDamage[DMG_F]);
+	FLOAT_2_OBJ_CMP(obj, FLD_DAMAGE_REAR, prev, prev->carDamage[DMG_B], curr->carDamage[DMG_B]);
+	FLOAT_2_OBJ_CMP(obj, FLD_DAMAGE_LEFT, prev, prev->carDamage[DMG_L], curr->carDamage[DMG_L]);
+	FLOAT_2_OBJ_CMP(obj, FLD_DAMAGE_RIGHT, prev, prev->carDamage[DMG_R], curr->carDamage[DMG_R]);
+	FLOAT_2_OBJ_CMP(obj, FLD_DAMAGE_CENTRE, prev, prev->carDamage[DMG_C], curr->carDamage[DMG_C]);
 
 	return obj;
 }
 
+// fields each sub-object is built from
+// remember to update these when adding fields to the create functions above
+static const struct span inputSpans[] = {
+	SPAN(Physics, accelerator),
+	SPAN(Physics, brake),
+	SPAN(Physics, steering),
+	SPAN(Physics, pitLimiter),
+	{0}
+};
+
+// the bias is added with the car's offset applied by deltaJSON
+static const struct span brakesSpans[] = {
+	SPAN(Physics, frontBrakeCompound),
+	SPAN(Physics, rearBrakeCompound),
+	SPAN(Physics, padDepth),
+	SPAN(Physics, rotorDepth),
+	SPAN(Physics, brakeTemp),
+	{0}
+};
+
+static const struct span temperatureSpans[] = {
+	SPAN(Physics, ambientTemp),
+	SPAN(Physics, trackTemp),
+	{0}
+};
+
+static const struct span motorSpans[] = {
+	SPAN(Physics, rpm),
+	SPAN(Physics, boostPressure),
+	SPAN(Physics, engineRunning),
+	SPAN(Physics, starterMotorOn),
+	SPAN(Physics, ignitionOn),
+	{0}
+};
+
+static const struct span tyresSpans[] = {
+	SPAN(Physics, tyrePressure),
+	SPAN(Physics, tyreCoreTemp),
+	{0}
+};
+
+static const struct span damageSpans[] = {SPAN(Physics, carDamage), {0}};
+
 #define PHYSICS_ITEM_COUNT 6
 
 static const struct item items[PHYSICS_ITEM_COUNT] = {
-	{"input", &createInput},
-	{"brakes", &createBrakes},
-	{"temp", &createTemperature},
-	{"motor", &createMotor},
-	{"tyres", &createTyres},
-	{"damage", &createDamage}
+	{OBJ_INPUT, &createInput, inputSpans, FLD_INPUT_ACCELERATOR, FLD_INPUT_PIT_LIMITER},
+	{OBJ_BRAKES, &createBrakes, brakesSpans, FLD_BRAKES_COMPOUND_FRONT, FLD_BRAKES_TEMP_RR},
+	{OBJ_TEMP, &createTemperature, temperatureSpans, FLD_TEMP_AMBIENT, FLD_TEMP_TRACK},
+	{OBJ_MOTOR, &createMotor, motorSpans, FLD_MOTOR_RPM, FLD_MOTOR_IGNITION},
+	{OBJ_TYRES, &createTyres, tyresSpans, FLD_TYRES_PRESSURE_FL, FLD_TYRES_TEMP_RR},
+	{OBJ_DAMAGE, &createDamage, damageSpans, FLD_DAMAGE_FRONT, FLD_DAMAGE_CENTRE}
 };
 
 /**
@@ -297,20 +366,25 @@ static const struct item items[PHYSICS_ITEM_COUNT] = {
  * @param prev Previous frame Physics data.
  */
 cJSON* physicsToJSON(cJSON* obj, const Physics* curr, const Physics* prev) {
-	FLOAT_2_OBJ_CMP(obj, "speed", prev, prev->speed, curr->speed);
-	INT_2_OBJ_CMP(obj, "gear", prev, prev->gear, curr->gear);
+	FLOAT_2_OBJ_CMP(obj, FLD_SPEED, prev, prev->speed, curr->speed);
+	INT_2_OBJ_CMP(obj, FLD_GEAR, prev, prev->gear, curr->gear);
 
-	FLOAT_2_OBJ_CMP(obj, "tcIntervention", prev,
+	FLOAT_2_OBJ_CMP(obj, FLD_TC_INTERVENTION, prev,
 		prev->tcIntervention, curr->tcIntervention);
 
-	FLOAT_2_OBJ_CMP(obj, "absIntervention", prev,
+	FLOAT_2_OBJ_CMP(obj, FLD_ABS_INTERVENTION, prev,
 		prev->absIntervention, curr->absIntervention);
 
-	FLOAT_2_OBJ_CMP(obj, "fuelRemaining", prev,
+	FLOAT_2_OBJ_CMP(obj, FLD_FUEL_REMAINING, prev,
 		prev->fuelRemaining, curr->fuelRemaining);
 
 	// sub-objects
 	for (int i = 0; i < PHYSICS_ITEM_COUNT; i++) {
+		// skip groups that would end up empty
+		if (!fieldsAny(items[i].first, items[i].last) || !groupChanged(curr, prev, items[i].spans)) {
+			continue;
+		}
+
 		cJSON* item = items[i].create(curr, prev);
 
 		if (!item) {
@@ -318,7 +392,7 @@ cJSON* physicsToJSON(cJSON* obj, const Physics* curr, const Physics* prev) {
 		}
 
 		if (cJSON_GetArraySize(item) > 0) {
-			if (!cJSON_AddItemToObject(obj, items[i].key, item)) {
+			if (!cJSON_AddItemToObject(obj, OBJECT_KEY(items[i].key), item)) {
 				cJSON_Delete(obj);
 				cJSON_Delete(item);
 
@@ -0,0 +1,261 @@
+#include "pool.h"
+
+struct poolWorker {
+	Pool* pool;
+	int index;
+};
+
+/**
+ * Create a pool. No threads are started until poolRun().
+ * @param  workers Number of worker threads; at least one.
+ * @return         NULL if out of memory.
+ */
+Pool* createPool(int workers) {
+	Pool* p = calloc(1, sizeof(*p));
+
+	if (!p) {
+		return NULL;
+	}
+
+	p->workers = workers > 0 ? workers : 1;
+	p->queues = calloc(p->workers, sizeof(*p->queues));
+	p->threads = calloc(p->workers, sizeof(*p->threads));
+
+	if (!p->queues || !p->threads) {
+		freePool(p);
+
+		return NULL;
+	}
+
+	for (int i = 0; i < p->workers; i++) {
+		InitializeSRWLock(&p->queues[i].lock);
+	}
+
+	InitializeSRWLock(&p->idleLock);
+	InitializeConditionVariable(&p->work);
+
+	return p;
+}
+
+/**
+ * One worker per logical processor.
+ */
+int poolDefaultWorkers() {
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+
+	return info.dwNumberOfProcessors > 0 ? (int) info.dwNumberOfProcessors : 1;
+}
+
+/**
+ * Wake idle workers. Taking the lock orders the wake after any worker that
+ * has checked its condition but not yet gone to sleep.
+ * @param p
+ * @param all Wake every worker rather than one.
+ */
+static void wake(Pool* p, bool all) {
+	AcquireSRWLockExclusive(&p->idleLock);
+	ReleaseSRWLockExclusive(&p->idleLock);
+
+	if (all) {
+		WakeAllConditionVariable(&p->work);
+	} else {
+		WakeConditionVariable(&p->work);
+	}
+}
+
+/**
+ * Add a task to a worker's deque. Tasks may be pushed before poolRun() or
+ * by running tasks, which should push onto their own worker's deque.
+ * @param  p
+ * @param  worker
+ * @param  fn
+ * @param  arg
+ * @return        False if out of memory.
+ */
+bool poolPush(Pool* p, int worker, PoolFunc fn, void* arg) {
+	struct poolQueue* q = &p->queues[worker % p->workers];
+	bool ok = true;
+
+	AcquireSRWLockExclusive(&q->lock);
+
+	// move the live tasks to the front before growing
+	if (q->tail == q->cap && q->head > 0) {
+		memmove(q->tasks, q->tasks + q->head, sizeof(*q->tasks) * (q->tail - q->head));
+		q->tail -= q->head;
+		q->head = 0;
+	}
+
+	if (q->tail == q->cap) {
+		size_t cap = q->cap ? q->cap * 2 : POOL_QUEUE_SIZE;
+		struct poolTask* temp = realloc(q->tasks, sizeof(*temp) * cap);
+
+		if (temp) {
+			q->tasks = temp;
+			q->cap = cap;
+		} else {
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		q->tasks[q->tail].fn = fn;
+		q->tasks[q->tail].arg = arg;
+		q->tail++;
+		InterlockedIncrement(&p->pending);
+		InterlockedIncrement(&p->queued);
+	}
+
+	ReleaseSRWLockExclusive(&q->lock);
+
+	if (ok) {
+		wake(p, false);
+	}
+
+	return ok;
+}
+
+/**
+ * Take the newest task of a worker's own deque.
+ */
+static bool popTask(struct poolQueue* q, struct poolTask* t) {
+	bool found = false;
+
+	AcquireSRWLockExclusive(&q->lock);
+
+	if (q->tail > q->head) {
+		*t = q->tasks[--q->tail];
+		found = true;
+	}
+
+	ReleaseSRWLockExclusive(&q->lock);
+
+	return found;
+}
+
+/**
+ * Take the oldest task of another worker's deque.
+ */
+static bool stealTask(struct poolQueue* q, struct poolTask* t) {
+	bool found = false;
+
+	AcquireSRWLockExclusive(&q->lock);
+
+	if (q->tail > q->head) {
+		*t = q->tasks[q->head++];
+		found = true;
+	}
+
+	ReleaseSRWLockExclusive(&q->lock);
+
+	return found;
+}
+
+/**
+ * Worker thread. Implements ThreadProc. Runs tasks until every pushed task
+ * has finished.
+ * @param  arg Cast to struct poolWorker*
+ * @return     Zero.
+ */
+static DWORD WINAPI workerProc(void* arg) {
+	struct poolWorker* w = (struct poolWorker*) arg;
+	Pool* p = w->pool;
+	struct poolTask t;
+
+	for (;;) {
+		bool found = popTask(&p->queues[w->index], &t);
+
+		// victims are tried in turn starting with the next worker
+		for (int i = 1; !found && i < p->workers; i++) {
+			found = stealTask(&p->queues[(w->index + i) % p->workers], &t);
+
+			if (found) {
+				InterlockedIncrement(&p->steals);
+			}
+		}
+
+		if (found) {
+			InterlockedDecrement(&p->queued);
+			t.fn(p, w->index, t.arg);
+
+			if (InterlockedDecrement(&p->pending) == 0) {
+				// let the sleeping workers exit
+				wake(p, true);
+			}
+
+			continue;
+		}
+
+		// nothing to take; a running task may still push more
+		AcquireSRWLockExclusive(&p->idleLock);
+
+		while (p->queued == 0 && p->pending > 0) {
+			SleepConditionVariableSRW(&p->work, &p->idleLock, INFINITE, 0);
+		}
+
+		bool done = p->pending == 0;
+
+		ReleaseSRWLockExclusive(&p->idleLock);
+
+		if (done) {
+			return 0;
+		}
+	}
+}
+
+/**
+ * Start the workers and wait until every task, including the ones pushed by
+ * other tasks, has finished.
+ * @return False if a thread could not be started or out of memory. Tasks
+ *         left over are then run by the threads that did start, if any.
+ */
+bool poolRun(Pool* p) {
+	struct poolWorker* workers = malloc(sizeof(*workers) * p->workers);
+	int started = 0;
+
+	if (!workers) {
+		return false;
+	}
+
+	for (int i = 0; i < p->workers; i++) {
+		workers[i].pool = p;
+		workers[i].index = i;
+		p->threads[i] = CreateThread(NULL, 0, &workerProc, &workers[i], 0, NULL);
+
+		if (p->threads[i]) {
+			started++;
+		}
+	}
+
+	for (int i = 0; i < p->workers; i++) {
+		if (p->threads[i]) {
+			WaitForSingleObject(p->threads[i], INFINITE);
+			CloseHandle(p->threads[i]);
+			p->threads[i] = NULL;
+		}
+	}
+
+	free(workers);
+
+	return started == p->workers;
+}
+
+/**
+ * Free a pool and any tasks it did not run. Does nothing if p is NULL.
+ */
+void freePool(Pool* p) {
+	if (!p) {
+		return;
+	}
+
+	if (p->queues) {
+		for (int i = 0; i < p->workers; i++) {
+			free(p->queues[i].tasks);
+		}
+	}
+
+	free(p->queues);
+	free(p->threads);
+	free(p);
+}
@@ -0,0 +1,64 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "auxiliary.h"
+
+// initial capacity of each worker's deque
+#define POOL_QUEUE_SIZE 64
+
+struct pool;
+
+/**
+ * Runs on a worker thread and may push further tasks onto that worker's deque.
+ * @param pool
+ * @param worker Index of the worker running the task.
+ * @param arg
+ */
+typedef void (*PoolFunc)(struct pool*, int, void*);
+
+struct poolTask {
+	PoolFunc fn;
+	void* arg;
+};
+
+/**
+ * A worker's tasks. The owner pushes and pops at the tail; idle workers
+ * steal from the head so they take the oldest (usually largest) tasks.
+ */
+struct poolQueue {
+	SRWLOCK lock;
+	struct poolTask* tasks;
+	size_t head;
+	size_t tail;
+	size_t cap;
+};
+
+/**
+ * Fixed set of worker threads with a deque each. Workers run their own tasks
+ * newest first and steal from the others once they run out.
+ */
+typedef struct pool {
+	int workers;
+	struct poolQueue* queues;
+	HANDLE* threads;
+
+	// tasks pushed and not yet finished; the workers exit once it reaches zero
+	volatile LONG pending;
+
+	// tasks waiting in a deque; idle workers sleep on work until it is
+	// non-zero or pending reaches zero
+	volatile LONG queued;
+	SRWLOCK idleLock;
+	CONDITION_VARIABLE work;
+
+	// tasks taken from another worker's deque
+	volatile LONG steals;
+} Pool;
+
+Pool* createPool(int);
+int poolDefaultWorkers();
+bool poolPush(Pool*, int, PoolFunc, void*);
+bool poolRun(Pool*);
+void freePool(Pool*);
+
+#endif
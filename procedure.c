@@ -1,16 +1,33 @@
 #include "procedure.h"
 
-// groups the curl handler, header list, and tracked extra data
+// groups the curl handler, header list, tracked extra data, session context,
+// loop timings, the loop scheduler, the metrics listener, the per-tick arena,
+// and the flight recorder
 struct attributes {
 	CURL* curl;
 	Tracked* tracked;
+	Session* session;
+	LoopStats* stats;
+	Scheduler* scheduler;
+	Metrics* metrics;
+	Arena* arena;
+	Recorder* recorder;
 	struct curl_slist* headers;
+
+	// fields the server has subscribed to and whether keys are shortened
+	Encoding encoding;
 };
 
 /**
  * Free memory allocated for the url, header, and curl.
  */
 static void freeAttributes(struct attributes a) {
+	freeRecorder(a.recorder);
+	freeArena(a.arena);
+	freeMetrics(a.metrics);
+	free(a.stats);
+	freeScheduler(a.scheduler);
+	freeSession(a.session);
 	freeTracked(a.tracked);
 	curl_easy_cleanup(a.curl);
 	curl_slist_free_all(a.headers);
@@ -27,6 +44,13 @@ static DWORD initAttributes(struct attributes* a, InstanceData* data) {
 	a->curl = NULL;
 	a->headers = NULL;
 	a->tracked = NULL;
+	a->session = NULL;
+	a->stats = NULL;
+	a->scheduler = NULL;
+	a->metrics = NULL;
+	a->arena = NULL;
+	a->recorder = NULL;
+	fieldsDefault(&a->encoding);
 
 	// force initialisation of the message queue
 	MSG msg;
@@ -86,6 +110,66 @@ static DWORD initAttributes(struct attributes* a, InstanceData* data) {
 		return ARE_OUT_OF_MEM;
 	}
 
+	a->session = createSession(data->cars);
+
+	if (!a->session) {
+		freeAttributes(*a);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	// allocated once up front so that recording timings never allocates
+	a->stats = malloc(sizeof(*a->stats));
+
+	if (!a->stats) {
+		freeAttributes(*a);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	statsReset(a->stats);
+
+#ifdef CATCH_UP_MISSED
+	a->scheduler = createScheduler(LOOP_PERIOD, MISS_CATCH_UP);
+#else
+	a->scheduler = createScheduler(LOOP_PERIOD, MISS_SKIP);
+#endif
+
+	if (!a->scheduler) {
+		freeAttributes(*a);
+
+		return ARE_EVENT;
+	}
+
+#ifdef METRICS
+	a->metrics = createMetrics(METRICS_ADDR, METRICS_PORT);
+
+	if (!a->metrics) {
+		freeAttributes(*a);
+
+		return ARE_SOCKET;
+	}
+#endif
+
+	// every allocation made while building and sending a tick comes from here
+	a->arena = createArena(ARENA_INIT_SIZE);
+
+	if (!a->arena) {
+		freeAttributes(*a);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+#ifdef RECORD_DATA
+	a->recorder = createRecorder(data->sm, LOOP_PERIOD);
+
+	if (!a->recorder) {
+		freeAttributes(*a);
+
+		return ARE_THREAD;
+	}
+#endif
+
 	// signal the event in order for the parent to proceed
 	if (!SetEvent(data->threadEvent)) {
 		return ARE_EVENT;
@@ -105,6 +189,41 @@ static bool terminate() {
 	return (msg.message == WM_QUIT);
 }
 
+/**
+ * Feed the lap engines the samples between this broadcast and the next,
+ * LAP_PERIOD apart. Samples whose time has already passed are dropped
+ * rather than taken back to back, and sampling stops if the player leaves
+ * the car.
+ * @param  a
+ * @param  sm
+ * @return    False if out of memory.
+ */
+static bool sampleLaps(struct attributes* a, SharedMem* sm) {
+	for (int i = 1; i < LAP_SUB_SAMPLES; i++) {
+		uint64_t due = a->scheduler->deadline + (uint64_t) i * LAP_PERIOD;
+
+		if (timerNow() > due) {
+			continue;
+		}
+
+		if (!schedulerSleepUntil(a->scheduler, due) || !physicsIsInCar(sm->curr.physics)) {
+			// schedulerWait() deals with a broken timer
+			return true;
+		}
+
+		uint64_t start = timerNow();
+		bool ok = trackedSample(a->tracked, sm->curr.physics, sm->curr.hud);
+
+		statsStage(a->stats, STAGE_LAPS, start);
+
+		if (!ok) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Main loop. Implements ThreadProc.
  * @param  arg Cast to InstanceData*
@@ -114,6 +233,8 @@ DWORD WINAPI procedure(void* arg) {
 	struct attributes attr;
 	InstanceData* data = (InstanceData*) arg;
 
+	TRACE_THREAD("procedure");
+
 	// init message queue, curl, and necessary strings
 	DWORD result = initAttributes(&attr, data);
 
@@ -122,25 +243,29 @@ DWORD WINAPI procedure(void* arg) {
 		return result;
 	}
 
-#ifdef RECORD_DATA
-	// open file in binary mode so that fseek doesn't interpret
-	// a line feed character as two bytes due to windows
-	// convention being \r\n
-	FILE* out = fopen("data.json", "wb");
+	// complete data set on the first run and any time the user
+	// gets back into the car
+	bool completeData = true;
 
-	if (!out) {
-		return ARE_THREAD;
-	}
+	// complete data once after the server changes its subscription
+	bool resend = false;
 
-	fprintf(out, "[\n");
+#ifndef DISABLE_BROADCAST
+	// publishes that have failed in a row
+	int failures = 0;
 #endif
 
-	// complete data set on the first run and any time the user
-	// gets back into the car
-	bool completeData = true;
+	// build only the subscribed fields
+	fieldsUse(&attr.encoding);
 
 	while (!terminate()) {
-		if (!physicsIsInCar(data->sm->curr.physics)) {
+		bool inCar = physicsIsInCar(data->sm->curr.physics);
+
+	#ifdef METRICS
+		metricsInCar(attr.metrics, inCar);
+	#endif
+
+		if (!inCar) {
 			// wait until the player is in the car
 			Sleep(SLEEP_DURATION);
 
@@ -149,75 +274,187 @@ DWORD WINAPI procedure(void* arg) {
 			continue;
 		}
 
+		// rebuild the session context if the properties have changed
+		if (!sessionUpdate(attr.session, data->sm->curr.props)) {
+			result = ARE_OUT_OF_MEM;
+			break;
+		}
+
 		if (completeData) {
-			// update the track sector count
-			resetSectors(attr.tracked);
+			// start a fresh schedule since the loop may have been idle
+			schedulerReset(attr.scheduler);
+		}
 
-			if (!setSectorCount(attr.tracked, data->sm->curr.props->sectorCount)) {
+		if (completeData || attr.session->updated) {
+			// update the track sector count
+			if (!setSectorCount(attr.tracked, attr.session->sectorCount)) {
 				// re-allocation failed
 				result = ARE_OUT_OF_MEM;
 				break;
 			}
+
+			// the cached map of a new track is read on its own thread
+			if (attr.session->track) {
+				trackMapSetTrack(attr.tracked->map, attr.session->track);
+			}
 		}
 
+		TRACE_BEGIN(tick, "tick");
+
+		// everything allocated from here until the reset below is released at once
+		allocUseArena(attr.arena);
+
 		// get a time stamp to measure the length of the process
-		ULONGLONG start = GetTickCount64();
-		char* json = deltaJSON(data->sm, attr.tracked, completeData);
+		uint64_t start = timerNow();
+		bool complete = completeData || resend;
 
-		if (completeData) {
-			completeData = false;
+		if (!trackedSample(attr.tracked, data->sm->curr.physics, data->sm->curr.hud)) {
+			result = ARE_OUT_OF_MEM;
+			break;
 		}
 
+		uint64_t now = statsStage(attr.stats, STAGE_LAPS, start);
+
+		proximityUpdate(attr.tracked->proximity, data->sm->curr.physics, data->sm->curr.hud);
+		now = statsStage(attr.stats, STAGE_PROXIMITY, now);
+
+		char* json = deltaJSON(data->sm, attr.tracked, attr.session, complete);
+		now = statsStage(attr.stats, STAGE_DELTA, now);
+
+		completeData = false;
+		resend = false;
+
 		if (!json) {
 			// out of memory
 			result = ARE_OUT_OF_MEM;
 			break;
 		}
 
-	#ifdef RECORD_DATA
-		fprintf(out, "\t%s,\n", json);
-	#endif
-
 	#ifndef DISABLE_BROADCAST
 		// send the json to the server
-		result = publish(attr.curl, json);
+		cJSON* reply = NULL;
+
+		TRACE_BEGIN(pub, "publish");
+		result = publish(attr.curl, json, &reply);
+		now = statsStage(attr.stats, STAGE_PUBLISH, now);
+		TRACE_END(pub);
+
+	#ifdef METRICS
+		metricsPublished(attr.metrics, result, strlen(json));
+	#endif
 
-		if (result != 0) {
-			// something went wrong with curl or no memory
+		if (result == ARE_CURL || result == ARE_SERVER) {
+			// the connection or the server may recover; anything else
+			// (no memory, a rejected request) will not
+			if (++failures >= PUBLISH_MAX_FAILURES) {
+				break;
+			}
+
+			// the server missed this delta
+			resend = true;
+			result = 0;
+		} else if (result != 0) {
 			break;
+		} else {
+			failures = 0;
+
+			// the server has the completed lap's results
+			trackedPublished(attr.tracked);
 		}
+
+		if (reply) {
+			// the server may have changed its subscription
+			resend = replyApply(reply, &attr.encoding, attr.tracked->reference);
+			cJSON_Delete(reply);
+		}
+	#else
+		trackedPublished(attr.tracked);
 	#endif
 
 		// json no longer required
-		free(json);
+		cJSON_free(json);
+		allocUseArena(NULL);
 
 		// copy the current frame's data to the previous frame
+		TRACE_BEGIN(snapshot, "snapshot");
 		sharedMemCurrToPrev(data->sm);
+		now = statsStage(attr.stats, STAGE_SNAPSHOT, now);
+		TRACE_END(snapshot);
+
+	#ifdef RECORD_DATA
+		// the snapshot is a consistent copy of this frame; properties are
+		// recorded with complete frames and whenever they change. Only
+		// copies the frame; the writer thread does the disk I/O
+		TRACE_BEGIN(record, "record");
+		bool recorded = recorderFrame(attr.recorder, &data->sm->prev, complete || attr.session->updated);
+		now = statsStage(attr.stats, STAGE_RECORD, now);
+		TRACE_END(record);
+
+		if (!recorded) {
+			result = ARE_FILE;
+			break;
+		}
+	#endif
+
+		// release this tick's allocations and close its counters
+		arenaReset(attr.arena);
+		allocTick();
 
-		// determine how long the above process took and sleep
-		// for MAX_LOOP_TIME - duration (if at all)
-		ULONGLONG duration = GetTickCount64() - start;
-		ULONGLONG ms = MAX_LOOP_TIME - duration;
+		if (++attr.stats->ticks % STATS_LOG_INTERVAL == 0) {
+			statsPrint(attr.stats);
+			schedulerPrint(attr.scheduler);
+			allocPrint();
+			arenaPrint(attr.arena);
+			groupPrint();
+
+		#ifdef RECORD_DATA
+			recorderPrint(attr.recorder);
+		#endif
+		}
+
+	#ifdef METRICS
+		metricsTick(attr.metrics, attr.stats, attr.scheduler, data->sm);
+
+	#ifdef RECORD_DATA
+		uint64_t dropped;
+		uint64_t depth = recorderDepth(attr.recorder, &dropped);
+
+		metricsQueueDepth(attr.metrics, depth, dropped);
+	#endif
+	#endif
 
 	#ifdef DEBUG
-		wprintf(L"duration: %llu, ms: %llu\n", duration, ms);
+		wprintf(L"duration: %lluus\n", now - start);
 	#endif
 
-		// since ms is unsigned, the sleep duration could work out to be longer
-		// than MAX_LOOP_TIME due to an underflow. So only sleep if the value is between
-		// zero and MAX_LOOP_TIME
-		if (ms > 0 && ms <= MAX_LOOP_TIME) {
-			Sleep((DWORD) ms);
+		TRACE_END(tick);
+
+		// the lap engines are sampled faster than the broadcasts
+		if (!sampleLaps(&attr, data->sm)) {
+			result = ARE_OUT_OF_MEM;
+			break;
 		}
+
+		// wait for the next deadline and record how late it was hit
+		histogramRecord(&attr.stats->stages[STAGE_OVERSHOOT], schedulerWait(attr.scheduler));
 	}
 
-#ifdef RECORD_DATA
-	// go back two to overwrite the last comma
-	// encoding should be utf-8 so only need to go back 2 bytes
-	fseek(out, -2L, SEEK_CUR);
-	fprintf(out, "\n]\n");
-	fclose(out);
-#endif
+	// the loop may have been left mid-tick
+	allocUseArena(NULL);
+	fieldsUse(NULL);
+
+	if (attr.stats->ticks > 0) {
+		// final summary for this run
+		statsPrint(attr.stats);
+		schedulerPrint(attr.scheduler);
+		allocPrint();
+		arenaPrint(attr.arena);
+		groupPrint();
+
+	#ifdef RECORD_DATA
+		recorderPrint(attr.recorder);
+	#endif
+	}
 
 	// free all the mallocs
 	freeAttributes(attr);
@@ -2,11 +2,18 @@
 #define PROCEDURE_H
 
 #include "api.h"
+#include "reply.h"
 #include "delta.h"
+#include "stats.h"
+#include "scheduler.h"
+#include "metrics.h"
+#include "recorder.h"
 #include "instance_data.h"
 
 #define SLEEP_DURATION 1000
-#define MAX_LOOP_TIME 1000
+
+// consecutive curl or server errors tolerated before the loop gives up
+#define PUBLISH_MAX_FAILURES 10
 
 DWORD WINAPI procedure(void* arg);
 
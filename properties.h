@@ -95,6 +95,5 @@ typedef struct properties {
 } Properties;
 
 cJSON* propertiesToJSON(cJSON*, const Properties*);
-bool propertiesUpdated(const Properties* a, const Properties* b);
 
 #endif
@@ -0,0 +1,193 @@
+#include "proximity.h"
+
+// longest car entry of the cars array: id, along, and across
+#define PROXIMITY_CAR_WIDTH 40
+
+/**
+ * Allocate proximity state on the heap.
+ * @return NULL if out of memory.
+ */
+Proximity* createProximity() {
+	Proximity* p = calloc(1, sizeof(*p));
+
+	if (!p) {
+		return NULL;
+	}
+
+	p->raw = malloc(PROXIMITY_CARS * PROXIMITY_CAR_WIDTH + 3);
+
+	if (!p->raw) {
+		freeProximity(p);
+
+		return NULL;
+	}
+
+	// until the player moves
+	p->forward[1] = 1.0f;
+
+	return p;
+}
+
+/**
+ * Find the cars within PROXIMITY_RADIUS of the player and the nearest car
+ * ahead of and behind the player.
+ * @param p
+ * @param phy Physics of the player for the direction of travel.
+ * @param h
+ */
+void proximityUpdate(Proximity* p, const Physics* phy, const HUD* h) {
+	int count = h->activeCars < PROXIMITY_CARS ? h->activeCars : PROXIMITY_CARS;
+	int player = -1;
+
+	p->count = 0;
+	p->ahead = -1;
+	p->behind = -1;
+
+	for (int i = 0; i < count; i++) {
+		if (h->carID[i] == h->playerCarID) {
+			player = i;
+			break;
+		}
+	}
+
+	p->valid = player >= 0;
+
+	if (!p->valid) {
+		return;
+	}
+
+	float vx = phy->velocityVector[0];
+	float vz = phy->velocityVector[2];
+	float speed = sqrtf(vx * vx + vz * vz);
+
+	if (speed >= PROXIMITY_MIN_SPEED) {
+		p->forward[0] = vx / speed;
+		p->forward[1] = vz / speed;
+	}
+
+	const float* c = h->carCoordinates[player];
+
+	// distances first in a loop without branches so it vectorises
+	for (int i = 0; i < count; i++) {
+		float ox = h->carCoordinates[i][0] - c[0];
+		float oz = h->carCoordinates[i][2] - c[2];
+
+		p->distances[i] = ox * ox + oz * oz;
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (i == player || p->distances[i] > PROXIMITY_RADIUS * PROXIMITY_RADIUS) {
+			continue;
+		}
+
+		float ox = h->carCoordinates[i][0] - c[0];
+		float oz = h->carCoordinates[i][2] - c[2];
+		struct proximityCar* car = &p->cars[p->count];
+
+		car->id = h->carID[i];
+		car->along = ox * p->forward[0] + oz * p->forward[1];
+		car->across = p->forward[1] * ox - p->forward[0] * oz;
+		car->distance = sqrtf(p->distances[i]);
+
+		int* nearest = car->along > 0.0f ? &p->ahead : &p->behind;
+
+		if (*nearest < 0 || car->distance < p->cars[*nearest].distance) {
+			*nearest = p->count;
+		}
+
+		p->count++;
+	}
+}
+
+/**
+ * Add "[id, distance]" under the key of f if the car exists.
+ */
+static cJSON* nearestToJSON(cJSON* obj, Proximity* p, enum field f, int idx) {
+	if (!FIELD_ON(f) || idx < 0) {
+		return obj;
+	}
+
+	char raw[JSON_RAW_FLOAT_WIDTH * 2];
+
+	snprintf(raw, sizeof(raw), "[%d,%.2f]", p->cars[idx].id, p->cars[idx].distance);
+
+	if (!cJSON_AddRawToObject(obj, FIELD_KEY(f), raw)) {
+		RET_NULL(obj);
+	}
+
+	return obj;
+}
+
+/**
+ * ahead, behind, cars.
+ */
+static cJSON* createNearby(Proximity* p) {
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return NULL;
+	}
+
+	obj = nearestToJSON(obj, p, FLD_PROXIMITY_AHEAD, p->ahead);
+
+	if (obj) {
+		obj = nearestToJSON(obj, p, FLD_PROXIMITY_BEHIND, p->behind);
+	}
+
+	if (!obj || !FIELD_ON(FLD_PROXIMITY_CARS)) {
+		return obj;
+	}
+
+	size_t size = PROXIMITY_CARS * PROXIMITY_CAR_WIDTH + 3;
+	size_t len = 0;
+
+	// flat array of id, along, across for each car
+	p->raw[len++] = '[';
+
+	for (int i = 0; i < p->count; i++) {
+		const struct proximityCar* car = &p->cars[i];
+
+		len += snprintf(p->raw + len, size - len, i ? ",%d,%.2f,%.2f" : "%d,%.2f,%.2f", car->id, car->along, car->across);
+	}
+
+	snprintf(p->raw + len, size - len, "]");
+
+	if (!cJSON_AddRawToObject(obj, FIELD_KEY(FLD_PROXIMITY_CARS), p->raw)) {
+		RET_NULL(obj);
+	}
+
+	return obj;
+}
+
+/**
+ * Add the cars near the player found by the last update under "proximity".
+ * @param  parent
+ * @param  p
+ * @return        NULL if out of memory (parent is deleted).
+ */
+cJSON* proximityToJSON(cJSON* parent, Proximity* p) {
+	if (!p->valid || !fieldsAny(FLD_PROXIMITY_AHEAD, FLD_PROXIMITY_CARS)) {
+		return parent;
+	}
+
+	cJSON* obj = createNearby(p);
+
+	if (!obj || !cJSON_AddItemToObject(parent, OBJECT_KEY(OBJ_PROXIMITY), obj)) {
+		cJSON_Delete(obj);
+		RET_NULL(parent);
+	}
+
+	return parent;
+}
+
+/**
+ * Free proximity state. Does nothing if p is NULL.
+ */
+void freeProximity(Proximity* p) {
+	if (!p) {
+		return;
+	}
+
+	free(p->raw);
+	free(p);
+}
@@ -0,0 +1,61 @@
+#ifndef PROXIMITY_H
+#define PROXIMITY_H
+
+#include "auxiliary.h"
+#include "physics.h"
+#include "hud.h"
+
+// cars within this many metres of the player are reported
+#define PROXIMITY_RADIUS 50.0f
+
+// size of HUD.carCoordinates
+#define PROXIMITY_CARS 60
+
+// below this speed (m/s) the player's direction of travel is not updated
+#define PROXIMITY_MIN_SPEED 1.0f
+
+/**
+ * A car near the player relative to the player's direction of travel.
+ */
+struct proximityCar {
+	int id;
+
+	// metres ahead (negative if behind) and to the side (positive towards
+	// +x when travelling towards +z)
+	float along;
+	float across;
+	float distance;
+};
+
+/**
+ * The cars found near the player by the last update. With at most 60 cars a
+ * straight pass over every car's squared distance (which vectorises) is
+ * several times cheaper than binning the cars into a spatial grid first.
+ */
+typedef struct proximity {
+	// squared distances (x, z) to every car, kept here so they are contiguous
+	float distances[PROXIMITY_CARS];
+
+	// unit direction of travel (x, z) of the player
+	float forward[2];
+
+	// the player was found at the last update
+	bool valid;
+
+	struct proximityCar cars[PROXIMITY_CARS];
+	int count;
+
+	// index into cars of the nearest car ahead and behind, -1 if none
+	int ahead;
+	int behind;
+
+	// JSON scratch space
+	char* raw;
+} Proximity;
+
+Proximity* createProximity();
+void proximityUpdate(Proximity*, const Physics*, const HUD*);
+cJSON* proximityToJSON(cJSON*, Proximity*);
+void freeProximity(Proximity*);
+
+#endif
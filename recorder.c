@@ -0,0 +1,399 @@
+#include "recorder.h"
+
+/**
+ * Append a block with its header, payload, and padding to the current segment.
+ * @return False if the write failed.
+ */
+static bool writeBlock(Recorder* r, enum recBlockType type, uint64_t time, const void* data, size_t size) {
+	size_t written = recWriteBlock(r->out, type, time, data, size);
+
+	r->segmentBytes += written;
+
+	return written != 0;
+}
+
+/**
+ * Flush the current segment through to the disk.
+ * @return False if the flush failed.
+ */
+static bool syncSegment(Recorder* r) {
+	r->lastSync = timerNow();
+
+	if (fflush(r->out) != 0) {
+		return false;
+	}
+
+	HANDLE h = (HANDLE) _get_osfhandle(_fileno(r->out));
+
+	return h != INVALID_HANDLE_VALUE && FlushFileBuffers(h);
+}
+
+/**
+ * Write the frames waiting to be packed, if any, as a physics block followed
+ * by a HUD block and add them to the index. Does nothing unless built with
+ * RECORD_COMPRESS.
+ * @return False if a write failed or out of memory.
+ */
+static bool flushPack(Recorder* r) {
+	#ifdef RECORD_COMPRESS
+	uint32_t count = r->packCount;
+	uint64_t offset = r->segmentBytes;
+	size_t physics, hud;
+
+	if (count == 0) {
+		return true;
+	}
+
+	r->packCount = 0;
+	physics = recWritePacked(r->out, REC_BLOCK_PHYSICS, r->packPhysics, sizeof(Physics), r->packTimes, count, r->packOut);
+	r->segmentBytes += physics;
+	hud = physics ? recWritePacked(r->out, REC_BLOCK_HUD, r->packHud, sizeof(HUD), r->packTimes, count, r->packOut) : 0;
+	r->segmentBytes += hud;
+
+	if (!hud) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		RecIndexEntry at = {offset, r->packTimes[i], r->propsOffset};
+
+		at.frame = i;
+
+		if (!recIndexFrame(&r->index, &r->packHud[i], &at)) {
+			return false;
+		}
+	}
+	#endif
+
+	return true;
+}
+
+/**
+ * Append the index, sync, and close the current segment, if any.
+ * @return False if the index could not be written or the final sync failed.
+ */
+static bool closeSegment(Recorder* r) {
+	if (!r->out) {
+		return true;
+	}
+
+	bool synced = flushPack(r) && recWriteIndex(r->out, &r->index, r->segmentBytes) && syncSegment(r);
+
+	recIndexReset(&r->index);
+
+	fclose(r->out);
+	r->out = NULL;
+
+	return synced;
+}
+
+/**
+ * Close the current segment and start the next one with the frame at time.
+ * The latest properties are repeated so the segment can be read on its own.
+ * @return False if a file operation failed.
+ */
+static bool openSegment(Recorder* r, uint64_t time) {
+	char path[REC_PATH_SIZE + 16];
+
+	if (!closeSegment(r)) {
+		return false;
+	}
+
+	snprintf(path, sizeof(path), "%s-%04u.rec", r->prefix, r->segment++);
+	r->out = fopen(path, "wb");
+
+	if (!r->out) {
+		return false;
+	}
+
+	// block times in the segment are relative to its first frame
+	r->header.start = r->wallStart + time * 10;
+	r->segmentStart = time;
+	r->segmentBytes = sizeof(r->header);
+	r->propsOffset = r->haveProps ? sizeof(r->header) : 0;
+
+	if (fwrite(&r->header, sizeof(r->header), 1, r->out) != 1) {
+		return false;
+	}
+
+	return !r->haveProps || writeBlock(r, REC_BLOCK_PROPS, 0, &r->props, sizeof(r->props));
+}
+
+/**
+ * Write a queued frame, starting a new segment first if the current one is
+ * full or old enough.
+ * @return False if a file operation failed.
+ */
+static bool writeFrame(Recorder* r, const struct recSlot* f) {
+	if (f->hasProps) {
+		memcpy(&r->props, &f->props, sizeof(r->props));
+	}
+
+	// a limit of zero disables it
+	bool rotate = !r->out ||
+		(REC_SEGMENT_BYTES && r->segmentBytes >= REC_SEGMENT_BYTES) ||
+		(REC_SEGMENT_TIME && f->time - r->segmentStart >= REC_SEGMENT_TIME);
+
+	#ifndef RECORD_COMPRESS
+	// where the frame starts (including properties written with it)
+	uint64_t offset = rotate ? sizeof(RecHeader) : r->segmentBytes;
+	#endif
+
+	if (rotate) {
+		// properties are written by openSegment()
+		r->haveProps = r->haveProps || f->hasProps;
+
+		if (!openSegment(r, f->time)) {
+			return false;
+		}
+	} else if (f->hasProps) {
+		r->haveProps = true;
+
+		// packed frames must come before the properties that follow them
+		if (!flushPack(r)) {
+			return false;
+		}
+
+		r->propsOffset = r->segmentBytes;
+
+		if (!writeBlock(r, REC_BLOCK_PROPS, f->time - r->segmentStart, &r->props, sizeof(r->props))) {
+			return false;
+		}
+	}
+
+	uint64_t time = f->time - r->segmentStart;
+
+	#ifdef RECORD_COMPRESS
+	memcpy(&r->packPhysics[r->packCount], &f->physics, sizeof(f->physics));
+	memcpy(&r->packHud[r->packCount], &f->hud, sizeof(f->hud));
+	r->packTimes[r->packCount++] = time;
+
+	return r->packCount < REC_PACK_FRAMES || flushPack(r);
+	#else
+	RecIndexEntry at = {offset, time, r->propsOffset};
+
+	return writeBlock(r, REC_BLOCK_PHYSICS, time, &f->physics, sizeof(f->physics)) &&
+		writeBlock(r, REC_BLOCK_HUD, time, &f->hud, sizeof(f->hud)) &&
+		recIndexFrame(&r->index, &f->hud, &at);
+	#endif
+}
+
+/**
+ * Writer thread. Implements ThreadProc. Drains the queue until it is empty
+ * and the recorder has been stopped.
+ * @param  arg Cast to Recorder*
+ * @return     0 on success, ARE_FILE if a write failed.
+ */
+static DWORD WINAPI writeProc(void* arg) {
+	Recorder* r = (Recorder*) arg;
+	bool ok = true;
+
+	TRACE_THREAD("recorder");
+	AcquireSRWLockExclusive(&r->lock);
+
+	while (ok) {
+		if (r->head == r->tail) {
+			if (r->stop) {
+				break;
+			}
+
+			// woken by a new frame, a stop, or the timeout
+			SleepConditionVariableSRW(&r->ready, &r->lock, REC_WAKE_MS, 0);
+		}
+
+		uint64_t tail = r->tail;
+		uint64_t head = r->head;
+
+		ReleaseSRWLockExclusive(&r->lock);
+
+		// the slots between tail and head belong to this thread until tail is advanced
+		TRACE_BEGIN(span, "write");
+
+		for (uint64_t i = tail; ok && i < head; i++) {
+			ok = writeFrame(r, &r->slots[i % REC_QUEUE_SLOTS]);
+		}
+
+		// the group being packed stays in memory: cutting it short at every
+		// sync would leave a frame or two per group at low sample rates
+		if (ok && r->out && timerNow() - r->lastSync >= REC_SYNC_PERIOD) {
+			ok = syncSegment(r);
+		}
+
+		TRACE_END(span);
+		AcquireSRWLockExclusive(&r->lock);
+		r->tail = head;
+	}
+
+	r->failed = !ok;
+	ReleaseSRWLockExclusive(&r->lock);
+
+	ok = closeSegment(r) && ok;
+
+	return ok ? 0 : ARE_FILE;
+}
+
+/**
+ * Create a recorder and start its writer thread. The first segment is created
+ * with the first frame.
+ * @param  sm     Provides the struct sizes.
+ * @param  period Microseconds between samples.
+ * @return        NULL if out of memory or the thread could not be started.
+ */
+Recorder* createRecorder(const SharedMem* sm, uint32_t period) {
+	Recorder* r = calloc(1, sizeof(*r));
+
+	if (!r) {
+		return NULL;
+	}
+
+	InitializeSRWLock(&r->lock);
+	InitializeConditionVariable(&r->ready);
+	r->slots = malloc(sizeof(*r->slots) * REC_QUEUE_SLOTS);
+
+	#ifdef RECORD_COMPRESS
+	r->packPhysics = malloc(sizeof(Physics) * REC_PACK_FRAMES);
+	r->packHud = malloc(sizeof(HUD) * REC_PACK_FRAMES);
+	r->packOut = malloc(recPackBound(sizeof(Physics) > sizeof(HUD) ? sizeof(Physics) : sizeof(HUD)));
+
+	if (!r->packPhysics || !r->packHud || !r->packOut) {
+		freeRecorder(r);
+
+		return NULL;
+	}
+	#endif
+
+	if (!r->slots) {
+		freeRecorder(r);
+
+		return NULL;
+	}
+
+	SYSTEMTIME t;
+
+	GetLocalTime(&t);
+	snprintf(r->prefix, sizeof(r->prefix), "%s-%04u%02u%02u-%02u%02u%02u", REC_PREFIX,
+		t.wYear, t.wMonth, t.wDay, t.wHour, t.wMinute, t.wSecond);
+
+	r->start = timerNow();
+	r->wallStart = recWallClock();
+	recHeaderInit(&r->header, sm, period, r->wallStart);
+	r->thread = CreateThread(NULL, 0, &writeProc, r, 0, NULL);
+
+	if (!r->thread) {
+		freeRecorder(r);
+
+		return NULL;
+	}
+
+	return r;
+}
+
+/**
+ * Queue a frame for the writer thread. Physics and HUD are recorded every time;
+ * properties only when props is set since they rarely change. Never blocks on
+ * the disk: if the queue is full the frame is dropped and counted.
+ * @param  r
+ * @param  frame A consistent copy of the shared memory.
+ * @param  props
+ * @return       False if the writer thread has failed.
+ */
+bool recorderFrame(Recorder* r, const struct memMaps* frame, bool props) {
+	AcquireSRWLockShared(&r->lock);
+	bool failed = r->failed;
+	bool full = r->head - r->tail == REC_QUEUE_SLOTS;
+	ReleaseSRWLockShared(&r->lock);
+
+	if (failed) {
+		return false;
+	}
+
+	r->propsPending = r->propsPending || props;
+
+	if (full) {
+		AcquireSRWLockExclusive(&r->lock);
+		r->dropped++;
+		ReleaseSRWLockExclusive(&r->lock);
+
+		return true;
+	}
+
+	// the slot at head is not visible to the writer until head is advanced
+	struct recSlot* f = &r->slots[r->head % REC_QUEUE_SLOTS];
+
+	f->time = timerNow() - r->start;
+	f->hasProps = r->propsPending;
+	memcpy(&f->physics, frame->physics, sizeof(f->physics));
+	memcpy(&f->hud, frame->hud, sizeof(f->hud));
+
+	if (f->hasProps) {
+		memcpy(&f->props, frame->props, sizeof(f->props));
+	}
+
+	r->propsPending = false;
+
+	AcquireSRWLockExclusive(&r->lock);
+	r->head++;
+	WakeConditionVariable(&r->ready);
+	ReleaseSRWLockExclusive(&r->lock);
+
+	return true;
+}
+
+/**
+ * Frames waiting to be written.
+ * @param  r
+ * @param  dropped Set to the number of frames dropped so far.
+ * @return
+ */
+uint64_t recorderDepth(Recorder* r, uint64_t* dropped) {
+	AcquireSRWLockShared(&r->lock);
+	uint64_t depth = r->head - r->tail;
+	*dropped = r->dropped;
+	ReleaseSRWLockShared(&r->lock);
+
+	return depth;
+}
+
+/**
+ * Print the queue depth and dropped frames.
+ */
+void recorderPrint(Recorder* r) {
+	uint64_t dropped;
+	uint64_t depth = recorderDepth(r, &dropped);
+
+	printf("Recorder: %llu queued, %llu dropped\n",
+		(unsigned long long) depth, (unsigned long long) dropped);
+
+	fflush(stdout);
+}
+
+/**
+ * Write the remaining frames, close the current segment, and free the recorder.
+ * Does nothing if r is NULL.
+ */
+void freeRecorder(Recorder* r) {
+	if (!r) {
+		return;
+	}
+
+	if (r->thread) {
+		AcquireSRWLockExclusive(&r->lock);
+		r->stop = true;
+		WakeConditionVariable(&r->ready);
+		ReleaseSRWLockExclusive(&r->lock);
+
+		WaitForSingleObject(r->thread, INFINITE);
+		CloseHandle(r->thread);
+	}
+
+	recIndexFree(&r->index);
+
+	#ifdef RECORD_COMPRESS
+	free(r->packPhysics);
+	free(r->packHud);
+	free(r->packOut);
+	#endif
+
+	free(r->slots);
+	free(r);
+}
@@ -0,0 +1,106 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include "recording.h"
+#include "timer.h"
+#include "tracing.h"
+
+// segments are named <prefix>-<yyyymmdd>-<hhmmss>-<segment>.rec
+#define REC_PREFIX "data"
+#define REC_PATH_SIZE 64
+
+// frames that can be waiting for the writer thread. Frames arriving while
+// the queue is full are dropped and counted
+#define REC_QUEUE_SLOTS 64
+
+// longest the writer thread sleeps without frames (milliseconds) so that
+// syncs still happen while the player is out of the car
+#define REC_WAKE_MS 250
+
+// a new segment is started once the current one reaches either limit
+#define REC_SEGMENT_BYTES ((uint64_t) RECORD_SEGMENT_MB * 1024 * 1024)
+#define REC_SEGMENT_TIME ((uint64_t) RECORD_SEGMENT_SECONDS * 1000000)
+
+// written data is flushed to disk at least this often (microseconds)
+#define REC_SYNC_PERIOD ((uint64_t) RECORD_FSYNC_MS * 1000)
+
+/**
+ * A queued frame.
+ */
+struct recSlot {
+	// microseconds since the recorder was created
+	uint64_t time;
+	bool hasProps;
+	Physics physics;
+	HUD hud;
+	Properties props;
+};
+
+/**
+ * Writes frames to a series of recording segments on a dedicated thread.
+ * The sampling thread only copies frames into the queue.
+ */
+typedef struct recorder {
+	SRWLOCK lock;
+	CONDITION_VARIABLE ready;
+	HANDLE thread;
+
+	// queued frames are slots[tail % REC_QUEUE_SLOTS] to slots[head % REC_QUEUE_SLOTS].
+	// head is only advanced by the sampling thread and tail by the writer thread
+	struct recSlot* slots;
+	uint64_t head;
+	uint64_t tail;
+
+	// frames dropped because the queue was full
+	uint64_t dropped;
+
+	// set by the sampling thread to stop the writer
+	bool stop;
+
+	// set by the writer thread if a write failed
+	bool failed;
+
+	// properties must go with the next queued frame (sampling thread only)
+	bool propsPending;
+
+	// timerNow() and recWallClock() when the recorder was created
+	uint64_t start;
+	uint64_t wallStart;
+
+	// everything below is only touched by the writer thread
+	RecHeader header;
+	char prefix[REC_PATH_SIZE];
+	FILE* out;
+	unsigned int segment;
+	uint64_t segmentBytes;
+	uint64_t segmentStart;
+	uint64_t lastSync;
+
+	// repeated at the start of every segment so each can be read on its own
+	Properties props;
+	bool haveProps;
+
+	// of the latest properties block in the current segment, zero if none
+	uint64_t propsOffset;
+
+	#ifdef RECORD_COMPRESS
+	// frames waiting to be written as a pair of packed blocks and the
+	// buffer they are packed into
+	Physics* packPhysics;
+	HUD* packHud;
+	uint64_t packTimes[REC_PACK_FRAMES];
+	uint32_t packCount;
+	uint8_t* packOut;
+	#endif
+
+	// lap, sector, and pit index of the current segment, written when it is closed
+	RecIndexer index;
+} Recorder;
+
+Recorder* createRecorder(const SharedMem*, uint32_t);
+bool recorderFrame(Recorder*, const struct memMaps*, bool);
+uint64_t recorderDepth(Recorder*, uint64_t*);
+void recorderPrint(Recorder*);
+void freeRecorder(Recorder*);
+
+#endif
@@ -0,0 +1,670 @@
+#include "recording.h"
+
+_Static_assert(sizeof(RecHeader) == 32, "RecHeader must not contain padding");
+_Static_assert(sizeof(RecBlock) % REC_ALIGN == 0, "RecBlock must keep payloads aligned");
+_Static_assert(sizeof(RecIndexEntry) == 48, "RecIndexEntry must not contain padding");
+_Static_assert(sizeof(RecPacked) == 8, "RecPacked must keep the bit stream aligned");
+_Static_assert(sizeof(Physics) % 4 == 0 && sizeof(HUD) % 4 == 0, "packed structs must be whole words");
+
+// CRC-32 (IEEE 802.3, reflected) lookup table
+static uint32_t crcTable[256];
+
+// enum packLane of each word of the packed structs
+static uint8_t physicsLanes[sizeof(Physics) / 4];
+static uint8_t hudLanes[sizeof(HUD) / 4];
+
+// words that count up at a steady rate; everything else is XORed
+#define DOD_LANE(lanes, type, member) lanes[offsetof(type, member) / 4] = PACK_DOD
+
+/**
+ * Build the CRC lookup table. Call once before any other rec* function.
+ */
+void recInit() {
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t c = i;
+
+		for (int k = 0; k < 8; k++) {
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		}
+
+		crcTable[i] = c;
+	}
+
+	memset(physicsLanes, PACK_XOR, sizeof(physicsLanes));
+	memset(hudLanes, PACK_XOR, sizeof(hudLanes));
+
+	DOD_LANE(physicsLanes, Physics, packetId);
+	DOD_LANE(hudLanes, HUD, packetId);
+	DOD_LANE(hudLanes, HUD, currLapTime);
+	DOD_LANE(hudLanes, HUD, sessionTimeLeft);
+	DOD_LANE(hudLanes, HUD, distanceTraveled);
+	DOD_LANE(hudLanes, HUD, totalTimeLeft);
+	DOD_LANE(hudLanes, HUD, stintTimeLeft);
+	DOD_LANE(hudLanes, HUD, clock);
+}
+
+/**
+ * Continue a CRC-32 over size bytes of data. Start with a crc of zero.
+ * @param  crc  Result of the previous call or zero.
+ * @param  data
+ * @param  size
+ * @return
+ */
+uint32_t recCrc(uint32_t crc, const void* data, size_t size) {
+	const uint8_t* p = data;
+
+	crc = ~crc;
+
+	for (size_t i = 0; i < size; i++) {
+		crc = crcTable[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
+
+/**
+ * Current wall clock time as a FILETIME (100ns intervals since 1601).
+ */
+uint64_t recWallClock() {
+	FILETIME ft;
+
+	GetSystemTimeAsFileTime(&ft);
+
+	return ((uint64_t) ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+/**
+ * Fill in a header for a recording.
+ * @param h
+ * @param sm     Provides the struct sizes.
+ * @param period Microseconds between samples.
+ * @param start  Wall clock time block times are relative to. See recWallClock().
+ */
+void recHeaderInit(RecHeader* h, const SharedMem* sm, uint32_t period, uint64_t start) {
+	h->magic = REC_MAGIC;
+	h->format = REC_FORMAT_VERSION;
+	h->layout = REC_LAYOUT_VERSION;
+	h->szPhysics = (uint32_t) sm->szPhysics;
+	h->szHud = (uint32_t) sm->szHud;
+	h->szProps = (uint32_t) sm->szProps;
+	h->period = period;
+	h->start = start;
+}
+
+/**
+ * CRC of a block: its size, type, and time followed by its payload.
+ * @param  b
+ * @param  payload b->size bytes.
+ * @return
+ */
+uint32_t recBlockCrc(const RecBlock* b, const void* payload) {
+	return recCrc(recCrc(0, b, offsetof(RecBlock, crc)), payload, b->size);
+}
+
+/**
+ * Append a block with its header, payload, and padding.
+ * @param  out
+ * @param  type
+ * @param  time Microseconds since the header's start time.
+ * @param  data
+ * @param  size Bytes of data.
+ * @return      Bytes written (REC_BLOCK_SPAN(size)) or zero if the write failed.
+ */
+size_t recWriteBlock(FILE* out, enum recBlockType type, uint64_t time, const void* data, size_t size) {
+	static const uint8_t zeros[REC_ALIGN] = {0};
+	RecBlock b = {(uint32_t) size, (uint16_t) type, 0, time, 0, 0};
+	size_t pad = REC_BLOCK_SPAN(size) - sizeof(b) - size;
+
+	b.crc = recBlockCrc(&b, data);
+
+	if (fwrite(&b, sizeof(b), 1, out) != 1 || (size && fwrite(data, size, 1, out) != 1) ||
+		(pad && fwrite(zeros, pad, 1, out) != 1)) {
+		return 0;
+	}
+
+	return REC_BLOCK_SPAN(size);
+}
+
+/**
+ * Lanes the words of a packed struct are encoded with.
+ * @param  type REC_BLOCK_PHYSICS or REC_BLOCK_HUD.
+ * @return      NULL for any other type.
+ */
+const uint8_t* recLanes(enum recBlockType type) {
+	switch (type) {
+	case REC_BLOCK_PHYSICS:
+		return physicsLanes;
+	case REC_BLOCK_HUD:
+		return hudLanes;
+	default:
+		return NULL;
+	}
+}
+
+/**
+ * Size of the buffer recWritePacked() needs for up to REC_PACK_FRAMES structs of size bytes.
+ */
+size_t recPackBound(size_t size) {
+	return sizeof(RecPacked) + packBound(size, REC_PACK_FRAMES);
+}
+
+/**
+ * Append a packed block holding count physics or HUD structs.
+ * @param  out
+ * @param  type    REC_BLOCK_PHYSICS or REC_BLOCK_HUD.
+ * @param  frames  count contiguous structs.
+ * @param  size    Bytes of a struct.
+ * @param  times   Time of each frame. The block's time is the first.
+ * @param  count   At most REC_PACK_FRAMES.
+ * @param  scratch recPackBound(size) bytes.
+ * @return         Bytes written or zero if the write failed.
+ */
+size_t recWritePacked(FILE* out, enum recBlockType type, const void* frames, size_t size,
+	const uint64_t* times, uint32_t count, uint8_t* scratch) {
+	RecPacked h = {(uint16_t) type, (uint16_t) count, 0};
+
+	h.bytes = (uint32_t) packFrames(scratch + sizeof(h), recLanes(type), frames, size, times, count);
+	memcpy(scratch, &h, sizeof(h));
+
+	return recWriteBlock(out, REC_BLOCK_PACKED, times[0], scratch, sizeof(h) + h.bytes);
+}
+
+/**
+ * Add a frame to the index if it is the first one or its session, lap, sector,
+ * or pit state differs from the last entry.
+ * @param  ix
+ * @param  hud
+ * @param  at  Offset, time, frame, and properties offset of the frame.
+ * @return     False if out of memory.
+ */
+bool recIndexFrame(RecIndexer* ix, const HUD* hud, const RecIndexEntry* at) {
+	RecIndexEntry e = {
+		at->offset, at->time, at->props, 0, hud->sessionIndex, hud->completedLaps, hud->currSectorIndex,
+		(hud->isInPitLane ? REC_INDEX_PIT_LANE : 0u) | (hud->isBoxed ? REC_INDEX_BOXED : 0u), at->frame
+	};
+
+	if (ix->count > 0) {
+		const RecIndexEntry* last = &ix->entries[ix->count - 1];
+
+		// a restarted session keeps its index but its laps go back to zero
+		bool newSession = e.sessionIndex != last->sessionIndex || e.lap < last->lap;
+
+		if (!newSession && e.lap == last->lap && e.sector == last->sector && e.flags == last->flags) {
+			return true;
+		}
+
+		e.session = last->session + (newSession ? 1 : 0);
+	}
+
+	if (ix->count == ix->cap) {
+		size_t cap = ix->cap ? ix->cap * 2 : 256;
+		RecIndexEntry* temp = realloc(ix->entries, sizeof(*temp) * cap);
+
+		if (!temp) {
+			return false;
+		}
+
+		ix->entries = temp;
+		ix->cap = cap;
+	}
+
+	ix->entries[ix->count++] = e;
+
+	return true;
+}
+
+/**
+ * Append the index block and the footer pointing at it. Nothing may be written
+ * after them.
+ * @param  out
+ * @param  ix
+ * @param  offset Where the index block will start (the current file size).
+ * @return        False if a write failed.
+ */
+bool recWriteIndex(FILE* out, const RecIndexer* ix, uint64_t offset) {
+	uint64_t time = ix->count ? ix->entries[ix->count - 1].time : 0;
+
+	return recWriteBlock(out, REC_BLOCK_INDEX, time, ix->entries, sizeof(*ix->entries) * ix->count) &&
+		recWriteBlock(out, REC_BLOCK_FOOTER, time, &offset, sizeof(offset));
+}
+
+/**
+ * Empty the index, keeping its memory for the next segment.
+ */
+void recIndexReset(RecIndexer* ix) {
+	ix->count = 0;
+}
+
+/**
+ * Free the entries of an index.
+ */
+void recIndexFree(RecIndexer* ix) {
+	free(ix->entries);
+	ix->entries = NULL;
+	ix->count = 0;
+	ix->cap = 0;
+}
+
+/**
+ * Find the trailing index through the footer. Leaves the recording unindexed
+ * if there is no footer or either block is damaged.
+ */
+static void findIndex(RecReader* r) {
+	size_t footer = REC_BLOCK_SPAN(sizeof(uint64_t));
+
+	if (r->size < sizeof(RecHeader) + sizeof(RecBlock) + footer) {
+		return;
+	}
+
+	const RecBlock* f = (const RecBlock*) (r->base + r->size - footer);
+	uint64_t at;
+
+	if (f->type != REC_BLOCK_FOOTER || f->size != sizeof(at) || recBlockCrc(f, f + 1) != f->crc) {
+		return;
+	}
+
+	memcpy(&at, f + 1, sizeof(at));
+
+	if (at < sizeof(RecHeader) || at % REC_ALIGN != 0 || at > r->size - footer - sizeof(RecBlock)) {
+		return;
+	}
+
+	const RecBlock* b = (const RecBlock*) (r->base + at);
+
+	if (b->type != REC_BLOCK_INDEX || b->size > r->size - footer - at - sizeof(RecBlock) ||
+		b->size % sizeof(RecIndexEntry) != 0 || recBlockCrc(b, b + 1) != b->crc) {
+		return;
+	}
+
+	r->index = (const RecIndexEntry*) (b + 1);
+	r->indexCount = b->size / sizeof(RecIndexEntry);
+	r->end = (size_t) at;
+}
+
+/**
+ * Map a recording into memory and check its header.
+ * @param  path
+ * @param  out  Set to the reader on success.
+ * @return      ARE_FILE if the file cannot be opened or mapped,
+ *              ARE_RECORDING if it is not a recording made with this version,
+ *              ARE_OUT_OF_MEM, or zero on success.
+ */
+int recOpen(const char* path, RecReader** out) {
+	RecReader* r = calloc(1, sizeof(*r));
+
+	if (!r) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	r->offset = sizeof(RecHeader);
+	r->complete = sizeof(RecHeader);
+	r->file = CreateFileA(
+		path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+	);
+
+	if (r->file == INVALID_HANDLE_VALUE) {
+		r->file = NULL;
+		recClose(r);
+
+		return ARE_FILE;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(r->file, &size) || (uint64_t) size.QuadPart < sizeof(RecHeader)) {
+		recClose(r);
+
+		return ARE_RECORDING;
+	}
+
+	r->size = (size_t) size.QuadPart;
+	r->end = r->size;
+	r->mapping = CreateFileMappingW(r->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	r->base = r->mapping ? MapViewOfFile(r->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	if (!r->base) {
+		recClose(r);
+
+		return ARE_FILE;
+	}
+
+	const RecHeader* h = recHeader(r);
+
+	if (h->magic != REC_MAGIC || h->format != REC_FORMAT_VERSION ||
+		h->layout != REC_LAYOUT_VERSION || h->szPhysics != sizeof(Physics) ||
+		h->szHud != sizeof(HUD) || h->szProps != sizeof(Properties)) {
+		recClose(r);
+
+		return ARE_RECORDING;
+	}
+
+	findIndex(r);
+	*out = r;
+
+	return 0;
+}
+
+/**
+ * Header of an open recording.
+ */
+const RecHeader* recHeader(const RecReader* r) {
+	return (const RecHeader*) r->base;
+}
+
+/**
+ * Get the next block. Blocks that fail their CRC or run past the end of the
+ * file end the iteration (and set r->corrupt) since the framing after them
+ * cannot be trusted.
+ * @param  r
+ * @param  payload Set to the block's payload, which is aligned to REC_ALIGN.
+ * @return         The block or NULL at the end of the recording.
+ */
+const RecBlock* recNext(RecReader* r, const void** payload) {
+	if (r->offset == r->end) {
+		return NULL;
+	}
+
+	if (r->end - r->offset < sizeof(RecBlock)) {
+		r->corrupt = true;
+
+		return NULL;
+	}
+
+	const RecBlock* b = (const RecBlock*) (r->base + r->offset);
+
+	if (b->size > r->end - r->offset - sizeof(RecBlock)) {
+		r->corrupt = true;
+
+		return NULL;
+	}
+
+	const void* data = b + 1;
+
+	if (recBlockCrc(b, data) != b->crc) {
+		r->corrupt = true;
+
+		return NULL;
+	}
+
+	// the final block of a file may be missing its padding
+	size_t span = REC_BLOCK_SPAN(b->size);
+
+	r->offset = (span > r->end - r->offset) ? r->end : r->offset + span;
+	*payload = data;
+
+	return b;
+}
+
+/**
+ * Decode a packed block. The physics block of a group is kept until the HUD
+ * block with the same frames completes it.
+ * @return False if the block is malformed.
+ */
+static bool unpack(RecReader* r, const RecBlock* b, const void* payload) {
+	RecPacked h;
+	uint64_t times[REC_PACK_FRAMES];
+
+	if (b->size < sizeof(h)) {
+		return false;
+	}
+
+	memcpy(&h, payload, sizeof(h));
+
+	if (h.frames == 0 || h.frames > REC_PACK_FRAMES || h.bytes > b->size - sizeof(h)) {
+		return false;
+	}
+
+	const uint8_t* in = (const uint8_t*) payload + sizeof(h);
+
+	if (h.type == REC_BLOCK_PHYSICS) {
+		r->packPending = unpackFrames(in, h.bytes, physicsLanes, r->packPhysics,
+			sizeof(Physics), r->packTimes, h.frames) ? h.frames : 0;
+
+		return r->packPending != 0;
+	}
+
+	if (h.type != REC_BLOCK_HUD || h.frames != r->packPending ||
+		!unpackFrames(in, h.bytes, hudLanes, r->packHud, sizeof(HUD), times, h.frames)) {
+		return false;
+	}
+
+	r->packCount = h.frames;
+	r->packNext = r->skip < h.frames ? r->skip : h.frames;
+	r->packPending = 0;
+	r->skip = 0;
+
+	return true;
+}
+
+/**
+ * Forget a partly read frame and packed group.
+ */
+static void resetFrame(RecReader* r) {
+	r->physics = NULL;
+	r->inFrame = false;
+	r->packPending = 0;
+	r->packCount = 0;
+	r->packNext = 0;
+	r->skip = 0;
+}
+
+/**
+ * Fill in the properties and index position of a frame.
+ * @return true
+ */
+static bool found(RecReader* r, RecFrame* f, uint32_t frame) {
+	f->at.offset = r->frameStart;
+	f->at.time = f->time;
+	f->at.props = r->propsOffset;
+	f->at.frame = frame;
+	f->props = r->props;
+	f->propsChanged = r->propsChanged && r->props;
+	r->propsChanged = false;
+	r->inFrame = false;
+	r->complete = r->offset;
+
+	return true;
+}
+
+/**
+ * Get the next frame, decoding packed blocks as required. Properties blocks
+ * are folded into the frames that follow them.
+ * @param  r
+ * @param  f
+ * @return   False at the end of the recording, or if a block is damaged
+ *           (r->corrupt is set) or out of memory.
+ */
+bool recNextFrame(RecReader* r, RecFrame* f) {
+	const RecBlock* b;
+	const void* payload;
+
+	while (r->packNext == r->packCount) {
+		size_t at = r->offset;
+
+		if (!(b = recNext(r, &payload))) {
+			return false;
+		}
+
+		if (!r->inFrame) {
+			r->frameStart = at;
+			r->inFrame = true;
+		}
+
+		switch (b->type) {
+		case REC_BLOCK_PROPS:
+			if (b->size == sizeof(Properties)) {
+				r->props = payload;
+				r->propsOffset = at;
+				r->propsChanged = true;
+			}
+
+			break;
+		case REC_BLOCK_PHYSICS:
+			r->physics = b->size == sizeof(Physics) ? payload : NULL;
+
+			break;
+		case REC_BLOCK_HUD:
+			if (r->physics && b->size == sizeof(HUD)) {
+				f->time = b->time;
+				f->physics = r->physics;
+				f->hud = payload;
+				r->physics = NULL;
+
+				return found(r, f, 0);
+			}
+
+			break;
+		case REC_BLOCK_PACKED:
+			if (!r->packPhysics) {
+				r->packPhysics = malloc(sizeof(Physics) * REC_PACK_FRAMES);
+				r->packHud = malloc(sizeof(HUD) * REC_PACK_FRAMES);
+
+				if (!r->packPhysics || !r->packHud) {
+					return false;
+				}
+			}
+
+			if (!unpack(r, b, payload)) {
+				r->corrupt = true;
+
+				return false;
+			}
+
+			break;
+		}
+	}
+
+	uint32_t i = r->packNext++;
+
+	f->time = r->packTimes[i];
+	f->physics = &r->packPhysics[i];
+	f->hud = &r->packHud[i];
+
+	return found(r, f, i);
+}
+
+/**
+ * Go back to the first block.
+ */
+void recRewind(RecReader* r) {
+	r->offset = sizeof(RecHeader);
+	r->corrupt = false;
+	r->props = NULL;
+	r->propsOffset = 0;
+	r->propsChanged = false;
+	resetFrame(r);
+}
+
+/**
+ * Continue reading from an index entry, restoring the properties in effect there.
+ */
+static void seek(RecReader* r, const RecIndexEntry* e) {
+	recRewind(r);
+	r->offset = (size_t) e->offset;
+	r->skip = e->frame;
+
+	if (e->props && e->props % REC_ALIGN == 0 && e->props <= r->end - REC_BLOCK_SPAN(sizeof(Properties))) {
+		const RecBlock* b = (const RecBlock*) (r->base + e->props);
+
+		if (b->type == REC_BLOCK_PROPS && b->size == sizeof(Properties)) {
+			r->props = (const Properties*) (b + 1);
+			r->propsOffset = e->props;
+			r->propsChanged = true;
+		}
+	}
+}
+
+/**
+ * Continue reading from the first frame at or after lap and sector of the given
+ * session in O(log n).
+ * @param  r
+ * @param  session Sessions started since the start of the recording.
+ * @param  lap     Completed laps.
+ * @param  sector
+ * @return         The matching index entry or NULL if the recording is not
+ *                 indexed or has no such frame. The position is unchanged if NULL.
+ */
+const RecIndexEntry* recSeekLap(RecReader* r, uint32_t session, int lap, int sector) {
+	size_t lo = 0;
+	size_t hi = r->indexCount;
+
+	// first entry not ordered before (session, lap, sector)
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const RecIndexEntry* e = &r->index[mid];
+		bool before = e->session != session ? e->session < session :
+			e->lap != lap ? e->lap < lap : e->sector < sector;
+
+		if (before) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == r->indexCount) {
+		return NULL;
+	}
+
+	seek(r, &r->index[lo]);
+
+	return &r->index[lo];
+}
+
+/**
+ * Continue reading from the last indexed frame at or before time in O(log n).
+ * @param  r
+ * @param  time Microseconds since the header's start time.
+ * @return      The matching index entry or NULL if the recording is not indexed.
+ *              Times before the first entry seek to the first entry.
+ */
+const RecIndexEntry* recSeekTime(RecReader* r, uint64_t time) {
+	size_t lo = 0;
+	size_t hi = r->indexCount;
+
+	if (hi == 0) {
+		return NULL;
+	}
+
+	// first entry after time
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (r->index[mid].time <= time) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	const RecIndexEntry* e = &r->index[lo ? lo - 1 : 0];
+
+	seek(r, e);
+
+	return e;
+}
+
+/**
+ * Unmap and close a recording. Does nothing if r is NULL.
+ */
+void recClose(RecReader* r) {
+	if (!r) {
+		return;
+	}
+
+	if (r->base) {
+		UnmapViewOfFile(r->base);
+	}
+
+	if (r->mapping) {
+		CloseHandle(r->mapping);
+	}
+
+	if (r->file) {
+		CloseHandle(r->file);
+	}
+
+	free(r->packPhysics);
+	free(r->packHud);
+	free(r);
+}
@@ -0,0 +1,220 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "shared_mem.h"
+#include "pack.h"
+
+// "AREC" read as a little endian integer
+#define REC_MAGIC 0x43455241
+
+// version of the header and block framing; 2 added packed blocks and 3
+// narrowed escaped delta-of-deltas in them to 33 bits
+#define REC_FORMAT_VERSION 3
+
+// bump whenever Physics, HUD, or Properties change so that old recordings
+// are not interpreted with the new layout
+#define REC_LAYOUT_VERSION 1
+
+// blocks (header and payload) start on multiples of this so that payloads
+// can be read in place from a mapped file
+#define REC_ALIGN 8
+
+// what the payload of a block holds
+enum recBlockType {
+	REC_BLOCK_PHYSICS = 1,
+	REC_BLOCK_HUD,
+	REC_BLOCK_PROPS,
+
+	// array of RecIndexEntry
+	REC_BLOCK_INDEX,
+
+	// last block of an indexed recording; u64 offset of the index block
+	REC_BLOCK_FOOTER,
+
+	// RecPacked followed by up to REC_PACK_FRAMES physics or HUD structs
+	// compressed with packFrames()
+	REC_BLOCK_PACKED
+};
+
+// frames in a full packed block. Each packed block decodes on its own so a
+// seek never needs more than one physics and one HUD block.
+#define REC_PACK_FRAMES 64
+
+// RecIndexEntry flags
+#define REC_INDEX_PIT_LANE 0x1
+#define REC_INDEX_BOXED 0x2
+
+/**
+ * Start of a recording.
+ */
+typedef struct recHeader {
+	uint32_t magic;
+	uint16_t format;
+	uint16_t layout;
+
+	// sizes of the structs the recording was made with
+	uint32_t szPhysics;
+	uint32_t szHud;
+	uint32_t szProps;
+
+	// microseconds between samples
+	uint32_t period;
+
+	// wall clock time block times are relative to (FILETIME: 100ns since 1601)
+	uint64_t start;
+} RecHeader;
+
+/**
+ * Precedes each payload. The CRC covers the first 16 bytes of the block
+ * followed by the payload so a torn or truncated block is detected.
+ */
+typedef struct recBlock {
+	// payload bytes following this header (excluding alignment padding)
+	uint32_t size;
+	uint16_t type;
+	uint16_t reserved;
+
+	// microseconds since the header's start time
+	uint64_t time;
+
+	uint32_t crc;
+	uint32_t reserved2;
+} RecBlock;
+
+/**
+ * Start of a packed block's payload. The physics block of a group of frames
+ * is followed by the HUD block holding the same frames.
+ */
+typedef struct recPacked {
+	// REC_BLOCK_PHYSICS or REC_BLOCK_HUD
+	uint16_t type;
+	uint16_t frames;
+
+	// bytes of the bit stream that follows
+	uint32_t bytes;
+} RecPacked;
+
+/**
+ * Marks the first frame of a segment and every frame where the session, lap,
+ * sector, or pit state changed. Entries are in recording order.
+ */
+typedef struct recIndexEntry {
+	// of the first block of the frame, or of the packed physics block
+	// holding it
+	uint64_t offset;
+	uint64_t time;
+
+	// of the latest properties block before the frame, zero if there is none
+	uint64_t props;
+
+	// sessions started since the start of the recording; unlike sessionIndex
+	// this never goes backwards so (session, lap, sector) is ordered
+	uint32_t session;
+	int32_t sessionIndex;
+	int32_t lap;
+	int32_t sector;
+	uint32_t flags;
+
+	// of the frame within its packed block, zero for unpacked frames
+	uint32_t frame;
+} RecIndexEntry;
+
+/**
+ * Builds an index as frames are written or scanned.
+ */
+typedef struct recIndexer {
+	RecIndexEntry* entries;
+	size_t count;
+	size_t cap;
+} RecIndexer;
+
+/**
+ * A frame returned by recNextFrame(). Unpacked structs point into the mapped
+ * file, packed ones into the reader and are valid until the next call.
+ */
+typedef struct recFrame {
+	// microseconds since the header's start time
+	uint64_t time;
+	const Physics* physics;
+	const HUD* hud;
+
+	// latest properties or NULL if none have been seen yet
+	const Properties* props;
+
+	// true if props changed since the previous frame
+	bool propsChanged;
+
+	// where the frame is for recIndexFrame()
+	RecIndexEntry at;
+} RecFrame;
+
+/**
+ * Read only view of a mapped recording. Blocks are returned in place.
+ */
+typedef struct recReader {
+	HANDLE file;
+	HANDLE mapping;
+	const uint8_t* base;
+	size_t size;
+
+	// offset of the next block and where the frames end (the index block
+	// if the recording is indexed, otherwise the end of the file)
+	size_t offset;
+	size_t end;
+
+	// the trailing index or NULL if there is none
+	const RecIndexEntry* index;
+	size_t indexCount;
+
+	// true if iteration stopped on a bad or truncated block rather than
+	// at the end of the file
+	bool corrupt;
+
+	// just after the last complete frame read by recNextFrame()
+	size_t complete;
+
+	// state of recNextFrame()
+	const Properties* props;
+	uint64_t propsOffset;
+	bool propsChanged;
+	const Physics* physics;
+	size_t frameStart;
+	bool inFrame;
+
+	// frames of the current packed group; count is zero until its HUD block
+	// has been read. skip is the number of frames to pass over after a seek.
+	Physics* packPhysics;
+	HUD* packHud;
+	uint64_t packTimes[REC_PACK_FRAMES];
+	uint32_t packPending;
+	uint32_t packCount;
+	uint32_t packNext;
+	uint32_t skip;
+} RecReader;
+
+// bytes a block with a payload of size occupies
+#define REC_BLOCK_SPAN(size) (sizeof(RecBlock) + (((size) + REC_ALIGN - 1) & ~(size_t) (REC_ALIGN - 1)))
+
+void recInit();
+uint32_t recCrc(uint32_t, const void*, size_t);
+uint64_t recWallClock();
+void recHeaderInit(RecHeader*, const SharedMem*, uint32_t, uint64_t);
+uint32_t recBlockCrc(const RecBlock*, const void*);
+size_t recWriteBlock(FILE*, enum recBlockType, uint64_t, const void*, size_t);
+const uint8_t* recLanes(enum recBlockType);
+size_t recPackBound(size_t);
+size_t recWritePacked(FILE*, enum recBlockType, const void*, size_t, const uint64_t*, uint32_t, uint8_t*);
+bool recIndexFrame(RecIndexer*, const HUD*, const RecIndexEntry*);
+bool recWriteIndex(FILE*, const RecIndexer*, uint64_t);
+void recIndexReset(RecIndexer*);
+void recIndexFree(RecIndexer*);
+int recOpen(const char*, RecReader**);
+const RecHeader* recHeader(const RecReader*);
+const RecBlock* recNext(RecReader*, const void**);
+bool recNextFrame(RecReader*, RecFrame*);
+void recRewind(RecReader*);
+const RecIndexEntry* recSeekLap(RecReader*, uint32_t, int, int);
+const RecIndexEntry* recSeekTime(RecReader*, uint64_t);
+void recClose(RecReader*);
+
+#endif
@@ -0,0 +1,224 @@
+#include "reference.h"
+
+// reply values of enum referenceKind
+static const char* kindNames[] = {"none", "best", "previous", "optimum", "custom"};
+
+/**
+ * Allocate reference laps on the heap. No reference is selected.
+ * @return NULL if out of memory.
+ */
+Reference* createReference() {
+	return calloc(1, sizeof(Reference));
+}
+
+/**
+ * Select the reference by its reply name: "none", "best", "previous",
+ * "optimum", or "custom".
+ * @param  r
+ * @param  name
+ * @return      False if the name is unknown.
+ */
+bool referenceSelect(Reference* r, const char* name) {
+	for (int i = 0; i < (int) (sizeof(kindNames) / sizeof(*kindNames)); i++) {
+		if (strcmp(name, kindNames[i]) == 0) {
+			r->kind = i;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Set and select the custom reference from an array of at least two lap
+ * times in milliseconds at evenly spaced positions from the line (0) to the
+ * line (the lap time). The array is resampled onto the grid.
+ * @param  r
+ * @param  times
+ * @return       False if the array is malformed or does not increase.
+ */
+bool referenceSetCustom(Reference* r, const cJSON* times) {
+	int count = cJSON_GetArraySize(times);
+
+	if (count < 2) {
+		return false;
+	}
+
+	// held until the grid is filled so a malformed array changes nothing
+	int* values = malloc(sizeof(int) * count);
+
+	if (!values) {
+		return false;
+	}
+
+	int i = 0;
+	const cJSON* item = NULL;
+
+	cJSON_ArrayForEach(item, times) {
+		if (!cJSON_IsNumber(item) || item->valuedouble < (i ? values[i - 1] : 0)) {
+			free(values);
+
+			return false;
+		}
+
+		values[i++] = item->valueint;
+	}
+
+	for (int p = 0; p <= REFERENCE_POINTS; p++) {
+		double x = (double) p * (count - 1) / REFERENCE_POINTS;
+		int j = (int) x;
+
+		j = j < count - 1 ? j : count - 2;
+		r->custom[p] = values[j] + (int) lround((x - j) * (values[j + 1] - values[j]));
+	}
+
+	free(values);
+	r->hasCustom = true;
+	r->kind = REF_CUSTOM;
+
+	return true;
+}
+
+/**
+ * The selected reference or NULL if it has not been driven (or sent) yet.
+ */
+static const int* selected(const Reference* r) {
+	switch (r->kind) {
+		case REF_BEST:
+			return r->hasBest ? r->best : NULL;
+		case REF_PREV:
+			return r->hasPrev ? r->prev : NULL;
+		case REF_OPTIMUM:
+			return r->hasBest ? r->optimum : NULL;
+		case REF_CUSTOM:
+			return r->hasCustom ? r->custom : NULL;
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * Start following a lap from a position part way around it.
+ */
+static void startLap(Reference* r, float pos, int time) {
+	lapCursorStart(&r->cursor, REFERENCE_POINTS, pos, false);
+	r->curr[0] = 0;
+	r->prevTime = time;
+}
+
+/**
+ * Record every grid point before the line between the last sample and pos.
+ */
+static void advance(Reference* r, float pos, int time) {
+	float f;
+
+	while (lapCursorCross(&r->cursor, pos, REFERENCE_POINTS - 1, &f)) {
+		r->curr[r->cursor.point] = r->prevTime + (int) lroundf(f * (float) (time - r->prevTime));
+	}
+}
+
+/**
+ * Add a sample and measure the delta to the selected reference. A new
+ * session clears the laps driven in the previous one.
+ * @param r
+ * @param h
+ */
+void referenceAdd(Reference* r, const HUD* h) {
+	float pos = h->normalizedCarPosition;
+	float next;
+
+	r->hasDelta = false;
+
+	if (r->started && (h->sessionIndex != r->sessionIndex || h->completedLaps < r->completedLaps)) {
+		r->hasPrev = false;
+		r->hasBest = false;
+		r->started = false;
+	}
+
+	if (!r->started) {
+		r->started = true;
+		r->sessionIndex = h->sessionIndex;
+		startLap(r, pos, h->currLapTime);
+	}
+
+	r->completedLaps = h->completedLaps;
+
+	// the line is crossed by referenceFinish() on the rollover
+	if (lapCursorStep(&r->cursor, pos, &next) != LAP_STEP_FORWARD || h->currLapTime < r->prevTime) {
+		return;
+	}
+
+	advance(r, pos, h->currLapTime);
+	r->cursor.pos = pos;
+	r->prevTime = h->currLapTime;
+
+	const int* ref = selected(r);
+
+	if (!ref) {
+		return;
+	}
+
+	// the cursor is the grid point at or just behind pos
+	int i = r->cursor.point;
+	float f = pos * REFERENCE_POINTS - (float) i;
+	int at = ref[i] + (int) lroundf(f * (float) (ref[i + 1] - ref[i]));
+
+	r->delta = h->currLapTime - at;
+	r->hasDelta = true;
+}
+
+/**
+ * Complete the lap at the line and start the next one. Called on the
+ * completedLaps rollover before the first sample of the next lap is added.
+ * @param r
+ * @param lapTime Lap time reported by the game (prevLapTime).
+ * @param valid   Whether or not the lap counts towards the best and optimum.
+ */
+void referenceFinish(Reference* r, int lapTime, bool valid) {
+	if (!r->started) {
+		return;
+	}
+
+	// points between the last sample and the line
+	if (lapTime > r->prevTime) {
+		advance(r, 1.0f, lapTime);
+	}
+
+	r->curr[REFERENCE_POINTS] = lapTime;
+
+	if (r->cursor.timed && r->cursor.point == REFERENCE_POINTS - 1) {
+		memcpy(r->prev, r->curr, sizeof(r->curr));
+		r->hasPrev = true;
+
+		if (valid) {
+			bool first = !r->hasBest;
+
+			if (first || lapTime < r->best[REFERENCE_POINTS]) {
+				memcpy(r->best, r->curr, sizeof(r->curr));
+			}
+
+			// the optimum is rebuilt from the fastest segments
+			for (int i = 0; i < REFERENCE_POINTS; i++) {
+				int segment = r->curr[i + 1] - r->curr[i];
+
+				if (first || segment < r->segments[i]) {
+					r->segments[i] = segment;
+				}
+
+				r->optimum[i + 1] = r->optimum[i] + r->segments[i];
+			}
+
+			r->hasBest = true;
+		}
+	}
+
+	startLap(r, 0.0f, 0);
+}
+
+/**
+ * Free reference laps. Does nothing if r is NULL.
+ */
+void freeReference(Reference* r) {
+	free(r);
+}
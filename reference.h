@@ -0,0 +1,75 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include "auxiliary.h"
+#include "hud.h"
+#include "lap_cursor.h"
+
+// intervals of the distance grid laps are resampled onto; point i is at
+// normalizedCarPosition i / REFERENCE_POINTS
+#define REFERENCE_POINTS 500
+
+// lap the live delta is measured against
+enum referenceKind {
+	REF_NONE = 0,
+
+	// fastest valid lap of the session
+	REF_BEST,
+
+	// last lap completed, valid or not
+	REF_PREV,
+
+	// fastest time between each pair of grid points over valid laps
+	REF_OPTIMUM,
+
+	// lap sent by the server, such as the team's best
+	REF_CUSTOM
+};
+
+/**
+ * Reference laps as the time into the lap at each point of a fixed distance
+ * grid. The lap being driven is resampled onto the grid as it is driven by
+ * a cursor that only moves forwards, which also locates the current
+ * position on the reference so the delta needs no search.
+ */
+typedef struct reference {
+	enum referenceKind kind;
+
+	// the lap being driven up to the cursor
+	int curr[REFERENCE_POINTS + 1];
+
+	int prev[REFERENCE_POINTS + 1];
+	int best[REFERENCE_POINTS + 1];
+	int optimum[REFERENCE_POINTS + 1];
+	int custom[REFERENCE_POINTS + 1];
+	bool hasPrev;
+	bool hasBest;
+	bool hasCustom;
+
+	// fastest time between point i and i + 1 this session
+	int segments[REFERENCE_POINTS];
+
+	// last grid point passed on the current lap
+	LapCursor cursor;
+
+	// currLapTime of the last sample that moved forward
+	int prevTime;
+
+	bool started;
+	int sessionIndex;
+	int completedLaps;
+
+	// milliseconds behind the reference (negative if ahead) at the last
+	// sample; only set if the sample was usable and a reference is held
+	int delta;
+	bool hasDelta;
+} Reference;
+
+Reference* createReference();
+bool referenceSelect(Reference*, const char*);
+bool referenceSetCustom(Reference*, const cJSON*);
+void referenceAdd(Reference*, const HUD*);
+void referenceFinish(Reference*, int, bool);
+void freeReference(Reference*);
+
+#endif
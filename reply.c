@@ -0,0 +1,47 @@
+#include "reply.h"
+
+/**
+ * Apply the settings the server sent back in a publish response body.
+ * Keys that are absent leave the corresponding setting as it is.
+ * Example:
+ * {"subscribe": ["speed", "laptimes", "tyres.pressure"], "compact": true, "reference": "best"}
+ * @param  reply     Parsed response body.
+ * @param  encoding  Fields to publish and how to key them.
+ * @param  reference Laps the live delta is measured against.
+ * @return          True if the encoding changed. The next frame should then be
+ *                  complete so that newly subscribed fields (or the compact
+ *                  dictionary) are sent.
+ */
+bool replyApply(const cJSON* reply, Encoding* encoding, Reference* reference) {
+	bool changed = false;
+	const cJSON* subscribe = cJSON_GetObjectItemCaseSensitive(reply, "subscribe");
+
+	if (subscribe) {
+		FieldMask parsed;
+
+		if (!fieldsParse(&parsed, subscribe)) {
+			printf("Invalid subscription in publish response\n");
+		} else if (!fieldsEqual(&parsed, &encoding->mask)) {
+			encoding->mask = parsed;
+			changed = true;
+		}
+	}
+
+	const cJSON* compact = cJSON_GetObjectItemCaseSensitive(reply, "compact");
+
+	if (cJSON_IsBool(compact) && cJSON_IsTrue(compact) != encoding->compact) {
+		encoding->compact = cJSON_IsTrue(compact);
+		changed = true;
+	}
+
+	// a reference lap by name or the times of one to follow
+	const cJSON* ref = cJSON_GetObjectItemCaseSensitive(reply, "reference");
+
+	if (cJSON_IsString(ref) && !referenceSelect(reference, ref->valuestring)) {
+		printf("Unknown reference lap in publish response\n");
+	} else if (cJSON_IsArray(ref) && !referenceSetCustom(reference, ref)) {
+		printf("Invalid reference lap in publish response\n");
+	}
+
+	return changed;
+}
@@ -0,0 +1,9 @@
+#ifndef REPLY_H
+#define REPLY_H
+
+#include "fields.h"
+#include "reference.h"
+
+bool replyApply(const cJSON*, Encoding*, Reference*);
+
+#endif
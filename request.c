@@ -44,19 +44,21 @@ static size_t cbBody(char* data, size_t s, size_t len, void* ptr) {
 	if (p->len + len >= p->cap) {
 		// the payload must be re-sized to accomodate the larger data
 		size_t cap = p->cap + len;
+		char* buf = areRealloc(p->data, cap, SITE_REQUEST);
 
-		p->data = realloc(p->data, cap);
-
-		if (!p->data) {
+		if (!buf) {
 			// re-allocation failed
 			return 0;
 		}
 
+		p->data = buf;
 		p->cap = cap;
 	}
 
-	strcat(p->data, data);
+	// data is not null terminated
+	memcpy(p->data + p->len - 1, data, len);
 	p->len += len;
+	p->data[p->len - 1] = '\0';
 
 	return len;
 }
@@ -80,7 +82,10 @@ Response* performRequest(CURL* curl) {
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &cbBody);
 
 	// send the request
+	TRACE_BEGIN(span, "performRequest");
 	r->curlCode = curl_easy_perform(curl);
+	TRACE_END(span);
+
 	populateResponse(curl, r);
 
 	return r;
@@ -2,6 +2,7 @@
 #define HTTP_H
 
 #include "response.h"
+#include "tracing.h"
 
 #define HEADER_DELIMS " :\r\n"
 
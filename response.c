@@ -4,16 +4,16 @@
  * Allocate memory for a payload object.
  */
 static struct payload* createPayload() {
-	struct payload* p = malloc(sizeof(*p));
+	struct payload* p = areMalloc(sizeof(*p), SITE_RESPONSE);
 
 	if (!p) {
 		return NULL;
 	}
 
-	p->data = malloc(BUF_SIZE);
+	p->data = areMalloc(BUF_SIZE, SITE_RESPONSE);
 
 	if (!p->data) {
-		free(p);
+		areFree(p);
 
 		return NULL;
 	}
@@ -31,24 +31,24 @@ static struct payload* createPayload() {
  * @param p
  */
 static void freePayload(struct payload* p) {
-	free(p->data);
-	free(p);
+	areFree(p->data);
+	areFree(p);
 }
 
 /**
  * Allocate memory for a response object.
  */
 Response* createResponse() {
-	Response* r = malloc(sizeof(*r));
+	Response* r = areMalloc(sizeof(*r), SITE_RESPONSE);
 
 	if (!r) {
 		return NULL;
 	}
 
-	r->headers = calloc(HEADER_COUNT, sizeof(Header*));
+	r->headers = areCalloc(HEADER_COUNT, sizeof(Header*), SITE_RESPONSE);
 
 	if (!r->headers) {
-		free(r);
+		areFree(r);
 
 		return NULL;
 	}
@@ -56,8 +56,8 @@ Response* createResponse() {
 	r->body = createPayload();
 
 	if (!r->body) {
-		free(r);
-		free(r->headers);
+		areFree(r->headers);
+		areFree(r);
 
 		return NULL;
 	}
@@ -76,25 +76,25 @@ Response* createResponse() {
  * @param  v Header value.
  */
 static Header* createHeader(const char* k, const char* v) {
-	Header* h = malloc(sizeof(*h));
+	Header* h = areMalloc(sizeof(*h), SITE_RESPONSE);
 
 	if (!h) {
 		return NULL;
 	}
 
-	h->key = strdup(k);
+	h->key = areStrdup(k, SITE_RESPONSE);
 
 	if (!h->key) {
-		free(h);
+		areFree(h);
 
 		return NULL;
 	}
 
-	h->value = strdup(v);
+	h->value = areStrdup(v, SITE_RESPONSE);
 
 	if (!h->value) {
-		free(h->key);
-		free(h);
+		areFree(h->key);
+		areFree(h);
 
 		return NULL;
 	}
@@ -117,17 +117,20 @@ Header* addResponseHeader(Response* r, const char* k, const char* v) {
 	}
 
 	if (r->headerCount == r->headerCap) {
-		// reached capacity - re-allocate
-		// current size of the array + size of HEADER_COUNT header objects
-		r->headers = realloc(r->headers, sizeof(r->headers) + sizeof(Header*) * HEADER_COUNT);
+		// reached capacity - re-allocate with room for HEADER_COUNT more headers
+		size_t cap = r->headerCap + HEADER_COUNT;
+		Header** headers = areRealloc(r->headers, sizeof(Header*) * cap, SITE_RESPONSE);
 
-		if (!r->headers) {
-			free(h);
+		if (!headers) {
+			areFree(h->key);
+			areFree(h->value);
+			areFree(h);
 
 			return NULL;
 		}
 
-		r->headerCap += HEADER_COUNT;
+		r->headers = headers;
+		r->headerCap = (int) cap;
 	}
 
 	r->headers[r->headerCount++] = h;
@@ -154,12 +157,12 @@ void populateResponse(CURL* curl, Response* r) {
  */
 void freeResponse(Response* r) {
 	for (int i = 0; i < r->headerCount; i++) {
-		free(r->headers[i]->key);
-		free(r->headers[i]->value);
-		free(r->headers[i]);
+		areFree(r->headers[i]->key);
+		areFree(r->headers[i]->value);
+		areFree(r->headers[i]);
 	}
 
 	freePayload(r->body);
-	free(r->headers);
-	free(r);
+	areFree(r->headers);
+	areFree(r);
 }
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alloc.h"
+
 // curl includes the windows headers so need to disable the warning here too
 #pragma warning(disable:5105)
 #include <curl/curl.h>
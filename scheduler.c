@@ -0,0 +1,136 @@
+#include "scheduler.h"
+
+/**
+ * Allocate a scheduler and its waitable timer.
+ * @param  period Time between iterations in microseconds.
+ * @param  policy What to do with iterations whose deadline has passed.
+ * @return        NULL if out of memory or the timer could not be created.
+ */
+Scheduler* createScheduler(uint64_t period, enum missPolicy policy) {
+	Scheduler* s = malloc(sizeof(*s));
+
+	if (!s) {
+		return NULL;
+	}
+
+	// high resolution timers are only available from Windows 10 1803
+	// onwards so fall back to a regular one on older versions
+	s->timer = CreateWaitableTimerExW(
+		NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS
+	);
+
+	if (!s->timer) {
+		s->timer = CreateWaitableTimerW(NULL, true, NULL);
+	}
+
+	if (!s->timer) {
+		free(s);
+
+		return NULL;
+	}
+
+	s->period = period;
+	s->policy = policy;
+	s->overruns = 0;
+	s->skipped = 0;
+
+	schedulerReset(s);
+
+	return s;
+}
+
+/**
+ * Start a new schedule with the current iteration beginning now. Used when
+ * the loop resumes after being idle.
+ * @param s
+ */
+void schedulerReset(Scheduler* s) {
+	s->deadline = timerNow();
+}
+
+/**
+ * Block until the time stamp deadline has been reached. Returns immediately
+ * if it already has.
+ * @param  s
+ * @param  deadline Absolute time stamp obtained from timerNow().
+ * @return          False if waiting on the timer failed.
+ */
+bool schedulerSleepUntil(Scheduler* s, uint64_t deadline) {
+	uint64_t now = timerNow();
+
+	if (now >= deadline) {
+		return true;
+	}
+
+	// negative due times are relative and expressed in 100ns intervals
+	LARGE_INTEGER due;
+	due.QuadPart = -((LONGLONG) (deadline - now) * 10);
+
+	if (!SetWaitableTimer(s->timer, &due, 0, NULL, NULL, false)) {
+		return false;
+	}
+
+	return WaitForSingleObject(s->timer, INFINITE) == WAIT_OBJECT_0;
+}
+
+/**
+ * Wait until the next iteration is due according to the miss policy.
+ * @param  s
+ * @return   How late (in microseconds) the next iteration is starting.
+ */
+uint64_t schedulerWait(Scheduler* s) {
+	uint64_t now = timerNow();
+
+	s->deadline += s->period;
+
+	if (now >= s->deadline) {
+		// the iteration took longer than the period
+		s->overruns++;
+
+		uint64_t missed = (now - s->deadline) / s->period;
+
+		if (s->policy == MISS_CATCH_UP && missed < SCHEDULER_MAX_BACKLOG) {
+			// start immediately and keep the original deadlines
+			return now - s->deadline;
+		}
+
+		// resume at the first deadline still in the future
+		s->skipped += missed + 1;
+		s->deadline += (missed + 1) * s->period;
+	}
+
+	if (!schedulerSleepUntil(s, s->deadline)) {
+		// the timer is broken; don't spin
+		Sleep((DWORD) (s->period / 1000));
+	}
+
+	now = timerNow();
+
+	return (now > s->deadline) ? now - s->deadline : 0;
+}
+
+/**
+ * Write the overrun counters to stdout (log.txt in release builds).
+ * @param s
+ */
+void schedulerPrint(const Scheduler* s) {
+	printf("Scheduler: period=%lluus overruns=%llu skipped=%llu\n",
+		(unsigned long long) s->period,
+		(unsigned long long) s->overruns,
+		(unsigned long long) s->skipped);
+
+	fflush(stdout);
+}
+
+/**
+ * Free a scheduler and its timer. Does nothing if s is NULL.
+ * @param s
+ */
+void freeScheduler(Scheduler* s) {
+	if (!s) {
+		return;
+	}
+
+	CloseHandle(s->timer);
+	free(s);
+}
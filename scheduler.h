@@ -0,0 +1,49 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "timer.h"
+
+// the most missed iterations MISS_CATCH_UP will run back to back before
+// giving up on the remainder (eg. after the machine wakes from sleep)
+#define SCHEDULER_MAX_BACKLOG 5
+
+// what to do when an iteration runs past the start of the next one
+enum missPolicy {
+	// drop the missed iterations and resume at the next future deadline
+	MISS_SKIP = 0,
+
+	// run the missed iterations back to back until caught up
+	MISS_CATCH_UP
+};
+
+/**
+ * Absolute deadline scheduler. Deadlines are multiples of the period from the
+ * last reset so iterations don't drift regardless of how long each one takes.
+ */
+typedef struct scheduler {
+	// time between iterations in microseconds
+	uint64_t period;
+
+	// start time of the current iteration (timerNow() epoch)
+	uint64_t deadline;
+
+	enum missPolicy policy;
+
+	// iterations that ran past the start of the next one
+	uint64_t overruns;
+
+	// iterations that were dropped instead of run
+	uint64_t skipped;
+
+	// waitable timer used to sleep until a deadline
+	HANDLE timer;
+} Scheduler;
+
+Scheduler* createScheduler(uint64_t, enum missPolicy);
+void schedulerReset(Scheduler*);
+bool schedulerSleepUntil(Scheduler*, uint64_t);
+uint64_t schedulerWait(Scheduler*);
+void schedulerPrint(const Scheduler*);
+void freeScheduler(Scheduler*);
+
+#endif
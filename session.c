@@ -0,0 +1,212 @@
+#include "session.h"
+
+/**
+ * Allocate an empty session context. It is built on the first sessionUpdate().
+ * @param  cars Car metadata; must outlive the context.
+ * @return      NULL if out of memory.
+ */
+Session* createSession(const CarTable* cars) {
+	Session* s = calloc(1, sizeof(*s));
+
+	if (!s) {
+		return NULL;
+	}
+
+	s->cars = cars;
+
+	return s;
+}
+
+/**
+ * FNV-1a over the properties a word at a time. Properties is around 700 bytes
+ * so this is considerably cheaper than comparing every field.
+ * @param  props
+ */
+uint64_t sessionFingerprint(const Properties* props) {
+	const unsigned char* bytes = (const unsigned char*) props;
+	size_t len = sizeof(*props);
+	uint64_t hash = FNV_OFFSET;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t word;
+
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = (hash ^ word) * FNV_PRIME;
+	}
+
+	for (; i < len; i++) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/**
+ * Free everything derived from the properties.
+ */
+static void clearSession(Session* s) {
+	for (int i = 0; i < s->itemCount; i++) {
+		areFree(s->items[i].key);
+		cJSON_free(s->items[i].raw);
+	}
+
+	areFree(s->track);
+	areFree(s->carModel);
+
+	s->itemCount = 0;
+	s->track = NULL;
+	s->carModel = NULL;
+}
+
+/**
+ * Serialise each top level key produced by propertiesToJSON.
+ * @return False if out of memory.
+ */
+static bool serialiseProperties(Session* s, const Properties* props) {
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return false;
+	}
+
+	obj = propertiesToJSON(obj, props);
+
+	if (!obj) {
+		return false;
+	}
+
+	// add the metadata not present in shared memory
+	if (s->car) {
+		cJSON* car = cJSON_GetObjectItemCaseSensitive(obj, "car");
+
+		if (car && !cJSON_AddStringToObject(car, "class", s->car->carClass)) {
+			cJSON_Delete(obj);
+
+			return false;
+		}
+	}
+
+	cJSON* child = NULL;
+
+	cJSON_ArrayForEach(child, obj) {
+		if (s->itemCount == SESSION_ITEM_MAX) {
+			// SESSION_ITEM_MAX must be raised
+			break;
+		}
+
+		struct sessionItem* item = &s->items[s->itemCount];
+
+		item->key = areStrdup(child->string, SITE_CJSON);
+		item->raw = cJSON_PrintUnformatted(child);
+
+		if (!item->key || !item->raw) {
+			areFree(item->key);
+			cJSON_free(item->raw);
+			cJSON_Delete(obj);
+
+			return false;
+		}
+
+		s->itemCount++;
+	}
+
+	cJSON_Delete(obj);
+
+	return true;
+}
+
+/**
+ * (Re)build the context from props.
+ * @return False if out of memory.
+ */
+static bool buildSession(Session* s, const Properties* props, uint64_t fingerprint) {
+	char* track = wstrToStr(props->track);
+	char* carModel = wstrToStr(props->carModel);
+
+	if (!track || !carModel) {
+		areFree(track);
+		areFree(carModel);
+
+		return false;
+	}
+
+	// compare against the previously interned strings before releasing them
+	s->newTrackOrCar = s->built && (strcmp(track, s->track) != 0 || strcmp(carModel, s->carModel) != 0);
+
+	clearSession(s);
+	s->track = track;
+	s->carModel = carModel;
+	s->sectorCount = props->sectorCount;
+	s->car = carsFind(s->cars, props->carModel);
+	s->carOffset = s->car ? s->car->biasOffset : 0;
+
+	if (!serialiseProperties(s, props)) {
+		// leave the context unbuilt so that the next update retries
+		clearSession(s);
+		s->built = false;
+
+		return false;
+	}
+
+	s->fingerprint = fingerprint;
+	s->built = true;
+	s->builds++;
+
+	return true;
+}
+
+/**
+ * Rebuild the context if props has changed since it was last built. The context
+ * outlives a tick so it is always allocated on the heap rather than the arena.
+ * @param  s
+ * @param  props
+ * @return       False if out of memory.
+ */
+bool sessionUpdate(Session* s, const Properties* props) {
+	uint64_t fingerprint = sessionFingerprint(props);
+
+	s->updated = false;
+	s->newTrackOrCar = false;
+
+	if (s->built && fingerprint == s->fingerprint) {
+		return true;
+	}
+
+	Arena* arena = allocUseArena(NULL);
+	bool result = buildSession(s, props, fingerprint);
+
+	allocUseArena(arena);
+	s->updated = result;
+
+	return result;
+}
+
+/**
+ * Add the pre-serialised properties to obj.
+ * @param  obj
+ * @param  s
+ * @return     NULL if out of memory (obj is deleted).
+ */
+cJSON* sessionToJSON(cJSON* obj, const Session* s) {
+	for (int i = 0; i < s->itemCount; i++) {
+		if (!cJSON_AddRawToObject(obj, s->items[i].key, s->items[i].raw)) {
+			RET_NULL(obj);
+		}
+	}
+
+	return obj;
+}
+
+/**
+ * Free a session context. Does nothing if s is NULL.
+ * @param s
+ */
+void freeSession(Session* s) {
+	if (!s) {
+		return;
+	}
+
+	clearSession(s);
+	free(s);
+}
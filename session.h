@@ -0,0 +1,65 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "cars.h"
+#include "properties.h"
+
+// maximum number of top level keys produced by propertiesToJSON
+#define SESSION_ITEM_MAX 16
+
+// FNV-1a 64 bit offset basis and prime
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// a top level properties key and its value serialised as JSON
+struct sessionItem {
+	char* key;
+	char* raw;
+};
+
+/**
+ * Values derived from Properties. Only rebuilt when the fingerprint of the
+ * properties changes so that they aren't recomputed every tick.
+ */
+typedef struct session {
+	// fingerprint of the properties the context was built from
+	uint64_t fingerprint;
+
+	// whether or not the context has been built at least once
+	bool built;
+
+	// whether or not the last sessionUpdate() rebuilt the context
+	bool updated;
+
+	// whether or not the last rebuild changed the track or car
+	bool newTrackOrCar;
+
+	// metadata of the car model (NULL if unknown) and its brake bias offset
+	const Car* car;
+	int carOffset;
+
+	// number of sectors on track
+	int sectorCount;
+
+	// interned UTF-8 track name and car model
+	char* track;
+	char* carModel;
+
+	// pre-serialised properties
+	struct sessionItem items[SESSION_ITEM_MAX];
+	int itemCount;
+
+	// number of rebuilds
+	uint64_t builds;
+
+	// car metadata the model is looked up in
+	const CarTable* cars;
+} Session;
+
+Session* createSession(const CarTable*);
+uint64_t sessionFingerprint(const Properties*);
+bool sessionUpdate(Session*, const Properties*);
+cJSON* sessionToJSON(cJSON*, const Session*);
+void freeSession(Session*);
+
+#endif
@@ -33,6 +33,7 @@ SharedMem* createSharedMem() {
 	sm->szHud = sizeof(HUD);
 	sm->szPhysics = sizeof(Physics);
 	sm->szProps = sizeof(Properties);
+	sm->retries = 0;
 
 	// allocate memory for the data to be copied from the
 	// shared memory locations at a later time.
@@ -77,15 +78,41 @@ void freeSharedMem(SharedMem* sm) {
 	free(sm);
 }
 
+/**
+ * Copy a frame beginning with a packet id. ACC keeps writing to shared memory
+ * while it's being copied, so the copy is repeated (up to SM_COPY_RETRIES times)
+ * if the packet id changed in the meantime.
+ * @param  dst
+ * @param  src  Must begin with an int packet id.
+ * @param  size
+ * @return      The number of times the copy was repeated.
+ */
+static uint64_t copyFrame(void* dst, const void* src, size_t size) {
+	const volatile int* packetId = (const volatile int*) src;
+	uint64_t retries = 0;
+
+	for (;;) {
+		int before = *packetId;
+
+		memcpy(dst, src, size);
+
+		if (*packetId == before || retries == SM_COPY_RETRIES) {
+			return retries;
+		}
+
+		retries++;
+	}
+}
+
 /**
  * Copy the data in shared memory (pointed to by pointers in curr) to heap
  * memory (pointed to by pointers in prev) and overwrite it
  * @param sm
  */
 void sharedMemCurrToPrev(SharedMem* sm) {
-	// there's no way that this could result in invalid data being left
-	// on the heap and screwing the values, right??
-	memcpy(sm->prev.hud, sm->curr.hud, sm->szHud);
+	sm->retries += copyFrame(sm->prev.hud, sm->curr.hud, sm->szHud);
+	sm->retries += copyFrame(sm->prev.physics, sm->curr.physics, sm->szPhysics);
+
+	// properties has no packet id but is only written on session changes
 	memcpy(sm->prev.props, sm->curr.props, sm->szProps);
-	memcpy(sm->prev.physics, sm->curr.physics, sm->szPhysics);
 }
@@ -9,6 +9,9 @@
 #define SM_HUD L"Local\\acpmf_graphics"
 #define SM_PROPS L"Local\\acpmf_static"
 
+// how many times a frame copy is repeated when ACC wrote to it mid-copy
+#define SM_COPY_RETRIES 3
+
 struct memMaps {
 	HUD* hud;
 	Physics* physics;
@@ -21,6 +24,9 @@ typedef struct sharedMem {
 	size_t szHud;
 	size_t szPhysics;
 	size_t szProps;
+
+	// frame copies repeated because the frame changed while being copied
+	uint64_t retries;
 } SharedMem;
 
 SharedMem* createSharedMem();
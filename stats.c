@@ -0,0 +1,222 @@
+#include "stats.h"
+
+/**
+ * Index of the most significant set bit. v must be non-zero.
+ */
+static int highestBit(uint64_t v) {
+	unsigned long idx;
+
+	// split into halves so that this also works on 32-bit targets
+	if (_BitScanReverse(&idx, (unsigned long) (v >> 32))) {
+		return (int) idx + 32;
+	}
+
+	_BitScanReverse(&idx, (unsigned long) v);
+
+	return (int) idx;
+}
+
+/**
+ * Map a value to its bucket. Values below HISTOGRAM_SUB_COUNT get a bucket
+ * each, larger values share a bucket with neighbours within the same
+ * 1/HISTOGRAM_SUB_COUNT fraction of their power of two.
+ */
+static int bucketIndex(uint64_t v) {
+	if (v < HISTOGRAM_SUB_COUNT) {
+		return (int) v;
+	}
+
+	int shift = highestBit(v) - HISTOGRAM_SUB_BITS;
+	int idx = (shift + 1) * HISTOGRAM_SUB_COUNT + (int) ((v >> shift) - HISTOGRAM_SUB_COUNT);
+
+	// clamp absurd values into the last bucket
+	return (idx < HISTOGRAM_BUCKETS) ? idx : HISTOGRAM_BUCKETS - 1;
+}
+
+/**
+ * The largest value that maps to the bucket at idx.
+ */
+static uint64_t bucketUpper(int idx) {
+	if (idx < HISTOGRAM_SUB_COUNT) {
+		return (uint64_t) idx;
+	}
+
+	int shift = idx / HISTOGRAM_SUB_COUNT - 1;
+	uint64_t lower = (uint64_t) (HISTOGRAM_SUB_COUNT + idx % HISTOGRAM_SUB_COUNT) << shift;
+
+	return lower + ((uint64_t) 1 << shift) - 1;
+}
+
+/**
+ * Clear all recorded values.
+ * @param h
+ */
+void histogramReset(Histogram* h) {
+	memset(h->counts, 0, sizeof(h->counts));
+	h->count = 0;
+	h->sum = 0;
+	h->min = UINT64_MAX;
+	h->max = 0;
+}
+
+/**
+ * Record a value.
+ * @param h
+ * @param v Duration in microseconds.
+ */
+void histogramRecord(Histogram* h, uint64_t v) {
+	h->counts[bucketIndex(v)]++;
+	h->count++;
+	h->sum += v;
+
+	if (v < h->min) {
+		h->min = v;
+	}
+
+	if (v > h->max) {
+		h->max = v;
+	}
+}
+
+/**
+ * Add the values recorded in src to dst.
+ * @param dst
+ * @param src
+ */
+void histogramMerge(Histogram* dst, const Histogram* src) {
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		dst->counts[i] += src->counts[i];
+	}
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+
+	if (src->min < dst->min) {
+		dst->min = src->min;
+	}
+
+	if (src->max > dst->max) {
+		dst->max = src->max;
+	}
+}
+
+/**
+ * Get the value at or below which the fraction q of all recorded values lie.
+ * @param  h
+ * @param  q Between 0 and 1.
+ * @return   The upper bound of the matching bucket (capped by the maximum),
+ *           or zero if nothing has been recorded.
+ */
+uint64_t histogramPercentile(const Histogram* h, double q) {
+	if (h->count == 0) {
+		return 0;
+	}
+
+	// rank of the value being searched for (1-based)
+	uint64_t rank = (uint64_t) ceil(q * (double) h->count);
+	uint64_t seen = 0;
+
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += h->counts[i];
+
+		if (seen >= rank) {
+			uint64_t upper = bucketUpper(i);
+
+			return (upper < h->max) ? upper : h->max;
+		}
+	}
+
+	return h->max;
+}
+
+/**
+ * Get a stage as a char*.
+ * @param  s
+ * @return   No need to free.
+ */
+const char* stageToStr(enum stage s) {
+	switch (s) {
+	case STAGE_SNAPSHOT:
+		return "snapshot";
+	case STAGE_LAPS:
+		return "laps";
+	case STAGE_PROXIMITY:
+		return "proximity";
+	case STAGE_DELTA:
+		return "delta";
+	case STAGE_PUBLISH:
+		return "publish";
+	case STAGE_RECORD:
+		return "record";
+	case STAGE_OVERSHOOT:
+		return "overshoot";
+	case STAGE_COUNT:
+		break;
+	}
+
+	return "unknown";
+}
+
+/**
+ * Clear the tick count and all stage histograms.
+ * @param s
+ */
+void statsReset(LoopStats* s) {
+	s->ticks = 0;
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		histogramReset(&s->stages[i]);
+	}
+}
+
+/**
+ * Record the time elapsed since start against a stage.
+ * @param  s
+ * @param  stage
+ * @param  start Time stamp obtained from timerNow().
+ * @return       The current time stamp so that consecutive stages can be chained.
+ */
+uint64_t statsStage(LoopStats* s, enum stage stage, uint64_t start) {
+	uint64_t now = timerNow();
+
+	histogramRecord(&s->stages[stage], now - start);
+
+	return now;
+}
+
+/**
+ * Write a summary of every stage that has recorded values to stdout
+ * (log.txt in release builds).
+ * @param s
+ */
+void statsPrint(const LoopStats* s) {
+	printf("Loop stats after %llu ticks (microseconds):\n", (unsigned long long) s->ticks);
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		const Histogram* h = &s->stages[i];
+
+		if (h->count == 0) {
+			continue;
+		}
+
+		printf(
+			"  %-9s n=%llu min=%llu p50=%llu p90=%llu p99=%llu max=%llu mean=%llu\n",
+			stageToStr(i),
+			(unsigned long long) h->count,
+			(unsigned long long) h->min,
+			(unsigned long long) histogramPercentile(h, 0.5),
+			(unsigned long long) histogramPercentile(h, 0.9),
+			(unsigned long long) histogramPercentile(h, 0.99),
+			(unsigned long long) h->max,
+			(unsigned long long) (h->sum / h->count)
+		);
+	}
+
+	// the log is a regular file in release builds so make sure the
+	// summary lands even if the process is killed
+	fflush(stdout);
+}
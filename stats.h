@@ -0,0 +1,73 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <intrin.h>
+#include "timer.h"
+
+// each power of two is split into 2^HISTOGRAM_SUB_BITS linear buckets
+// which bounds the relative error of a recorded value to 12.5%
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+
+// enough buckets to hold values up to 2^40 microseconds (~12 days)
+#define HISTOGRAM_BUCKETS (38 * HISTOGRAM_SUB_COUNT)
+
+// how many loop iterations between summaries written to the log
+#define STATS_LOG_INTERVAL 300
+
+/**
+ * Log-linear histogram of durations expressed in microseconds.
+ * Recording a value never allocates.
+ */
+typedef struct histogram {
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+} Histogram;
+
+// stages of a single loop iteration
+enum stage {
+	// copying the current frame to the previous frame
+	STAGE_SNAPSHOT = 0,
+
+	// feeding a sample to the lap engines (see trackedSample())
+	STAGE_LAPS,
+
+	// finding the cars near the player
+	STAGE_PROXIMITY,
+
+	// comparing frames and serialising the JSON
+	STAGE_DELTA,
+
+	// sending the JSON to the server
+	STAGE_PUBLISH,
+
+	// writing the frame to the flight recording
+	STAGE_RECORD,
+
+	// how late an iteration started relative to its deadline
+	STAGE_OVERSHOOT,
+
+	STAGE_COUNT
+};
+
+typedef struct loopStats {
+	// completed loop iterations
+	uint64_t ticks;
+
+	Histogram stages[STAGE_COUNT];
+} LoopStats;
+
+void histogramReset(Histogram*);
+void histogramRecord(Histogram*, uint64_t);
+void histogramMerge(Histogram*, const Histogram*);
+uint64_t histogramPercentile(const Histogram*, double);
+const char* stageToStr(enum stage);
+void statsReset(LoopStats*);
+uint64_t statsStage(LoopStats*, enum stage, uint64_t);
+void statsPrint(const LoopStats*);
+
+#endif
@@ -0,0 +1,122 @@
+#include "pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// words of the test struct and frames of a group
+#define TEST_WORDS 64
+#define TEST_FRAMES 64
+
+/**
+ * Pack and unpack frames, checking the stream fits packBound() and decodes
+ * to the same frames.
+ * @return False on failure.
+ */
+static bool roundTrip(const char* name, const uint8_t* lanes, const uint32_t* frames, const uint64_t* times) {
+	size_t size = TEST_WORDS * 4;
+	size_t bound = packBound(size, TEST_FRAMES);
+	uint8_t* out = malloc(bound);
+	uint32_t* back = malloc(size * TEST_FRAMES);
+	uint64_t backTimes[TEST_FRAMES];
+
+	if (!out || !back) {
+		printf("%s: out of memory\n", name);
+		free(out);
+		free(back);
+
+		return false;
+	}
+
+	size_t bytes = packFrames(out, lanes, frames, size, times, TEST_FRAMES);
+	bool ok = bytes <= bound;
+
+	if (!ok) {
+		printf("%s: %zu bytes exceeds the bound of %zu\n", name, bytes, bound);
+	} else if (!unpackFrames(out, bytes, lanes, back, size, backTimes, TEST_FRAMES) ||
+		memcmp(back, frames, size * TEST_FRAMES) != 0 ||
+		memcmp(backTimes, times, sizeof(backTimes)) != 0) {
+		printf("%s: round trip differs\n", name);
+		ok = false;
+	}
+
+	free(out);
+	free(back);
+
+	return ok;
+}
+
+static uint64_t random64() {
+	uint64_t v = 0;
+
+	for (int i = 0; i < 4; i++) {
+		v = (v << 16) ^ (uint64_t) (rand() & 0xFFFF);
+	}
+
+	return v;
+}
+
+/**
+ * Every value takes the longest encoding of its lane: XOR windows that never
+ * fit the previous one, delta-of-deltas that always escape, and times with
+ * unrelated 64 bit deltas.
+ */
+static bool worstCase(const uint8_t* lanes) {
+	static uint32_t frames[TEST_FRAMES][TEST_WORDS];
+	uint64_t times[TEST_FRAMES];
+
+	for (int i = 0; i < TEST_FRAMES; i++) {
+		times[i] = random64();
+
+		for (int j = 0; j < TEST_WORDS; j++) {
+			if (lanes[j] == PACK_DOD) {
+				// deltas of +/-(2^31 - 1) so each delta-of-delta needs 33 bits
+				frames[i][j] = i % 2 ? 0x7FFFFFFFu : 0;
+			} else {
+				// XOR alternates between the lowest and highest bit
+				frames[i][j] = i == 0 ? 0 : frames[i - 1][j] ^ (i % 2 ? 0x1u : 0x80000000u);
+			}
+		}
+	}
+
+	return roundTrip("worst case", lanes, &frames[0][0], times);
+}
+
+/**
+ * Random frames and times.
+ */
+static bool fuzz(const uint8_t* lanes, int runs) {
+	static uint32_t frames[TEST_FRAMES][TEST_WORDS];
+	uint64_t times[TEST_FRAMES];
+
+	for (int run = 0; run < runs; run++) {
+		for (int i = 0; i < TEST_FRAMES; i++) {
+			times[i] = random64();
+
+			for (int j = 0; j < TEST_WORDS; j++) {
+				frames[i][j] = (uint32_t) random64();
+			}
+		}
+
+		if (!roundTrip("fuzz", lanes, &frames[0][0], times)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main() {
+	uint8_t lanes[TEST_WORDS];
+	uint8_t dod[TEST_WORDS];
+
+	srand(1);
+
+	for (int j = 0; j < TEST_WORDS; j++) {
+		lanes[j] = j % 2 ? PACK_DOD : PACK_XOR;
+		dod[j] = PACK_DOD;
+	}
+
+	bool ok = worstCase(lanes) && worstCase(dod) && fuzz(lanes, 200) && fuzz(dod, 200);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
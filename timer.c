@@ -0,0 +1,34 @@
+#include "timer.h"
+
+/**
+ * Get the number of performance counter ticks per second. Queried once
+ * since the frequency is fixed at boot.
+ */
+static uint64_t frequency() {
+	static uint64_t freq = 0;
+
+	if (!freq) {
+		LARGE_INTEGER li;
+
+		QueryPerformanceFrequency(&li);
+		freq = (uint64_t) li.QuadPart;
+	}
+
+	return freq;
+}
+
+/**
+ * Get a monotonic time stamp in microseconds. Only useful for measuring
+ * intervals; the epoch is unspecified.
+ */
+uint64_t timerNow() {
+	LARGE_INTEGER li;
+	uint64_t freq = frequency();
+
+	QueryPerformanceCounter(&li);
+
+	uint64_t ticks = (uint64_t) li.QuadPart;
+
+	// split the conversion to avoid overflowing ticks * 1000000
+	return (ticks / freq) * 1000000 + (ticks % freq) * 1000000 / freq;
+}
@@ -0,0 +1,9 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include "auxiliary.h"
+
+uint64_t timerNow();
+
+#endif
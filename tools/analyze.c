@@ -0,0 +1,621 @@
+#include "analyze.h"
+
+/**
+ * What a scan remembers of the previous frame. Packed frames are only valid
+ * until the next one is read so nothing points into them.
+ */
+struct lapState {
+	int sessionIndex;
+	int completedLaps;
+	int sector;
+};
+
+/**
+ * Running totals of the lap being scanned.
+ */
+struct lapAcc {
+	struct lapResult lap;
+	uint64_t samples;
+	float fuelStart;
+	double tyreTemp[4];
+	double tyrePressure[4];
+};
+
+/**
+ * Print the command line usage.
+ */
+static void usage() {
+	printf(
+		"usage: are_analyze [options] <directory | recording.rec>...\n"
+		"  -o <file>   summary table (default: " ANALYZE_OUT ")\n"
+		"  -j <count>  worker threads (default: one per logical processor)\n"
+	);
+}
+
+/**
+ * Parse the command line.
+ * @return False if the arguments are invalid.
+ */
+static bool parseOptions(struct analyzeOptions* o, int argc, char** argv) {
+	o->out = ANALYZE_OUT;
+	o->workers = poolDefaultWorkers();
+	o->inputs = argv;
+	o->inputCount = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (strcmp(arg, "-o") == 0 && value) {
+			o->out = value;
+			i++;
+		} else if (strcmp(arg, "-j") == 0 && value) {
+			o->workers = atoi(value);
+			i++;
+		} else if (arg[0] != '-') {
+			// inputs are gathered at the front of argv
+			o->inputs[o->inputCount++] = argv[i];
+		} else {
+			return false;
+		}
+	}
+
+	return o->inputCount > 0 && o->workers > 0;
+}
+
+/**
+ * Add a recording to the list, growing it as required.
+ * @return False if out of memory.
+ */
+static bool addFile(struct analyzeFile** files, size_t* count, size_t* cap, const char* path) {
+	if (*count == *cap) {
+		size_t size = *cap ? *cap * 2 : 16;
+		struct analyzeFile* temp = realloc(*files, sizeof(*temp) * size);
+
+		if (!temp) {
+			return false;
+		}
+
+		*files = temp;
+		*cap = size;
+	}
+
+	struct analyzeFile* f = &(*files)[(*count)++];
+
+	memset(f, 0, sizeof(*f));
+	snprintf(f->path, sizeof(f->path), "%s", path);
+	InitializeSRWLock(&f->lock);
+
+	return true;
+}
+
+/**
+ * Add an input: every *.rec in it if it is a directory, otherwise the file itself.
+ * @return False if out of memory.
+ */
+static bool addInput(struct analyzeFile** files, size_t* count, size_t* cap, const char* input) {
+	char pattern[ANALYZE_PATH_SIZE];
+	char path[ANALYZE_PATH_SIZE];
+	WIN32_FIND_DATAA data;
+	DWORD attributes = GetFileAttributesA(input);
+
+	if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		return addFile(files, count, cap, input);
+	}
+
+	snprintf(pattern, sizeof(pattern), "%s\\*.rec", input);
+
+	HANDLE h = FindFirstFileA(pattern, &data);
+
+	if (h == INVALID_HANDLE_VALUE) {
+		return true;
+	}
+
+	bool ok = true;
+
+	do {
+		snprintf(path, sizeof(path), "%s\\%s", input, data.cFileName);
+		ok = addFile(files, count, cap, path);
+	} while (ok && FindNextFileA(h, &data));
+
+	FindClose(h);
+
+	return ok;
+}
+
+/**
+ * A private cursor over a recording's shared mapping. Free it with freeCursor().
+ */
+static void openCursor(RecReader* c, const RecReader* r) {
+	*c = *r;
+	c->packPhysics = NULL;
+	c->packHud = NULL;
+	recRewind(c);
+}
+
+static void freeCursor(RecReader* c) {
+	free(c->packPhysics);
+	free(c->packHud);
+}
+
+/**
+ * Start accumulating the lap a frame belongs to.
+ */
+static void startLap(struct lapAcc* a, const RecFrame* f, uint32_t session) {
+	memset(a, 0, sizeof(*a));
+	a->lap.session = session;
+	a->lap.lap = f->hud->completedLaps + 1;
+	a->lap.partial = f->hud->currLapTime > LAP_JOIN_MS;
+	a->fuelStart = f->physics->fuelRemaining;
+}
+
+/**
+ * Add a frame of the lap being scanned.
+ */
+static void addFrame(struct lapAcc* a, const RecFrame* f) {
+	const Physics* p = f->physics;
+
+	a->samples++;
+	a->lap.valid = f->hud->isValidLap;
+	a->lap.pit = a->lap.pit || f->hud->isInPitLane;
+	a->lap.fuel = a->fuelStart - p->fuelRemaining;
+	a->lap.topSpeed = p->speed > a->lap.topSpeed ? p->speed : a->lap.topSpeed;
+
+	for (int i = 0; i < 4; i++) {
+		a->tyreTemp[i] += p->tyreCoreTemp[i];
+		a->tyrePressure[i] += p->tyrePressure[i];
+	}
+}
+
+/**
+ * Complete a lap at the first frame of the next one and add it to the file.
+ * @param  f
+ * @param  a
+ * @param  t    Sector times of the lap.
+ * @param  time prevLapTime of the first frame of the next lap.
+ * @return      False if out of memory.
+ */
+static bool finishLap(struct analyzeFile* f, struct lapAcc* a, const Tracked* t, int time) {
+	struct lapResult* lap = &a->lap;
+	bool ok = true;
+
+	lap->time = (time > 0 && time < ANALYZE_MAX_TIME) ? time : -1;
+	lap->sectorCount = t->sectorCount < ANALYZE_SECTORS ? t->sectorCount : ANALYZE_SECTORS;
+	memcpy(lap->sectors, t->sectors, sizeof(int) * lap->sectorCount);
+
+	for (int i = 0; a->samples && i < 4; i++) {
+		lap->tyreTemp[i] = (float) (a->tyreTemp[i] / (double) a->samples);
+		lap->tyrePressure[i] = (float) (a->tyrePressure[i] / (double) a->samples);
+	}
+
+	AcquireSRWLockExclusive(&f->lock);
+
+	if (f->lapCount == f->lapCap) {
+		size_t cap = f->lapCap ? f->lapCap * 2 : 64;
+		struct lapResult* temp = realloc(f->laps, sizeof(*temp) * cap);
+
+		if (temp) {
+			f->laps = temp;
+			f->lapCap = cap;
+		} else {
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		f->laps[f->lapCount++] = *lap;
+	}
+
+	ReleaseSRWLockExclusive(&f->lock);
+
+	return ok;
+}
+
+/**
+ * Scan laps with the same sector logic as prevSector() in delta.c. A lap is
+ * complete once completedLaps goes up; a lap the recording ends in is dropped.
+ * @param  f
+ * @param  from Index entry of the first frame of a lap to scan that lap only,
+ *              or NULL to scan the whole recording.
+ * @return      Zero on success or an error code defined in error.h.
+ */
+static int scanLaps(struct analyzeFile* f, const RecIndexEntry* from) {
+	RecReader r;
+	RecFrame frame;
+	struct lapAcc acc;
+	struct lapState prev;
+	uint32_t session = from ? from->session : 0;
+	bool started = false;
+	int error = 0;
+
+	// only the sector times are used, so the lap engines are not created
+	Tracked sectors = {0};
+	Tracked* t = &sectors;
+
+	if (!setSectorCount(t, f->sectorCount)) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	openCursor(&r, f->reader);
+
+	if (from) {
+		recSeekLap(&r, from->session, from->lap, from->sector);
+	}
+
+	while (error == 0 && recNextFrame(&r, &frame)) {
+		const HUD* h = frame.hud;
+
+		if (started) {
+			// same rules as recIndexFrame()
+			bool newSession = h->sessionIndex != prev.sessionIndex || h->completedLaps < prev.completedLaps;
+			bool lapDone = !newSession && h->completedLaps > prev.completedLaps;
+
+			if (!newSession && prev.sector >= 0 && prev.sector < t->sectorCount && h->currSectorIndex != prev.sector) {
+				addSector(t, prev.sector, lapDone ? h->prevLapTime : h->cumulativeSectorTime);
+			}
+
+			if (lapDone && !finishLap(f, &acc, t, h->prevLapTime)) {
+				error = ARE_OUT_OF_MEM;
+			}
+
+			if ((lapDone || newSession) && from) {
+				break;
+			}
+
+			if (newSession) {
+				session++;
+			}
+
+			if (lapDone || newSession) {
+				resetSectors(t);
+				startLap(&acc, &frame, session);
+			}
+		} else {
+			startLap(&acc, &frame, session);
+			started = true;
+		}
+
+		addFrame(&acc, &frame);
+		prev.sessionIndex = h->sessionIndex;
+		prev.completedLaps = h->completedLaps;
+		prev.sector = h->currSectorIndex;
+	}
+
+	if (r.corrupt) {
+		printf("%s: stopped at a corrupt block\n", f->path);
+	}
+
+	freeCursor(&r);
+	free(t->sectors);
+
+	return error;
+}
+
+/**
+ * Pool task: scan one lap, or a whole unindexed recording.
+ */
+static void lapTask(Pool* pool, int worker, void* arg) {
+	struct lapTask* task = (struct lapTask*) arg;
+	int error = scanLaps(task->file, task->from);
+
+	(void) pool;
+	(void) worker;
+
+	if (error != 0) {
+		// other workers may be scanning laps of the same file
+		AcquireSRWLockExclusive(&task->file->lock);
+		task->file->error = error;
+		ReleaseSRWLockExclusive(&task->file->lock);
+	}
+}
+
+/**
+ * Copy a properties string that may not be null terminated.
+ */
+static void copyName(wchar_t* dst, size_t size, const wchar_t* src) {
+	swprintf(dst, size, L"%.*ls", ANALYZE_NAME_SIZE, src);
+}
+
+/**
+ * Pool task: open a recording and queue a lap task for every lap start in its
+ * index on this worker, where idle workers can steal them. Recordings
+ * without an index are scanned as a single task.
+ */
+static void fileTask(Pool* pool, int worker, void* arg) {
+	struct analyzeFile* f = (struct analyzeFile*) arg;
+	RecReader c;
+	RecFrame frame;
+
+	f->error = recOpen(f->path, &f->reader);
+
+	if (f->error != 0) {
+		return;
+	}
+
+	f->sectorCount = DEFAULT_SECTOR_COUNT;
+	openCursor(&c, f->reader);
+
+	if (recNextFrame(&c, &frame) && frame.props) {
+		const Properties* p = frame.props;
+
+		swprintf(f->driver, ANALYZE_NAME_SIZE * 2, L"%.*ls %.*ls",
+			ANALYZE_NAME_SIZE, p->firstname, ANALYZE_NAME_SIZE, p->surname);
+		copyName(f->car, ANALYZE_NAME_SIZE, p->carModel);
+		copyName(f->track, ANALYZE_NAME_SIZE, p->track);
+
+		if (p->sectorCount > 0) {
+			f->sectorCount = p->sectorCount;
+		}
+	}
+
+	freeCursor(&c);
+
+	const RecIndexEntry* index = f->reader->index;
+
+	// the first frame and each frame where the lap or session changed
+	for (size_t i = 0; i < f->reader->indexCount; i++) {
+		if (i == 0 || index[i].session != index[i - 1].session || index[i].lap != index[i - 1].lap) {
+			f->taskCount++;
+		}
+	}
+
+	f->tasks = calloc(f->taskCount ? f->taskCount : 1, sizeof(*f->tasks));
+
+	if (!f->tasks) {
+		f->error = ARE_OUT_OF_MEM;
+
+		return;
+	}
+
+	if (f->taskCount == 0) {
+		f->tasks[0].file = f;
+		f->tasks[0].from = NULL;
+		lapTask(pool, worker, &f->tasks[0]);
+
+		return;
+	}
+
+	for (size_t i = 0, j = 0; i < f->reader->indexCount; i++) {
+		if (i == 0 || index[i].session != index[i - 1].session || index[i].lap != index[i - 1].lap) {
+			f->tasks[j].file = f;
+			f->tasks[j].from = &index[i];
+
+			if (!poolPush(pool, worker, &lapTask, &f->tasks[j++])) {
+				f->error = ARE_OUT_OF_MEM;
+
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * Order laps by session then lap number.
+ */
+static int compareLaps(const void* a, const void* b) {
+	const struct lapResult* x = a;
+	const struct lapResult* y = b;
+
+	if (x->session != y->session) {
+		return x->session < y->session ? -1 : 1;
+	}
+
+	return (x->lap > y->lap) - (x->lap < y->lap);
+}
+
+/**
+ * Order recordings by path, which orders the segments of a recording.
+ */
+static int compareFiles(const void* a, const void* b) {
+	return strcmp(((const struct analyzeFile*) a)->path, ((const struct analyzeFile*) b)->path);
+}
+
+/**
+ * Length of a segment's path without its "-<segment>.rec" suffix.
+ */
+static size_t recordingLength(const char* path) {
+	const char* dash = strrchr(path, '-');
+
+	return dash ? (size_t) (dash - path) : strlen(path);
+}
+
+/**
+ * Number the stints of every recording. A stint ends with a lap in the pit
+ * lane and continues across the segments of a recording.
+ */
+static void assignStints(struct analyzeFile* files, size_t count) {
+	int stint = 1;
+	bool pitted = false;
+
+	for (size_t i = 0; i < count; i++) {
+		struct analyzeFile* f = &files[i];
+		size_t len = recordingLength(f->path);
+
+		qsort(f->laps, f->lapCount, sizeof(*f->laps), &compareLaps);
+
+		if (i == 0 || len != recordingLength(files[i - 1].path) ||
+			strncmp(f->path, files[i - 1].path, len) != 0 || wcscmp(f->driver, files[i - 1].driver) != 0) {
+			stint = 1;
+			pitted = false;
+		}
+
+		for (size_t j = 0; j < f->lapCount; j++) {
+			if (j > 0 && f->laps[j].session != f->laps[j - 1].session) {
+				stint = 1;
+				pitted = false;
+			}
+
+			if (pitted) {
+				stint++;
+			}
+
+			f->laps[j].stint = stint;
+			pitted = f->laps[j].pit;
+		}
+	}
+}
+
+/**
+ * Write a row per lap.
+ * @return False if a write failed.
+ */
+static bool writeTable(const struct analyzeFile* files, size_t count, FILE* out) {
+	int sectors = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < files[i].lapCount; j++) {
+			sectors = files[i].laps[j].sectorCount > sectors ? files[i].laps[j].sectorCount : sectors;
+		}
+	}
+
+	fprintf(out, "recording,driver,car,track,session,lap,stint,time");
+
+	for (int s = 0; s < sectors; s++) {
+		fprintf(out, ",sector%d", s + 1);
+	}
+
+	fprintf(out, ",valid,pit,partial,fuel,topSpeed,tempFL,tempFR,tempRL,tempRR,pressureFL,pressureFR,pressureRL,pressureRR\n");
+
+	for (size_t i = 0; i < count; i++) {
+		const struct analyzeFile* f = &files[i];
+
+		for (size_t j = 0; j < f->lapCount; j++) {
+			const struct lapResult* l = &f->laps[j];
+
+			fprintf(out, "\"%s\",\"%ls\",\"%ls\",\"%ls\",%u,%d,%d,%d",
+				f->path, f->driver, f->car, f->track, l->session, l->lap, l->stint, l->time);
+
+			for (int s = 0; s < sectors; s++) {
+				fprintf(out, ",%d", s < l->sectorCount ? l->sectors[s] : 0);
+			}
+
+			fprintf(out, ",%d,%d,%d,%.3f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f\n",
+				l->valid, l->pit, l->partial, l->fuel, l->topSpeed,
+				l->tyreTemp[0], l->tyreTemp[1], l->tyreTemp[2], l->tyreTemp[3],
+				l->tyrePressure[0], l->tyrePressure[1], l->tyrePressure[2], l->tyrePressure[3]);
+		}
+	}
+
+	return !ferror(out);
+}
+
+/**
+ * Print a line per stint: laps, best and mean valid lap, and fuel per lap.
+ * Laps in the pit lane and partial laps are left out of the times and fuel.
+ */
+static void printStints(const struct analyzeFile* files, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		const struct analyzeFile* f = &files[i];
+
+		for (size_t j = 0; j < f->lapCount;) {
+			const struct lapResult* first = &f->laps[j];
+			int laps = 0, timed = 0, best = 0;
+			double total = 0.0, fuel = 0.0;
+
+			for (; j < f->lapCount && f->laps[j].stint == first->stint && f->laps[j].session == first->session; j++) {
+				const struct lapResult* l = &f->laps[j];
+
+				laps++;
+
+				if (l->valid && !l->pit && !l->partial && l->time > 0) {
+					best = (timed == 0 || l->time < best) ? l->time : best;
+					total += l->time;
+					fuel += l->fuel;
+					timed++;
+				}
+			}
+
+			printf("%s: %ls session %u stint %d: %d laps", f->path, f->driver, first->session, first->stint, laps);
+
+			if (timed > 0) {
+				printf(", best %.3f s, mean %.3f s, %.2f l/lap", best / 1000.0, total / timed / 1000.0, fuel / timed);
+			}
+
+			printf("\n");
+		}
+	}
+}
+
+/**
+ * Summarise the laps, stints, fuel, and tyres of many recordings using
+ * every core.
+ */
+int main(int argc, char** argv) {
+	struct analyzeOptions opts;
+	struct analyzeFile* files = NULL;
+	size_t count = 0;
+	size_t cap = 0;
+
+	if (!parseOptions(&opts, argc, argv)) {
+		usage();
+
+		return EXIT_FAILURE;
+	}
+
+	recInit();
+
+	for (int i = 0; i < opts.inputCount; i++) {
+		if (!addInput(&files, &count, &cap, opts.inputs[i])) {
+			printf("%ls\n", errorToWstr(ARE_OUT_OF_MEM));
+			free(files);
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	Pool* pool = createPool(opts.workers);
+	uint64_t start = timerNow();
+	bool ran = pool != NULL;
+
+	// spread the files over the workers; their laps are stolen from there
+	for (size_t i = 0; ran && i < count; i++) {
+		ran = poolPush(pool, (int) i, &fileTask, &files[i]);
+	}
+
+	ran = ran && poolRun(pool);
+
+	uint64_t elapsed = timerNow() - start;
+	size_t laps = 0;
+	int failed = 0;
+
+	qsort(files, count, sizeof(*files), &compareFiles);
+	assignStints(files, count);
+
+	for (size_t i = 0; i < count; i++) {
+		if (files[i].error != 0) {
+			printf("%s: %ls\n", files[i].path, errorToWstr(files[i].error));
+			failed++;
+		}
+
+		laps += files[i].lapCount;
+	}
+
+	printStints(files, count);
+
+	FILE* out = fopen(opts.out, "w");
+	bool written = out && writeTable(files, count, out);
+
+	written = out && fclose(out) == 0 && written;
+
+	if (written) {
+		printf("%s: %zu laps from %zu recordings in %.2f s (%d workers, %ld steals)\n",
+			opts.out, laps, count, elapsed / 1e6, opts.workers, pool ? (long) pool->steals : 0L);
+	} else {
+		printf("%s: %ls\n", opts.out, errorToWstr(ARE_FILE));
+	}
+
+	if (!ran) {
+		printf("%ls\n", errorToWstr(pool ? ARE_THREAD : ARE_OUT_OF_MEM));
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		recClose(files[i].reader);
+		free(files[i].tasks);
+		free(files[i].laps);
+	}
+
+	freePool(pool);
+	free(files);
+
+	return (written && ran && failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,105 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+#include "pool.h"
+#include "timer.h"
+#include "tracked.h"
+#include "recording.h"
+
+#define ANALYZE_OUT "analysis.csv"
+#define ANALYZE_PATH_SIZE 260
+
+// properties strings are 33 wide characters
+#define ANALYZE_NAME_SIZE 33
+
+// sector times kept per lap
+#define ANALYZE_SECTORS 8
+
+// lap times above this are bogus values (see MAX_TIME in hud.c)
+#define ANALYZE_MAX_TIME 600000
+
+/**
+ * Command line options.
+ */
+struct analyzeOptions {
+	const char* out;
+	int workers;
+
+	// recordings and directories of recordings
+	char** inputs;
+	int inputCount;
+};
+
+/**
+ * A completed lap.
+ */
+struct lapResult {
+	// sessions started since the start of the recording segment
+	uint32_t session;
+
+	// lap number (completed laps + 1) and time in milliseconds, -1 if the
+	// game gave a bogus value
+	int lap;
+	int time;
+
+	int sectors[ANALYZE_SECTORS];
+	int sectorCount;
+
+	bool valid;
+
+	// entered the pit lane during the lap
+	bool pit;
+
+	// the recording started part way through the lap, so everything but
+	// the lap time covers only part of it
+	bool partial;
+
+	// litres used (negative if refuelled)
+	float fuel;
+	float topSpeed;
+
+	// means over the lap (FL, FR, RL, RR)
+	float tyreTemp[4];
+	float tyrePressure[4];
+
+	// assigned once every lap of the recording is known
+	int stint;
+};
+
+struct analyzeFile;
+
+/**
+ * Scans a recording from an index entry to the end of that lap, or the
+ * whole recording if from is NULL.
+ */
+struct lapTask {
+	struct analyzeFile* file;
+	const RecIndexEntry* from;
+};
+
+/**
+ * A recording segment and the laps found in it. Laps are added by several
+ * workers at once.
+ */
+struct analyzeFile {
+	char path[ANALYZE_PATH_SIZE];
+	RecReader* reader;
+	int error;
+
+	// from the first properties of the recording
+	wchar_t driver[ANALYZE_NAME_SIZE * 2];
+	wchar_t car[ANALYZE_NAME_SIZE];
+	wchar_t track[ANALYZE_NAME_SIZE];
+	int sectorCount;
+
+	// one per lap start in the index
+	struct lapTask* tasks;
+	size_t taskCount;
+
+	SRWLOCK lock;
+	struct lapResult* laps;
+	size_t lapCount;
+	size_t lapCap;
+};
+
+#endif
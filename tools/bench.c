@@ -0,0 +1,168 @@
+#include "bench.h"
+
+/**
+ * Print the command line usage.
+ */
+static void usage() {
+	printf(
+		"usage: are_bench [options]\n"
+		"  -n <ticks>  simulated ticks (default: %d)\n"
+		"  -c <cars>   cars on track, 2-%d (default: %d)\n",
+		BENCH_TICKS, PROXIMITY_CARS, PROXIMITY_CARS
+	);
+}
+
+/**
+ * Parse the command line.
+ * @return False if the arguments are invalid.
+ */
+static bool parseOptions(struct benchOptions* o, int argc, char** argv) {
+	o->ticks = BENCH_TICKS;
+	o->cars = PROXIMITY_CARS;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (strcmp(arg, "-n") == 0 && value) {
+			o->ticks = atoi(value);
+			i++;
+		} else if (strcmp(arg, "-c") == 0 && value) {
+			o->cars = atoi(value);
+			i++;
+		} else {
+			return false;
+		}
+	}
+
+	return o->ticks >= BENCH_BATCH && o->cars >= 2 && o->cars <= PROXIMITY_CARS;
+}
+
+/**
+ * Spread the cars around a circular track with most of them in a pack
+ * around the player (car 0), as at the start of a race.
+ */
+static void placeCars(HUD* h, float* angles, float* speeds, int cars) {
+	h->activeCars = cars;
+	h->playerCarID = 0;
+
+	for (int i = 0; i < cars; i++) {
+		h->carID[i] = i;
+
+		// two thirds within 400 m of the player, the rest anywhere
+		float spread = i < cars * 2 / 3 ? 400.0f / BENCH_TRACK_RADIUS : 6.2831853f;
+
+		angles[i] = spread * ((float) rand() / (float) RAND_MAX - 0.5f);
+		speeds[i] = 40.0f + 20.0f * (float) rand() / (float) RAND_MAX;
+	}
+}
+
+/**
+ * Move every car along the track by one sample period.
+ */
+static void moveCars(HUD* h, Physics* phy, float* angles, const float* speeds, int cars) {
+	for (int i = 0; i < cars; i++) {
+		angles[i] += speeds[i] / SAMPLE_RATE / BENCH_TRACK_RADIUS;
+
+		// lanes a few metres apart so some cars are side by side
+		float r = BENCH_TRACK_RADIUS + (float) (i % 3) * 4.0f;
+
+		h->carCoordinates[i][0] = r * cosf(angles[i]);
+		h->carCoordinates[i][1] = 0.0f;
+		h->carCoordinates[i][2] = r * sinf(angles[i]);
+	}
+
+	phy->velocityVector[0] = -speeds[0] * sinf(angles[0]);
+	phy->velocityVector[2] = speeds[0] * cosf(angles[0]);
+}
+
+/**
+ * Count the cars within PROXIMITY_RADIUS of the player the obvious way to
+ * check the engine against.
+ */
+static int expectedCount(const HUD* h) {
+	const float* c = h->carCoordinates[0];
+	int count = 0;
+
+	for (int i = 1; i < h->activeCars; i++) {
+		float ox = h->carCoordinates[i][0] - c[0];
+		float oz = h->carCoordinates[i][2] - c[2];
+
+		count += sqrtf(ox * ox + oz * oz) <= PROXIMITY_RADIUS;
+	}
+
+	return count;
+}
+
+/**
+ * Time the proximity engine over a simulated field and check that it finds
+ * the cars it should.
+ */
+int main(int argc, char** argv) {
+	struct benchOptions opts;
+
+	if (!parseOptions(&opts, argc, argv)) {
+		usage();
+
+		return EXIT_FAILURE;
+	}
+
+	Proximity* p = createProximity();
+	HUD* h = calloc(1, sizeof(HUD));
+	Physics* phy = calloc(1, sizeof(Physics));
+
+	if (!p || !h || !phy) {
+		printf("%ls\n", errorToWstr(ARE_OUT_OF_MEM));
+
+		return EXIT_FAILURE;
+	}
+
+	float angles[PROXIMITY_CARS];
+	float speeds[PROXIMITY_CARS];
+	LoopStats stats;
+	uint64_t found = 0;
+	int mismatches = 0;
+
+	srand(1);
+	placeCars(h, angles, speeds, opts.cars);
+	statsReset(&stats);
+
+	// each tick is timed as part of a batch of BENCH_BATCH ticks on a field
+	// that moves between batches
+	for (int t = 0; t + BENCH_BATCH <= opts.ticks; t += BENCH_BATCH) {
+		moveCars(h, phy, angles, speeds, opts.cars);
+
+		uint64_t start = timerNow();
+
+		for (int i = 0; i < BENCH_BATCH; i++) {
+			proximityUpdate(p, phy, h);
+		}
+
+		statsStage(&stats, STAGE_PROXIMITY, start);
+		found += p->count;
+		mismatches += p->count != expectedCount(h);
+	}
+
+	const Histogram* s = &stats.stages[STAGE_PROXIMITY];
+
+	printf("%d cars, %llu ticks, %.1f cars within %.0f m per tick\n",
+		opts.cars, (unsigned long long) s->count * BENCH_BATCH,
+		(double) found / (double) s->count, PROXIMITY_RADIUS);
+
+	// microseconds per batch are nanoseconds per tick scaled by the batch
+	printf("  proximity: mean=%.0fns p50=%.0fns p99=%.0fns max=%.0fns per tick\n",
+		(double) s->sum / (double) s->count * 1000.0 / BENCH_BATCH,
+		(double) histogramPercentile(s, 0.5) * 1000.0 / BENCH_BATCH,
+		(double) histogramPercentile(s, 0.99) * 1000.0 / BENCH_BATCH,
+		(double) s->max * 1000.0 / BENCH_BATCH);
+
+	if (mismatches) {
+		printf("  %d batches found different cars to the expected count\n", mismatches);
+	}
+
+	freeProximity(p);
+	free(h);
+	free(phy);
+
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
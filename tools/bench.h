@@ -0,0 +1,26 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "proximity.h"
+#include "timer.h"
+#include "stats.h"
+
+// default simulated ticks
+#define BENCH_TICKS 1000000
+
+// ticks timed together since a single update is well below the timer's
+// microsecond resolution
+#define BENCH_BATCH 1000
+
+// radius (metres) of the circular track the cars are spread around
+#define BENCH_TRACK_RADIUS 700.0f
+
+/**
+ * Command line options.
+ */
+struct benchOptions {
+	int ticks;
+	int cars;
+};
+
+#endif
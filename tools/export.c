@@ -0,0 +1,111 @@
+#include "export.h"
+
+/**
+ * Append a row for every frame of a recording.
+ * @param  b
+ * @param  path
+ * @return      Zero on success or an error code defined in error.h.
+ */
+static int exportFile(ColBuilder* b, const char* path) {
+	RecReader* r;
+	int error = recOpen(path, &r);
+
+	if (error != 0) {
+		return error;
+	}
+
+	const RecHeader* h = recHeader(r);
+	RecFrame f;
+
+	// segments are stitched together on the first segment's clock
+	uint64_t base = h->start >= b->start ? (h->start - b->start) / 10 : 0;
+
+	while (recNextFrame(r, &f)) {
+		if (!colAppend(b, base + f.time, f.physics, f.hud)) {
+			recClose(r);
+
+			return ARE_OUT_OF_MEM;
+		}
+	}
+
+	if (r->corrupt) {
+		printf("%s: stopped at a corrupt block\n", path);
+	}
+
+	recClose(r);
+
+	return 0;
+}
+
+/**
+ * Start time of the first recording.
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int firstStart(const char* path, uint64_t* start) {
+	RecReader* r;
+	int error = recOpen(path, &r);
+
+	if (error == 0) {
+		*start = recHeader(r)->start;
+		recClose(r);
+	}
+
+	return error;
+}
+
+/**
+ * Export the segments of a recording to a single column file.
+ */
+int main(int argc, char** argv) {
+	uint64_t start;
+
+	if (argc < 3) {
+		printf("usage: are_export <out.col> <recording.rec>...\n");
+
+		return EXIT_FAILURE;
+	}
+
+	recInit();
+
+	int error = firstStart(argv[2], &start);
+
+	if (error != 0) {
+		printf("%s: %ls\n", argv[2], errorToWstr(error));
+
+		return EXIT_FAILURE;
+	}
+
+	ColBuilder* b = createColBuilder(start);
+
+	if (!b) {
+		printf("%ls\n", errorToWstr(ARE_OUT_OF_MEM));
+
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 2; i < argc; i++) {
+		error = exportFile(b, argv[i]);
+
+		if (error != 0) {
+			printf("%s: %ls\n", argv[i], errorToWstr(error));
+			freeColBuilder(b);
+
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE* out = fopen(argv[1], "wb");
+	bool written = out && colWrite(b, out);
+
+	written = out && fclose(out) == 0 && written;
+
+	if (written) {
+		printf("%s: %llu rows, %d columns\n", argv[1], (unsigned long long) b->rows, COLUMN_COUNT);
+	} else {
+		printf("%s: %ls\n", argv[1], errorToWstr(ARE_FILE));
+	}
+
+	freeColBuilder(b);
+
+	return written ? EXIT_SUCCESS : EXIT_FAILURE;
+}
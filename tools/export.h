@@ -0,0 +1,6 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "columns.h"
+
+#endif
@@ -0,0 +1,117 @@
+#include "index.h"
+
+/**
+ * Scan the frames of a recording and build its index.
+ * @param  r
+ * @param  ix
+ * @param  end Set to where the index should be written: after the last
+ *             complete frame.
+ * @return     False if out of memory.
+ */
+static bool scan(RecReader* r, RecIndexer* ix, uint64_t* end) {
+	RecFrame f;
+
+	while (recNextFrame(r, &f)) {
+		if (!recIndexFrame(ix, f.hud, &f.at)) {
+			return false;
+		}
+	}
+
+	// a frame cut short by a crash is dropped along with any damaged blocks
+	*end = r->complete;
+
+	return true;
+}
+
+/**
+ * Append an index to a recording, replacing the existing one if force is set.
+ * A recording whose end was damaged by a crash is truncated to its last
+ * complete frame first.
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int indexFile(const char* path, bool force) {
+	RecReader* r;
+	RecIndexer ix = {0};
+	uint64_t end;
+	int error = recOpen(path, &r);
+
+	if (error != 0) {
+		return error;
+	}
+
+	if (r->index && !force) {
+		printf("%s: already indexed (%zu entries)\n", path, r->indexCount);
+		recClose(r);
+
+		return 0;
+	}
+
+	bool scanned = scan(r, &ix, &end);
+	bool corrupt = r->corrupt;
+
+	// the mapping must be gone before the file can be truncated
+	recClose(r);
+
+	if (!scanned) {
+		recIndexFree(&ix);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	FILE* f = fopen(path, "r+b");
+
+	if (!f) {
+		recIndexFree(&ix);
+
+		return ARE_FILE;
+	}
+
+	bool written = _chsize_s(_fileno(f), (long long) end) == 0 &&
+		_fseeki64(f, (long long) end, SEEK_SET) == 0 &&
+		recWriteIndex(f, &ix, end);
+
+	written = (fclose(f) == 0) && written;
+
+	if (written) {
+		printf("%s: %zu entries%s\n", path, ix.count, corrupt ? ", damaged end truncated" : "");
+	}
+
+	recIndexFree(&ix);
+
+	return written ? 0 : ARE_FILE;
+}
+
+/**
+ * Add a lap, sector, and pit index to recordings that were not closed cleanly.
+ */
+int main(int argc, char** argv) {
+	bool force = false;
+	int failed = 0;
+	int files = 0;
+
+	recInit();
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-f") == 0) {
+			force = true;
+			continue;
+		}
+
+		int error = indexFile(argv[i], force);
+
+		if (error != 0) {
+			printf("%s: %ls\n", argv[i], errorToWstr(error));
+			failed++;
+		}
+
+		files++;
+	}
+
+	if (files == 0) {
+		printf("usage: are_index [-f] <recording.rec>...\n  -f  rebuild existing indexes\n");
+
+		return EXIT_FAILURE;
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
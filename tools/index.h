@@ -0,0 +1,6 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include "recording.h"
+
+#endif
@@ -0,0 +1,586 @@
+#include "replay.h"
+
+/**
+ * Print the command line usage.
+ */
+static void usage() {
+	printf(
+		"usage: are_replay [options] <recording.rec | data.json>\n"
+		"  -c <channel>   channel id (default: replay); numbered when -n > 1\n"
+		"  -p <password>  channel password (default: empty)\n"
+		"  -u <url>       API URL (default: %s)\n"
+		"  -n <count>     concurrent publishers (default: 1)\n"
+		"  -x <speed>     multiple of the recorded rate, 0 for as fast as possible (default: 1)\n"
+		"  -d             build the JSON without publishing it\n",
+		API_URL
+	);
+}
+
+/**
+ * Parse the command line.
+ * @return False if the arguments are invalid.
+ */
+static bool parseOptions(struct replayOptions* o, int argc, char** argv) {
+	o->path = NULL;
+	o->channel = "replay";
+	o->password = "";
+	o->url = API_URL;
+	o->publishers = 1;
+	o->speed = 1.0;
+	o->dryRun = false;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (strcmp(arg, "-d") == 0) {
+			o->dryRun = true;
+		} else if (arg[0] == '-' && arg[1] && !arg[2] && value) {
+			switch (arg[1]) {
+			case 'c':
+				o->channel = value;
+				break;
+			case 'p':
+				o->password = value;
+				break;
+			case 'u':
+				o->url = value;
+				break;
+			case 'n':
+				o->publishers = atoi(value);
+				break;
+			case 'x':
+				o->speed = atof(value);
+				break;
+			default:
+				return false;
+			}
+
+			i++;
+		} else if (arg[0] != '-' && !o->path) {
+			o->path = arg;
+		} else {
+			return false;
+		}
+	}
+
+	return o->path && o->publishers > 0 && o->speed >= 0.0;
+}
+
+/**
+ * Read a data.json array (as written by RECORD_DATA before the binary format)
+ * and serialise each broadcast once.
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int loadBodies(struct replaySource* src, const char* path) {
+	FILE* f = fopen(path, "rb");
+
+	if (!f) {
+		return ARE_FILE;
+	}
+
+	fseek(f, 0, SEEK_END);
+
+	long size = ftell(f);
+	char* text = malloc((size_t) size + 1);
+
+	fseek(f, 0, SEEK_SET);
+
+	if (!text) {
+		fclose(f);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	size_t read = fread(text, 1, (size_t) size, f);
+
+	fclose(f);
+	text[read] = '\0';
+
+	cJSON* array = cJSON_Parse(text);
+
+	free(text);
+
+	if (!cJSON_IsArray(array)) {
+		cJSON_Delete(array);
+
+		return ARE_RECORDING;
+	}
+
+	src->bodyCount = (size_t) cJSON_GetArraySize(array);
+	src->bodies = calloc(src->bodyCount ? src->bodyCount : 1, sizeof(*src->bodies));
+
+	if (!src->bodies) {
+		cJSON_Delete(array);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	size_t i = 0;
+	const cJSON* item;
+
+	cJSON_ArrayForEach(item, array) {
+		src->bodies[i] = cJSON_PrintUnformatted(item);
+
+		if (!src->bodies[i++]) {
+			cJSON_Delete(array);
+
+			return ARE_OUT_OF_MEM;
+		}
+	}
+
+	cJSON_Delete(array);
+
+	return 0;
+}
+
+/**
+ * Free everything loaded by loadSource().
+ */
+static void freeSource(struct replaySource* src) {
+	recClose(src->reader);
+
+	for (size_t i = 0; src->bodies && i < src->bodyCount; i++) {
+		cJSON_free(src->bodies[i]);
+	}
+
+	free(src->bodies);
+	freeCars(src->cars);
+}
+
+/**
+ * Open a raw recording, or a JSON array if path ends in ".json".
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int loadSource(struct replaySource* src, const char* path) {
+	size_t len = strlen(path);
+
+	src->reader = NULL;
+	src->bodies = NULL;
+	src->bodyCount = 0;
+	src->cars = NULL;
+
+	if (len > 5 && strcmp(path + len - 5, ".json") == 0) {
+		return loadBodies(src, path);
+	}
+
+	wchar_t carsPath[EXE_PATH_SIZE];
+
+	if (!exeRelativePath(carsPath, EXE_PATH_SIZE, CARS_FILE)) {
+		return ARE_FILE;
+	}
+
+	int error = loadCars(carsPath, &src->cars);
+
+	if (error != 0) {
+		return error;
+	}
+
+	return recOpen(path, &src->reader);
+}
+
+/**
+ * Free a publisher's frame copies, context, and curl handle.
+ */
+static void freePublisher(Publisher* p) {
+	free(p->sm.curr.physics);
+	free(p->sm.curr.hud);
+	free(p->sm.curr.props);
+	free(p->sm.prev.physics);
+	free(p->sm.prev.hud);
+	free(p->sm.prev.props);
+	freeArena(p->arena);
+	freeSession(p->session);
+	freeTracked(p->tracked);
+	curl_easy_cleanup(p->curl);
+	curl_slist_free_all(p->headers);
+}
+
+/**
+ * Allocate a publisher's frame copies and context and prepare its curl handle.
+ * Runs on the publisher's thread.
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int initPublisher(Publisher* p) {
+	// the frames are zeroed so the first delta compares against nothing
+	p->sm.szPhysics = sizeof(Physics);
+	p->sm.szHud = sizeof(HUD);
+	p->sm.szProps = sizeof(Properties);
+	p->sm.retries = 0;
+	p->sm.curr.physics = calloc(1, sizeof(Physics));
+	p->sm.curr.hud = calloc(1, sizeof(HUD));
+	p->sm.curr.props = calloc(1, sizeof(Properties));
+	p->sm.prev.physics = calloc(1, sizeof(Physics));
+	p->sm.prev.hud = calloc(1, sizeof(HUD));
+	p->sm.prev.props = calloc(1, sizeof(Properties));
+	p->tracked = createTracked(DEFAULT_SECTOR_COUNT);
+	p->session = createSession(p->src->cars);
+	p->arena = createArena(ARENA_INIT_SIZE);
+	p->curl = curl_easy_init();
+	p->headers = NULL;
+	fieldsDefault(&p->encoding);
+	statsReset(&p->stats);
+
+	if (!p->sm.curr.physics || !p->sm.curr.hud || !p->sm.curr.props ||
+		!p->sm.prev.physics || !p->sm.prev.hud || !p->sm.prev.props ||
+		!p->tracked || !p->session || !p->arena) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	if (!p->curl) {
+		return ARE_CURL;
+	}
+
+#ifdef CURL_SKIP_VERIFY
+	curl_easy_setopt(p->curl, CURLOPT_SSL_VERIFYPEER, 0L);
+#endif
+
+	char* pwHeader = createPasswordHeader(p->opts->password);
+
+	if (!pwHeader) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	p->headers = publishInit(p->curl, p->opts->url, p->channel, pwHeader);
+	free(pwHeader);
+
+	return p->headers ? 0 : ARE_OUT_OF_MEM;
+}
+
+/**
+ * Sleep until time (microseconds into the recording) is due at the chosen speed.
+ */
+static void waitFor(const Publisher* p, uint64_t time) {
+	if (p->opts->speed == 0.0) {
+		return;
+	}
+
+	uint64_t due = p->start + (uint64_t) ((double) time / p->opts->speed);
+
+	for (uint64_t now = timerNow(); now < due; now = timerNow()) {
+		uint64_t ms = (due - now) / 1000;
+
+		Sleep((DWORD) (ms < REPLAY_MAX_WAIT ? ms : REPLAY_MAX_WAIT));
+	}
+}
+
+/**
+ * Publish a body and count the result.
+ * @return True if the server changed the encoding and the next frame should be complete.
+ */
+static bool publishBody(Publisher* p, const char* json, uint64_t now) {
+	size_t len = strlen(json);
+
+	p->bytes += len;
+
+	if (p->opts->dryRun) {
+		trackedPublished(p->tracked);
+
+		return false;
+	}
+
+	cJSON* reply = NULL;
+	int result = publish(p->curl, json, &reply);
+
+	statsStage(&p->stats, STAGE_PUBLISH, now);
+
+	if (result >= ARE_ERROR_FIRST && result < ARE_ERROR_FIRST + ARE_ERROR_COUNT) {
+		p->failures[result - ARE_ERROR_FIRST]++;
+	} else if (result == 0) {
+		// a failed frame's lap results go out again with the next one
+		trackedPublished(p->tracked);
+	}
+
+	bool resend = false;
+
+	if (reply) {
+		resend = replyApply(reply, &p->encoding, p->tracked->reference);
+		cJSON_Delete(reply);
+	}
+
+	return resend;
+}
+
+/**
+ * Build and publish a frame the same way the processing thread does.
+ * @return Zero on success or ARE_OUT_OF_MEM.
+ */
+static int tick(Publisher* p, bool* complete) {
+	if (!physicsIsInCar(p->sm.curr.physics)) {
+		*complete = true;
+
+		return 0;
+	}
+
+	if (!sessionUpdate(p->session, p->sm.curr.props)) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	if ((*complete || p->session->updated) && !setSectorCount(p->tracked, p->session->sectorCount)) {
+		return ARE_OUT_OF_MEM;
+	}
+
+	if ((*complete || p->session->updated) && p->session->track) {
+		trackMapSetTrack(p->tracked->map, p->session->track);
+	}
+
+	allocUseArena(p->arena);
+
+	uint64_t start = timerNow();
+
+	// recordings hold one frame per broadcast, so the lap engines are fed
+	// at SAMPLE_RATE rather than LAP_RATE
+	if (!trackedSample(p->tracked, p->sm.curr.physics, p->sm.curr.hud)) {
+		allocUseArena(NULL);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	uint64_t now = statsStage(&p->stats, STAGE_LAPS, start);
+
+	proximityUpdate(p->tracked->proximity, p->sm.curr.physics, p->sm.curr.hud);
+	now = statsStage(&p->stats, STAGE_PROXIMITY, now);
+
+	char* json = deltaJSON(&p->sm, p->tracked, p->session, *complete);
+	now = statsStage(&p->stats, STAGE_DELTA, now);
+
+	if (!json) {
+		allocUseArena(NULL);
+
+		return ARE_OUT_OF_MEM;
+	}
+
+	*complete = publishBody(p, json, now);
+	cJSON_free(json);
+	allocUseArena(NULL);
+
+	sharedMemCurrToPrev(&p->sm);
+	arenaReset(p->arena);
+	p->stats.ticks++;
+
+	return 0;
+}
+
+/**
+ * Feed every frame of the recording through deltaJSON() and publish().
+ * @return Zero on success or an error code defined in error.h.
+ */
+static int replayRecording(Publisher* p) {
+	// a private cursor over the shared mapping that decodes packed blocks
+	// into its own buffers
+	RecReader reader = *p->src->reader;
+	RecFrame f;
+	bool complete = true;
+	bool first = true;
+	uint64_t base = 0;
+	int error = 0;
+
+	reader.packPhysics = NULL;
+	reader.packHud = NULL;
+	recRewind(&reader);
+
+	while (error == 0 && recNextFrame(&reader, &f)) {
+		if (f.propsChanged) {
+			memcpy(p->sm.curr.props, f.props, sizeof(Properties));
+		}
+
+		memcpy(p->sm.curr.physics, f.physics, sizeof(Physics));
+		memcpy(p->sm.curr.hud, f.hud, sizeof(HUD));
+
+		if (first) {
+			base = f.time;
+			first = false;
+		}
+
+		waitFor(p, f.time - base);
+		error = tick(p, &complete);
+	}
+
+	if (reader.corrupt) {
+		printf("%s: stopped at a corrupt block\n", p->channel);
+	}
+
+	free(reader.packPhysics);
+	free(reader.packHud);
+
+	return error;
+}
+
+/**
+ * Publish each recorded broadcast as is, one sample period apart.
+ * @return Zero.
+ */
+static int replayBodies(Publisher* p) {
+	for (size_t i = 0; i < p->src->bodyCount; i++) {
+		waitFor(p, (uint64_t) i * REPLAY_PERIOD);
+		publishBody(p, p->src->bodies[i], timerNow());
+		p->stats.ticks++;
+	}
+
+	return 0;
+}
+
+/**
+ * Publisher thread. Implements ThreadProc.
+ * @param  arg Cast to Publisher*
+ * @return     Zero.
+ */
+static DWORD WINAPI publisherProc(void* arg) {
+	Publisher* p = (Publisher*) arg;
+
+	TRACE_THREAD(p->channel);
+
+	p->error = initPublisher(p);
+
+	if (p->error == 0) {
+		fieldsUse(&p->encoding);
+		p->start = timerNow();
+		p->error = p->src->reader ? replayRecording(p) : replayBodies(p);
+		fieldsUse(NULL);
+	}
+
+	freePublisher(p);
+
+	return 0;
+}
+
+/**
+ * Print the combined throughput, latencies, and failures of every publisher.
+ * @param ps
+ * @param count
+ * @param elapsed Microseconds from the first start to the last finish.
+ */
+static void report(const Publisher* ps, int count, uint64_t elapsed) {
+	LoopStats total;
+	uint64_t bytes = 0;
+	uint64_t failed = 0;
+	uint64_t failures[ARE_ERROR_COUNT] = {0};
+
+	statsReset(&total);
+
+	for (int i = 0; i < count; i++) {
+		const Publisher* p = &ps[i];
+
+		if (p->error != 0) {
+			printf("%s: %ls\n", p->channel, errorToWstr(p->error));
+		}
+
+		total.ticks += p->stats.ticks;
+		bytes += p->bytes;
+		histogramMerge(&total.stages[STAGE_LAPS], &p->stats.stages[STAGE_LAPS]);
+		histogramMerge(&total.stages[STAGE_PROXIMITY], &p->stats.stages[STAGE_PROXIMITY]);
+		histogramMerge(&total.stages[STAGE_DELTA], &p->stats.stages[STAGE_DELTA]);
+		histogramMerge(&total.stages[STAGE_PUBLISH], &p->stats.stages[STAGE_PUBLISH]);
+
+		for (int j = 0; j < ARE_ERROR_COUNT; j++) {
+			failures[j] += p->failures[j];
+			failed += p->failures[j];
+		}
+	}
+
+	double seconds = (double) elapsed / 1e6;
+	uint64_t sent = total.stages[STAGE_PUBLISH].count;
+
+	printf("%d publishers, %llu frames in %.2fs: %.1f frames/s, %.2f MB/s\n",
+		count, (unsigned long long) total.ticks, seconds,
+		seconds > 0 ? (double) total.ticks / seconds : 0.0,
+		seconds > 0 ? (double) bytes / seconds / 1e6 : 0.0);
+
+	printf("%llu published, %llu failed (%.2f%%)\n",
+		(unsigned long long) (sent - failed), (unsigned long long) failed,
+		sent ? 100.0 * (double) failed / (double) sent : 0.0);
+
+	for (int j = 0; j < ARE_ERROR_COUNT; j++) {
+		if (failures[j]) {
+			printf("  %ls: %llu\n", errorToWstr(ARE_ERROR_FIRST + j), (unsigned long long) failures[j]);
+		}
+	}
+
+	statsPrint(&total);
+}
+
+/**
+ * Replay a recording through the publishing path with many virtual publishers
+ * and report the throughput and error rates.
+ */
+int main(int argc, char** argv) {
+	struct replayOptions opts;
+	struct replaySource src;
+
+	if (!parseOptions(&opts, argc, argv)) {
+		usage();
+
+		return EXIT_FAILURE;
+	}
+
+	allocInit();
+	fieldsInit();
+	recInit();
+
+	if (!dictInit() || curl_global_init(CURL_GLOBAL_DEFAULT) != 0) {
+		printf("Initialisation failed\n");
+
+		return EXIT_FAILURE;
+	}
+
+	int error = loadSource(&src, opts.path);
+
+	if (error != 0) {
+		printf("%s: %ls\n", opts.path, errorToWstr(error));
+		freeSource(&src);
+		curl_global_cleanup();
+		dictFree();
+
+		return EXIT_FAILURE;
+	}
+
+	Publisher* ps = calloc((size_t) opts.publishers, sizeof(*ps));
+
+	if (!ps) {
+		printf("%ls\n", errorToWstr(ARE_OUT_OF_MEM));
+		freeSource(&src);
+		curl_global_cleanup();
+		dictFree();
+
+		return EXIT_FAILURE;
+	}
+
+	uint64_t start = timerNow();
+	int started = 0;
+
+	for (int i = 0; i < opts.publishers; i++) {
+		Publisher* p = &ps[i];
+
+		p->opts = &opts;
+		p->src = &src;
+
+		if (opts.publishers == 1) {
+			snprintf(p->channel, sizeof(p->channel), "%s", opts.channel);
+		} else {
+			snprintf(p->channel, sizeof(p->channel), "%s%d", opts.channel, i + 1);
+		}
+
+		p->thread = CreateThread(NULL, 0, &publisherProc, p, 0, NULL);
+
+		if (!p->thread) {
+			printf("%s: %ls\n", p->channel, errorToWstr(ARE_THREAD));
+			break;
+		}
+
+		started++;
+	}
+
+	for (int i = 0; i < started; i++) {
+		WaitForSingleObject(ps[i].thread, INFINITE);
+		CloseHandle(ps[i].thread);
+	}
+
+	report(ps, started, timerNow() - start);
+
+	free(ps);
+	freeSource(&src);
+	curl_global_cleanup();
+	dictFree();
+
+	return started == opts.publishers ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "api.h"
+#include "reply.h"
+#include "delta.h"
+#include "stats.h"
+#include "recording.h"
+
+// channel ids are <channel><publisher number> when there is more than one publisher
+#define REPLAY_CHANNEL_SIZE 128
+
+// recorded broadcasts carry no time stamps so they are spaced by the sample period
+#define REPLAY_PERIOD (1000000 / SAMPLE_RATE)
+
+// longest single wait between frames (milliseconds) so very slow speeds
+// still notice the end of a frame
+#define REPLAY_MAX_WAIT 1000
+
+/**
+ * Command line options.
+ */
+struct replayOptions {
+	const char* path;
+	const char* channel;
+	const char* password;
+	const char* url;
+
+	// concurrent virtual publishers
+	int publishers;
+
+	// multiple of the recorded rate or zero for as fast as possible
+	double speed;
+
+	// build the JSON without publishing it
+	bool dryRun;
+};
+
+/**
+ * A recording or a JSON array of recorded broadcasts shared read only by
+ * every publisher.
+ */
+struct replaySource {
+	// raw frame recording
+	RecReader* reader;
+
+	// pre-serialised broadcasts from a data.json array
+	char** bodies;
+	size_t bodyCount;
+
+	CarTable* cars;
+};
+
+/**
+ * One virtual publisher. Each has its own frame copies, sector tracking,
+ * session context, curl handle, and arena.
+ */
+typedef struct publisher {
+	const struct replayOptions* opts;
+	const struct replaySource* src;
+	char channel[REPLAY_CHANNEL_SIZE];
+	HANDLE thread;
+
+	CURL* curl;
+	struct curl_slist* headers;
+	SharedMem sm;
+	Tracked* tracked;
+	Session* session;
+	Arena* arena;
+	Encoding encoding;
+
+	// timerNow() when publishing started
+	uint64_t start;
+
+	// results; STAGE_LAPS, STAGE_PROXIMITY, STAGE_DELTA, and STAGE_PUBLISH are recorded
+	LoopStats stats;
+	uint64_t bytes;
+	uint64_t failures[ARE_ERROR_COUNT];
+	int error;
+} Publisher;
+
+#endif
@@ -0,0 +1,261 @@
+#include "tracing.h"
+
+// a completed span
+struct event {
+	const char* name;
+	uint64_t start;
+	uint64_t duration;
+};
+
+/**
+ * Single producer, single consumer ring of events. The owning thread only
+ * advances head and the flusher thread only advances tail, so neither side
+ * needs a lock.
+ */
+struct buffer {
+	DWORD tid;
+
+	// set by traceThread(); written out once as trace metadata
+	const char* name;
+	bool named;
+
+	volatile LONG head;
+	volatile LONG tail;
+
+	// events lost because the ring was full
+	volatile LONG dropped;
+
+	struct event events[TRACE_BUFFER_SIZE];
+};
+
+// everything owned by the flusher
+static struct {
+	FILE* out;
+	HANDLE thread;
+	HANDLE stop;
+	bool first;
+	volatile LONG running;
+	volatile LONG count;
+	struct buffer* buffers[TRACE_MAX_THREADS];
+} trace;
+
+// the calling thread's buffer (allocated on its first event)
+static __declspec(thread) struct buffer* local = NULL;
+
+/**
+ * Get the calling thread's buffer, registering a new one if required.
+ * @return NULL if tracing isn't running, too many threads are registered,
+ *         or out of memory.
+ */
+static struct buffer* localBuffer() {
+	if (local || !trace.running) {
+		return local;
+	}
+
+	struct buffer* b = calloc(1, sizeof(*b));
+
+	if (!b) {
+		return NULL;
+	}
+
+	LONG slot = InterlockedIncrement(&trace.count) - 1;
+
+	if (slot >= TRACE_MAX_THREADS) {
+		free(b);
+
+		return NULL;
+	}
+
+	b->tid = GetCurrentThreadId();
+
+	// make sure the buffer is initialised before the flusher can see it
+	MemoryBarrier();
+	trace.buffers[slot] = b;
+	local = b;
+
+	return b;
+}
+
+/**
+ * Write a single event as a trace event object.
+ */
+static void writeEvent(const char* fmt, ...) {
+	va_list argList;
+
+	fputs(trace.first ? "\n" : ",\n", trace.out);
+	trace.first = false;
+
+	va_start(argList, fmt);
+	vfprintf(trace.out, fmt, argList);
+	va_end(argList);
+}
+
+/**
+ * Drain every registered buffer into the trace file.
+ */
+static void flush() {
+	for (LONG i = 0; i < trace.count && i < TRACE_MAX_THREADS; i++) {
+		struct buffer* b = trace.buffers[i];
+
+		if (!b) {
+			// registered but not yet published
+			continue;
+		}
+
+		if (b->name && !b->named) {
+			writeEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,"
+				"\"args\":{\"name\":\"%s\"}}", b->tid, b->name);
+			b->named = true;
+		}
+
+		LONG head = b->head;
+
+		// read the events only after observing head
+		MemoryBarrier();
+
+		for (LONG t = b->tail; t != head; t++) {
+			struct event* e = &b->events[(ULONG) t % TRACE_BUFFER_SIZE];
+
+			writeEvent("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,"
+				"\"ts\":%llu,\"dur\":%llu}", e->name, b->tid,
+				(unsigned long long) e->start, (unsigned long long) e->duration);
+		}
+
+		InterlockedExchange(&b->tail, head);
+	}
+
+	fflush(trace.out);
+}
+
+/**
+ * Flusher thread. Implements ThreadProc.
+ */
+static DWORD WINAPI flushProc(void* arg) {
+	(void) arg;
+
+	while (WaitForSingleObject(trace.stop, TRACE_FLUSH_INTERVAL) == WAIT_TIMEOUT) {
+		flush();
+	}
+
+	return 0;
+}
+
+/**
+ * Open the trace file and start the background flusher.
+ * @param  path Eg. "trace.json".
+ * @return      False if the file, event, or thread could not be created.
+ */
+bool traceStart(const char* path) {
+	trace.out = fopen(path, "wb");
+
+	if (!trace.out) {
+		return false;
+	}
+
+	trace.stop = CreateEventW(NULL, true, false, NULL);
+
+	if (!trace.stop) {
+		fclose(trace.out);
+
+		return false;
+	}
+
+	// JSON array format understood by chrome://tracing and Perfetto
+	fputs("[", trace.out);
+	trace.first = true;
+	trace.count = 0;
+	trace.running = true;
+	trace.thread = CreateThread(NULL, 0, &flushProc, NULL, 0, NULL);
+
+	if (!trace.thread) {
+		trace.running = false;
+		CloseHandle(trace.stop);
+		fclose(trace.out);
+
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Name the calling thread in the trace viewer.
+ * @param name String literal.
+ */
+void traceThread(const char* name) {
+	struct buffer* b = localBuffer();
+
+	if (b) {
+		b->name = name;
+	}
+}
+
+/**
+ * Open a span on the calling thread.
+ * @param  name String literal.
+ */
+TraceSpan traceBegin(const char* name) {
+	TraceSpan s = {name, timerNow()};
+
+	return s;
+}
+
+/**
+ * Close a span and queue it for the flusher.
+ * @param s
+ */
+void traceEnd(TraceSpan s) {
+	struct buffer* b = localBuffer();
+
+	if (!b) {
+		return;
+	}
+
+	LONG head = b->head;
+
+	if (head - b->tail >= TRACE_BUFFER_SIZE) {
+		// the flusher has fallen behind
+		InterlockedIncrement(&b->dropped);
+
+		return;
+	}
+
+	struct event* e = &b->events[(ULONG) head % TRACE_BUFFER_SIZE];
+
+	e->name = s.name;
+	e->start = s.start;
+	e->duration = timerNow() - s.start;
+
+	// publish the event to the flusher
+	InterlockedExchange(&b->head, head + 1);
+}
+
+/**
+ * Stop the flusher, write any remaining events, and close the trace file.
+ * Buffers belonging to threads which are still running are left allocated
+ * since those threads may still hold a pointer to them.
+ */
+void traceStop() {
+	if (!trace.running) {
+		return;
+	}
+
+	trace.running = false;
+	SetEvent(trace.stop);
+	WaitForSingleObject(trace.thread, INFINITE);
+	CloseHandle(trace.thread);
+	CloseHandle(trace.stop);
+
+	// final drain now that the flusher has exited
+	flush();
+
+	for (LONG i = 0; i < trace.count && i < TRACE_MAX_THREADS; i++) {
+		if (trace.buffers[i] && trace.buffers[i]->dropped) {
+			printf("Trace: %ld events dropped on thread %lu\n",
+				trace.buffers[i]->dropped, trace.buffers[i]->tid);
+		}
+	}
+
+	fputs("\n]\n", trace.out);
+	fclose(trace.out);
+}
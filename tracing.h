@@ -0,0 +1,48 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <stdarg.h>
+
+#include "timer.h"
+
+// events each thread can buffer between flushes; further events are dropped
+#define TRACE_BUFFER_SIZE 4096
+
+// maximum number of threads that can emit events
+#define TRACE_MAX_THREADS 16
+
+// milliseconds between flushes to disk
+#define TRACE_FLUSH_INTERVAL 250
+
+/**
+ * Span helpers. Compiled out entirely unless TRACE is defined. C has no
+ * destructors so every TRACE_BEGIN needs a matching TRACE_END in the same
+ * scope; spans abandoned by an early return are simply never emitted.
+ * Example:
+ * TRACE_BEGIN(span, "deltaJSON");
+ * ...
+ * TRACE_END(span);
+ */
+#ifdef TRACE
+#define TRACE_THREAD(name) traceThread(name)
+#define TRACE_BEGIN(v, name) TraceSpan v = traceBegin(name)
+#define TRACE_END(v) traceEnd(v)
+#else
+#define TRACE_THREAD(name) ((void) 0)
+#define TRACE_BEGIN(v, name) ((void) 0)
+#define TRACE_END(v) ((void) 0)
+#endif
+
+// an open span. name must be a string literal (or otherwise outlive the trace)
+typedef struct traceSpan {
+	const char* name;
+	uint64_t start;
+} TraceSpan;
+
+bool traceStart(const char*);
+void traceThread(const char*);
+TraceSpan traceBegin(const char*);
+void traceEnd(TraceSpan);
+void traceStop();
+
+#endif
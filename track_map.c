@@ -0,0 +1,499 @@
+#include "track_map.h"
+
+// longest car entry of the positions array: id, fraction, and offset
+#define TRACK_MAP_CAR_WIDTH 40
+
+/**
+ * Allocate an empty track map on the heap.
+ * @return NULL if out of memory.
+ */
+TrackMap* createTrackMap() {
+	TrackMap* m = calloc(1, sizeof(*m));
+
+	if (!m) {
+		return NULL;
+	}
+
+	m->encoded = malloc(BASE64_LEN(sizeof(m->points)) + 1);
+	m->raw = malloc(TRACK_MAP_CARS * TRACK_MAP_CAR_WIDTH + 3);
+
+	if (!m->encoded || !m->raw) {
+		freeTrackMap(m);
+
+		return NULL;
+	}
+
+	return m;
+}
+
+/**
+ * Wait for the cache thread, if any, to exit.
+ * @param wait Milliseconds to wait.
+ * @return     False if it is still running.
+ */
+static bool ioJoin(TrackMap* m, DWORD wait) {
+	if (!m->io) {
+		return true;
+	}
+
+	if (WaitForSingleObject(m->io, wait) != WAIT_OBJECT_0) {
+		return false;
+	}
+
+	CloseHandle(m->io);
+	m->io = NULL;
+
+	return true;
+}
+
+/**
+ * Read the cached map into m->cache. Implements ThreadProc.
+ * @param  arg Cast to TrackMap*
+ */
+static DWORD WINAPI loadProc(void* arg) {
+	TrackMap* m = (TrackMap*) arg;
+	FILE* f = _wfopen(m->cachePath, L"rb");
+
+	if (!f) {
+		return 0;
+	}
+
+	TrackMapHeader header;
+	bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+		header.magic == TRACK_MAP_MAGIC &&
+		header.version == TRACK_MAP_VERSION &&
+		header.points == TRACK_MAP_POINTS &&
+		fread(m->cache, sizeof(m->cache), 1, f) == 1;
+
+	fclose(f);
+
+	if (!ok) {
+		printf("Ignoring malformed track map %ls\n", m->cachePath);
+
+		return 0;
+	}
+
+	m->cacheLaps = header.laps;
+	InterlockedExchange(&m->loaded, 1);
+
+	return 0;
+}
+
+/**
+ * Write m->cache to the cache. Implements ThreadProc. Failing to is logged
+ * rather than fatal since the map is only needed again next session.
+ * @param  arg Cast to TrackMap*
+ */
+static DWORD WINAPI saveProc(void* arg) {
+	TrackMap* m = (TrackMap*) arg;
+
+	// fails harmlessly if the directory already exists
+	CreateDirectoryW(m->dir, NULL);
+
+	FILE* f = _wfopen(m->cachePath, L"wb");
+	TrackMapHeader header = {TRACK_MAP_MAGIC, TRACK_MAP_VERSION, 0, TRACK_MAP_POINTS, m->cacheLaps};
+	bool ok = f &&
+		fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(m->cache, sizeof(m->cache), 1, f) == 1;
+
+	if (f && fclose(f) != 0) {
+		ok = false;
+	}
+
+	if (!ok) {
+		printf("Unable to cache the track map in %ls\n", m->cachePath);
+	}
+
+	return 0;
+}
+
+/**
+ * Start writing the map to the cache.
+ */
+static void save(TrackMap* m) {
+	// a read of this track has long finished by the time laps are learnt
+	if (!m->path[0] || !ioJoin(m, 0)) {
+		printf("Track map of %s not cached; the cache is busy\n", m->track);
+
+		return;
+	}
+
+	memcpy(m->cache, m->points, sizeof(m->cache));
+	m->cacheLaps = (uint32_t) m->laps;
+	memcpy(m->cacheTrack, m->track, sizeof(m->cacheTrack));
+	memcpy(m->cachePath, m->path, sizeof(m->cachePath));
+	m->io = CreateThread(NULL, 0, &saveProc, m, 0, NULL);
+
+	if (!m->io) {
+		printf("Track map of %s not cached; no thread\n", m->track);
+	}
+}
+
+/**
+ * Start reading the current track's map once the cache thread is free.
+ */
+static void load(TrackMap* m) {
+	if (!m->loadPending || !ioJoin(m, 0)) {
+		return;
+	}
+
+	m->loadPending = false;
+	m->loaded = 0;
+	memcpy(m->cacheTrack, m->track, sizeof(m->cacheTrack));
+	memcpy(m->cachePath, m->path, sizeof(m->cachePath));
+	m->io = CreateThread(NULL, 0, &loadProc, m, 0, NULL);
+}
+
+/**
+ * Use the map read from the cache once the thread reading it has finished.
+ * A map read for a track that has since been left is discarded.
+ */
+static void adopt(TrackMap* m) {
+	if (InterlockedCompareExchange(&m->loaded, 0, 1) != 1 || strcmp(m->cacheTrack, m->track) != 0) {
+		return;
+	}
+
+	memcpy(m->points, m->cache, sizeof(m->points));
+	m->laps = (int) m->cacheLaps;
+	m->ready = true;
+}
+
+/**
+ * Switch to the map of a track and start reading it from the cache if it has
+ * been driven before. Does nothing if the track is unchanged. Never waits for
+ * the cache thread: if it is still busy with the previous track the read
+ * starts from trackMapAdd() once it has finished.
+ * @param m
+ * @param track UTF-8 track name (Properties.track).
+ */
+void trackMapSetTrack(TrackMap* m, const char* track) {
+	char name[TRACK_MAP_NAME_LEN + 1];
+	size_t len = 0;
+
+	// anything other than letters, digits, '-', and '_' could escape the
+	// cache directory or be invalid in a file name
+	for (; track[len] && len < TRACK_MAP_NAME_LEN; len++) {
+		char c = track[len];
+		bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+
+		name[len] = safe ? c : '_';
+	}
+
+	name[len] = '\0';
+
+	if (strcmp(name, m->track) == 0) {
+		return;
+	}
+
+	memcpy(m->track, name, len + 1);
+	m->ready = false;
+	m->sent = false;
+	m->laps = 0;
+	m->started = false;
+	m->loadPending = false;
+	m->path[0] = L'\0';
+	memset(m->hints, 0, sizeof(m->hints));
+
+	if (len == 0) {
+		return;
+	}
+
+	wchar_t file[TRACK_MAP_NAME_LEN + 1];
+
+	mbstowcs(file, name, TRACK_MAP_NAME_LEN + 1);
+
+	// the directory is found once; a running save may be using it
+	if (!m->dir[0] && !exeRelativePath(m->dir, EXE_PATH_SIZE, TRACK_MAP_DIR)) {
+		// learnt every session instead
+		m->dir[0] = L'\0';
+
+		return;
+	}
+
+	if (swprintf(m->path, EXE_PATH_SIZE, L"%ls\\%ls.map", m->dir, file) < 0) {
+		m->path[0] = L'\0';
+
+		return;
+	}
+
+	m->loadPending = true;
+	load(m);
+}
+
+/**
+ * Coordinates of the player's car or NULL if it is not in the list.
+ */
+static const float* playerCoords(const HUD* h) {
+	int count = h->activeCars < TRACK_MAP_CARS ? h->activeCars : TRACK_MAP_CARS;
+
+	for (int i = 0; i < count; i++) {
+		if (h->carID[i] == h->playerCarID) {
+			return h->carCoordinates[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Start learning a lap from a sample. Only laps started at the line are
+ * complete.
+ */
+static void startLap(TrackMap* m, float pos, const float* c, bool atLine, bool clean) {
+	lapCursorStart(&m->cursor, TRACK_MAP_POINTS, pos, atLine);
+	m->clean = clean;
+	memcpy(m->prevCoords, c, sizeof(m->prevCoords));
+}
+
+/**
+ * Record every point between the last sample and pos (which is past 1 if
+ * the line was crossed) by interpolating between the samples either side.
+ */
+static void advance(TrackMap* m, float pos, const float* c) {
+	float f;
+
+	while (lapCursorCross(&m->cursor, pos, TRACK_MAP_POINTS, &f)) {
+		float* p = m->lap[m->cursor.point % TRACK_MAP_POINTS];
+
+		for (int i = 0; i < 3; i++) {
+			p[i] = m->prevCoords[i] + f * (c[i] - m->prevCoords[i]);
+		}
+	}
+}
+
+/**
+ * Average a lap into the map if it was clean and complete. The map is used
+ * and cached once TRACK_MAP_LAPS have been averaged.
+ */
+static void finishLap(TrackMap* m) {
+	if (!m->cursor.timed || !m->clean || m->cursor.point != TRACK_MAP_POINTS) {
+		return;
+	}
+
+	float w = 1.0f / (float) (m->laps + 1);
+
+	for (int i = 0; i < TRACK_MAP_POINTS; i++) {
+		for (int j = 0; j < 3; j++) {
+			m->points[i][j] += (m->lap[i][j] - m->points[i][j]) * w;
+		}
+	}
+
+	if (++m->laps >= TRACK_MAP_LAPS) {
+		m->ready = true;
+		save(m);
+	}
+}
+
+/**
+ * Learn the map from the player's coordinates until it is ready or has been
+ * read from the cache. A new session publishes the map again.
+ * @param m
+ * @param h
+ */
+void trackMapAdd(TrackMap* m, const HUD* h) {
+	adopt(m);
+	load(m);
+
+	if (h->sessionIndex != m->sessionIndex) {
+		m->sessionIndex = h->sessionIndex;
+		m->sent = false;
+		m->started = false;
+	}
+
+	if (m->ready || !m->track[0]) {
+		return;
+	}
+
+	const float* c = playerCoords(h);
+
+	if (!c) {
+		return;
+	}
+
+	float pos = h->normalizedCarPosition;
+	bool clean = h->isValidLap && !h->isInPitLane;
+
+	if (!m->started) {
+		m->started = true;
+		startLap(m, pos, c, false, clean);
+
+		return;
+	}
+
+	// crossing the line forwards continues past 1
+	float next;
+	enum lapStep step = lapCursorStep(&m->cursor, pos, &next);
+
+	if (step == LAP_STEP_SKIP) {
+		return;
+	}
+
+	advance(m, next, c);
+
+	if (step == LAP_STEP_LINE) {
+		finishLap(m);
+		startLap(m, pos, c, true, clean);
+	} else {
+		m->clean = m->clean && clean;
+		m->cursor.pos = pos;
+		memcpy(m->prevCoords, c, sizeof(m->prevCoords));
+	}
+}
+
+/**
+ * Find the segment nearest to c among count segments from first.
+ * @return Squared distance (metres) to the nearest point of the segment.
+ */
+static float nearest(const TrackMap* m, const float* c, int first, int count, int* seg, float* t) {
+	float best = INFINITY;
+
+	for (int k = 0; k < count; k++) {
+		int i = ((first + k) % TRACK_MAP_POINTS + TRACK_MAP_POINTS) % TRACK_MAP_POINTS;
+		const float* a = m->points[i];
+		const float* b = m->points[(i + 1) % TRACK_MAP_POINTS];
+		float d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+		float len = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+		float u = len > 0.0f ? ((c[0] - a[0]) * d[0] + (c[1] - a[1]) * d[1] + (c[2] - a[2]) * d[2]) / len : 0.0f;
+
+		u = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+
+		float dist = 0.0f;
+
+		for (int j = 0; j < 3; j++) {
+			float e = c[j] - (a[j] + u * d[j]);
+
+			dist += e * e;
+		}
+
+		if (dist < best) {
+			best = dist;
+			*seg = i;
+			*t = u;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Locate a car on the map starting from where the car in its slot was
+ * last time.
+ * @param fraction Of the lap from the line, [0, 1).
+ * @param offset   From the centre line in metres; positive towards +x when
+ *                 travelling towards +z.
+ */
+static void locate(TrackMap* m, int slot, const float* c, float* fraction, float* offset) {
+	int seg = 0;
+	float t = 0.0f;
+	float dist = nearest(m, c, m->hints[slot] - TRACK_MAP_WINDOW, TRACK_MAP_WINDOW * 2 + 1, &seg, &t);
+
+	if (dist > TRACK_MAP_MAX_OFFSET * TRACK_MAP_MAX_OFFSET) {
+		dist = nearest(m, c, 0, TRACK_MAP_POINTS, &seg, &t);
+	}
+
+	m->hints[slot] = seg;
+
+	const float* a = m->points[seg];
+	const float* b = m->points[(seg + 1) % TRACK_MAP_POINTS];
+	float side = (b[2] - a[2]) * (c[0] - a[0]) - (b[0] - a[0]) * (c[2] - a[2]);
+
+	*fraction = ((float) seg + t) / TRACK_MAP_POINTS;
+	*fraction = *fraction < 1.0f ? *fraction : 0.0f;
+	*offset = copysignf(sqrtf(dist), side);
+}
+
+/**
+ * points, data.
+ */
+static cJSON* createMap(TrackMap* m) {
+	cJSON* obj = cJSON_CreateObject();
+
+	if (!obj) {
+		return NULL;
+	}
+
+	if (FIELD_ON(FLD_TRACK_MAP_POINTS)) {
+		INT_2_OBJ(obj, FIELD_KEY(FLD_TRACK_MAP_POINTS), TRACK_MAP_POINTS);
+	}
+
+	if (FIELD_ON(FLD_TRACK_MAP_DATA)) {
+		// little endian floats as they are in memory
+		base64Encode(m->encoded, (const uint8_t*) m->points, sizeof(m->points));
+
+		if (!cJSON_AddStringToObject(obj, FIELD_KEY(FLD_TRACK_MAP_DATA), m->encoded)) {
+			RET_NULL(obj);
+		}
+	}
+
+	return obj;
+}
+
+/**
+ * Add the map under "trackMap" once per session (and with complete data) and
+ * the position of every car along it under "carPositions".
+ * @param  parent
+ * @param  m
+ * @param  h
+ * @param  complete Set to true to send the map again.
+ * @return          NULL if out of memory (parent is deleted).
+ */
+cJSON* trackMapToJSON(cJSON* parent, TrackMap* m, const HUD* h, bool complete) {
+	if (!m->ready) {
+		return parent;
+	}
+
+	if (complete || !m->sent) {
+		m->sent = true;
+
+		if (fieldsAny(FLD_TRACK_MAP_POINTS, FLD_TRACK_MAP_DATA)) {
+			cJSON* obj = createMap(m);
+
+			if (!obj || !cJSON_AddItemToObject(parent, OBJECT_KEY(OBJ_TRACK_MAP), obj)) {
+				cJSON_Delete(obj);
+				RET_NULL(parent);
+			}
+		}
+	}
+
+	if (!FIELD_ON(FLD_CAR_POSITIONS)) {
+		return parent;
+	}
+
+	int count = h->activeCars < TRACK_MAP_CARS ? h->activeCars : TRACK_MAP_CARS;
+	size_t size = TRACK_MAP_CARS * TRACK_MAP_CAR_WIDTH + 3;
+	size_t len = 0;
+
+	// flat array of id, fraction, offset for each car
+	m->raw[len++] = '[';
+
+	for (int i = 0; i < count; i++) {
+		float fraction = 0.0f;
+		float offset = 0.0f;
+
+		locate(m, i, h->carCoordinates[i], &fraction, &offset);
+		len += snprintf(m->raw + len, size - len, i ? ",%d,%.4f,%.2f" : "%d,%.4f,%.2f", h->carID[i], fraction, offset);
+	}
+
+	snprintf(m->raw + len, size - len, "]");
+
+	if (!cJSON_AddRawToObject(parent, FIELD_KEY(FLD_CAR_POSITIONS), m->raw)) {
+		RET_NULL(parent);
+	}
+
+	return parent;
+}
+
+/**
+ * Free a track map. Does nothing if m is NULL.
+ */
+void freeTrackMap(TrackMap* m) {
+	if (!m) {
+		return;
+	}
+
+	// a map being written is finished rather than cut short
+	ioJoin(m, INFINITE);
+	free(m->encoded);
+	free(m->raw);
+	free(m);
+}
@@ -0,0 +1,110 @@
+#ifndef TRACK_MAP_H
+#define TRACK_MAP_H
+
+#include "auxiliary.h"
+#include "hud.h"
+#include "lap_cursor.h"
+
+// points of the centre line; point i is at normalizedCarPosition
+// i / TRACK_MAP_POINTS and the last point joins the first
+#define TRACK_MAP_POINTS 500
+
+// clean laps averaged before a map is used and cached
+#define TRACK_MAP_LAPS 2
+
+// cached maps are read from and written to this directory next to the
+// executable as <track>.map
+#define TRACK_MAP_DIR L"maps"
+
+// "AMAP" read as a little endian integer
+#define TRACK_MAP_MAGIC 0x50414D41
+#define TRACK_MAP_VERSION 1
+
+// longest track file name (excluding the terminator)
+#define TRACK_MAP_NAME_LEN 64
+
+// size of HUD.carCoordinates
+#define TRACK_MAP_CARS 60
+
+// segments either side of a car's last segment searched before falling back
+// to every segment
+#define TRACK_MAP_WINDOW 8
+
+// a car further than this (metres) from the nearest segment in its window
+// is searched for along the whole map
+#define TRACK_MAP_MAX_OFFSET 30.0f
+
+/**
+ * Start of a cached map, followed by TRACK_MAP_POINTS x, y, z floats.
+ */
+typedef struct trackMapHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t reserved;
+	uint32_t points;
+
+	// clean laps the map was averaged from
+	uint32_t laps;
+} TrackMapHeader;
+
+/**
+ * Centre line of the current track built from the player's coordinates over
+ * clean laps (or read from the cache) and the positions of every car along
+ * it as a fraction of the lap and a lateral offset. The cache is read and
+ * written on a short lived thread so that the sampling thread does no disk
+ * I/O.
+ */
+typedef struct trackMap {
+	// file name of the track the map is for; empty if there is none
+	char track[TRACK_MAP_NAME_LEN + 1];
+
+	float points[TRACK_MAP_POINTS][3];
+	bool ready;
+
+	// the map has been published this session
+	bool sent;
+	int sessionIndex;
+
+	// the lap being learnt up to the cursor and the clean laps averaged
+	float lap[TRACK_MAP_POINTS][3];
+	LapCursor cursor;
+	int laps;
+
+	// the lap was valid and outside the pit lane
+	bool clean;
+
+	// coordinates of the player's last usable sample
+	bool started;
+	float prevCoords[3];
+
+	// cache directory and file of the current track. The file is read once
+	// the thread is free if it was busy when the track changed
+	wchar_t dir[EXE_PATH_SIZE];
+	wchar_t path[EXE_PATH_SIZE];
+	bool loadPending;
+
+	// thread reading or writing the cache, and the map being read or
+	// written with its track and file; only touched by the thread until it
+	// exits. loaded is set once the thread has read a map into cache
+	HANDLE io;
+	float cache[TRACK_MAP_POINTS][3];
+	uint32_t cacheLaps;
+	char cacheTrack[TRACK_MAP_NAME_LEN + 1];
+	wchar_t cachePath[EXE_PATH_SIZE];
+	volatile LONG loaded;
+
+	// segment each car slot was nearest to at the last sample
+	int hints[TRACK_MAP_CARS];
+
+	// JSON scratch space for the map and the car positions
+	char* encoded;
+	char* raw;
+} TrackMap;
+
+TrackMap* createTrackMap();
+void trackMapSetTrack(TrackMap*, const char*);
+void trackMapAdd(TrackMap*, const HUD*);
+cJSON* trackMapToJSON(cJSON*, TrackMap*, const HUD*, bool);
+void freeTrackMap(TrackMap*);
+
+#endif
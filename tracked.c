@@ -5,7 +5,7 @@
  * @param  sectorCount The total number of sectors on the current circuit.
  */
 Tracked* createTracked(int sectorCount) {
-	Tracked* t = malloc(sizeof(*t));
+	Tracked* t = calloc(1, sizeof(*t));
 
 	if (!t) {
 		return NULL;
@@ -13,8 +13,13 @@ Tracked* createTracked(int sectorCount) {
 
 	t->sectorCount = sectorCount;
 	t->sectors = malloc(sizeof(int) * sectorCount);
+	t->mini = createMiniSectors(MINI_SECTOR_COUNT);
+	t->reference = createReference();
+	t->trace = createLapTrace();
+	t->map = createTrackMap();
+	t->proximity = createProximity();
 
-	if (!t->sectors) {
+	if (!t->sectors || !t->mini || !t->reference || !t->trace || !t->map || !t->proximity) {
 		freeTracked(t);
 
 		return NULL;
@@ -75,6 +80,57 @@ bool setSectorCount(Tracked* t, int sectorCount) {
 	return true;
 }
 
+/**
+ * Feed a sample to the lap summary, mini sectors, reference, trace, and
+ * track map. Called at LAP_RATE, between broadcasts as well as before each
+ * one, so laps are followed more closely than they are published. The
+ * completedLaps rollover completes the lap before the first sample of the
+ * next one is added; its results are published with the next broadcast.
+ * @param  t
+ * @param  p
+ * @param  h
+ * @return   False if out of memory.
+ */
+bool trackedSample(Tracked* t, const Physics* p, const HUD* h) {
+	if (t->sampled && h->completedLaps > t->sampledLaps) {
+		t->completed = t->lap;
+		t->completedTime = h->prevLapTime;
+		t->lapCompleted = t->lap.started;
+		lapSummaryReset(&t->lap);
+
+		// the last sample of the lap was still on it so its validity holds
+		miniSectorsFinish(t->mini, h->prevLapTime, t->sampledValid);
+		referenceFinish(t->reference, h->prevLapTime, t->sampledValid);
+
+		if (!lapTraceFinish(t->trace, h->completedLaps)) {
+			return false;
+		}
+	}
+
+	t->sampled = true;
+	t->sampledLaps = h->completedLaps;
+	t->sampledValid = h->isValidLap;
+
+	lapSummaryAdd(&t->lap, p, h);
+	miniSectorsAdd(t->mini, h);
+	referenceAdd(t->reference, h);
+	trackMapAdd(t->map, h);
+
+	return lapTraceAdd(t->trace, p, h);
+}
+
+/**
+ * Clear the results of the completed lap once a broadcast holding them has
+ * been published. Until then every broadcast carries them again, so a failed
+ * publish does not lose the lap.
+ * @param t
+ */
+void trackedPublished(Tracked* t) {
+	t->lapCompleted = false;
+	t->mini->lapCompleted = false;
+	t->trace->lapCompleted = false;
+}
+
 /**
  * Free the memory held by a tracked object.
  * @param t
@@ -85,5 +141,10 @@ void freeTracked(Tracked* t) {
 	}
 
 	free(t->sectors);
+	freeMiniSectors(t->mini);
+	freeReference(t->reference);
+	freeLapTrace(t->trace);
+	freeTrackMap(t->map);
+	freeProximity(t->proximity);
 	free(t);
 }
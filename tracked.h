@@ -4,17 +4,54 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+#include "lap_summary.h"
+#include "mini_sectors.h"
+#include "reference.h"
+#include "lap_trace.h"
+#include "track_map.h"
+#include "proximity.h"
+
 #define DEFAULT_SECTOR_COUNT 3
 
 typedef struct tracked {
 	int* sectors;
 	int sectorCount;
+
+	// accumulators of the lap being driven
+	LapSummary lap;
+
+	// the last lap completed and its time; lapCompleted is set until it is published
+	LapSummary completed;
+	int completedTime;
+	bool lapCompleted;
+
+	// splits of the lap finer than the game's sectors
+	MiniSectors* mini;
+
+	// laps the live delta is measured against
+	Reference* reference;
+
+	// speed, throttle, and brake of the lap being driven
+	LapTrace* trace;
+
+	// centre line of the track and the cars' positions along it
+	TrackMap* map;
+
+	// cars near the player; updated before each deltaJSON()
+	Proximity* proximity;
+
+	// completedLaps and isValidLap of the last sample fed to the lap engines
+	bool sampled;
+	int sampledLaps;
+	bool sampledValid;
 } Tracked;
 
 Tracked* createTracked(int);
 int addSector(Tracked*, int, int);
 void resetSectors(Tracked*);
 bool setSectorCount(Tracked*, int);
+bool trackedSample(Tracked*, const Physics*, const HUD*);
+void trackedPublished(Tracked*);
 void freeTracked(Tracked*);
 
 #endif